@@ -104,8 +104,8 @@ class ActionRingBuffer {
     byte ElementsNb(void) const { return _elementsCurrentNb; }
 
 
-    #ifdef ACTIONRINGBUFFER_STAT
-    // Return Stat information
+    #if defined(ACTIONRINGBUFFER_STAT) && !defined(KNX_NO_HEAP)
+    // Return Stat information (String uses the heap, not available with KNX_NO_HEAP)
     void Info(String& str)
     {
       str += "Elements Current Nb : " + String(_elementsCurrentNb,DEC);
@@ -0,0 +1,150 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : ActionSpscRingBuffer.h
+// Description : Lock free single producer / single consumer ring buffer
+//               The producer (e.g. an interrupt handler) and the consumer (e.g. the device task)
+//               can run concurrently without any lock :
+//               - only the producer writes the tail index, only the consumer writes the head index
+//               - the indexes are free running 16 bit counters, masked with (size-1) on access
+//               - the index loads/stores are atomic (interrupts masked on AVR, acquire/release elsewhere)
+//               Unlike ActionRingBuffer, a data appended in a full buffer is dropped (and counted as lost),
+//               the elements already queued are never modified by the producer
+// Module dependencies : none
+
+#ifndef ACTIONSPSCRINGBUFFER_H
+#define ACTIONSPSCRINGBUFFER_H
+
+#include "Arduino.h"
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+
+// The type of the contained elements and the ring buffer size are defined at compile time (template)
+// size shall be a power of 2, up to 32768 elements
+
+template<typename T, uint16_t size>
+class ActionSpscRingBuffer {
+    static_assert((size >= 2) && (size <= 32768) && !(size & (size - 1)), "ActionSpscRingBuffer size shall be a power of 2");
+
+     T _buffer[size];           // elements buffer
+     uint16_t _head;            // index of the oldest element, written by the consumer only
+     uint16_t _tail;            // index of the next appended element, written by the producer only
+     uint16_t _elementsMaxNb;   // high-water mark, written by the producer only
+     uint16_t _lostElementsNb;  // nb of elements dropped because the buffer was full (saturated), written by the producer only
+
+  public :
+
+    // Constructor
+    ActionSpscRingBuffer()
+    {
+      _head = 0;
+      _tail = 0;
+      _elementsMaxNb = 0;
+      _lostElementsNb = 0;
+    };
+
+
+    // PRODUCER SIDE
+    // Append a data in the buffer
+    // Return FALSE when the buffer is full (the data is dropped), otherwise TRUE
+    boolean Append(const T& appendedData)
+    {
+      uint16_t tail = _tail; // only the producer writes _tail, no need for an atomic load
+      uint16_t elementsNb = (uint16_t) (tail - Load(_head));
+      if (elementsNb >= size) {
+        if (_lostElementsNb != 0xFFFF) Store(_lostElementsNb, (uint16_t) (_lostElementsNb + 1)); // saturated counter
+        return false;
+      }
+      _buffer[tail & (size - 1)] = appendedData;
+      Store(_tail, (uint16_t) (tail + 1)); // publish the element once it is written
+      if (++elementsNb > _elementsMaxNb) Store(_elementsMaxNb, elementsNb);
+      return true;
+    }
+
+
+    // CONSUMER SIDE
+    // Pop a data from the buffer
+    // Return TRUE when a data is available, otherwise FALSE
+    boolean Pop(T& popData)
+    {
+      uint16_t head = _head; // only the consumer writes _head, no need for an atomic load
+      if (head == Load(_tail)) return false; // no data in the buffer
+      popData = _buffer[head & (size - 1)];
+      Store(_head, (uint16_t) (head + 1)); // release the slot once it is read
+      return true;
+    }
+
+
+    // CONSUMER SIDE
+    // Get the oldest data without removing it from the buffer
+    // Return TRUE when a data is available, otherwise FALSE
+    boolean Peek(T& peekData) const
+    {
+      uint16_t head = _head;
+      if (head == Load(_tail)) return false; // no data in the buffer
+      peekData = _buffer[head & (size - 1)];
+      return true;
+    }
+
+
+    // CONSUMER SIDE
+    // Remove all the elements
+    void Clear(void) { Store(_head, Load(_tail)); }
+
+
+    // Return TRUE when the buffer is empty
+    boolean IsEmpty(void) const { return Load(_head) == Load(_tail); }
+
+    // Return the current number of data elements in the ring buffer
+    uint16_t ElementsNb(void) const { return (uint16_t) (Load(_tail) - Load(_head)); }
+
+    // Return the max number of data elements the ring buffer can contain
+    uint16_t Capacity(void) const { return size; }
+
+    // Return the max number of data elements reached since the start
+    uint16_t ElementsMaxNb(void) const { return Load(_elementsMaxNb); }
+
+    // Return the nb of data elements dropped because the buffer was full (saturates at 65535)
+    uint16_t LostElementsNb(void) const { return Load(_lostElementsNb); }
+
+  private :
+
+#if defined(__AVR__)
+    // 16 bit accesses are not atomic on AVR, the interrupts are masked during the access
+    static uint16_t Load(const uint16_t& index)
+    {
+      uint16_t value;
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { value = *(const volatile uint16_t *) &index; }
+      return value;
+    }
+    static void Store(uint16_t& index, uint16_t value)
+    {
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { *(volatile uint16_t *) &index = value; }
+    }
+#else
+    static uint16_t Load(const uint16_t& index) { return __atomic_load_n(&index, __ATOMIC_ACQUIRE); }
+    static void Store(uint16_t& index, uint16_t value) { __atomic_store_n(&index, value, __ATOMIC_RELEASE); }
+#endif
+};
+
+#endif // ACTIONSPSCRINGBUFFER_H
@@ -28,6 +28,14 @@
 
 #include "KnxComObject.h"
 
+#ifdef KNX_NO_HEAP
+#pragma GCC poison malloc free realloc calloc
+
+word KnxComObject::_longValuesArenaUsedNb = 0;
+byte KnxComObject::_longValuesOverflow[KNX_TELEGRAM_PAYLOAD_MAX_SIZE - 1];
+boolean KnxComObject::_longValuesArenaOverflow = false;
+#endif
+
 // Data length is calculated in the same way as telegram payload length
 byte lengthCalculation(e_KnxDPT_ID dptId) {
 	return (pgm_read_byte(&KnxDPTFormatToLengthBit[ pgm_read_byte(&KnxDPTIdToFormat[dptId])] ) / 8) + 1;
@@ -44,9 +52,23 @@ KnxComObject::KnxComObject(e_KnxDPT_ID dptId, byte indicator )
 #endif
 {
     _active = false;
+    _txPending = 0;
+#ifdef KNX_STATS
+    ClearStats();
+#endif
 	if (_length <= 2) _longValue = NULL; // short value case
 	else { // long value case
+#ifdef KNX_NO_HEAP
+		if (_longValuesArenaUsedNb + _length - 1 <= _longValuesArenaSize) {
+			_longValue = &_longValuesArena[_longValuesArenaUsedNb];
+			_longValuesArenaUsedNb += _length - 1;
+		} else { // arena too small, KnxDevice::begin() will fail
+			_longValue = _longValuesOverflow;
+			_longValuesArenaOverflow = true;
+		}
+#else
 		_longValue = (byte *) malloc(_length-1);
+#endif
 		for (byte i=0; i <_length-1 ; i++) _longValue[i] = 0;
 	}  
 	if (_indicator & KNX_COM_OBJ_I_INDICATOR) _validity = false; // case of object with "InitRead" indicator
@@ -54,8 +76,37 @@ KnxComObject::KnxComObject(e_KnxDPT_ID dptId, byte indicator )
 }
 
 
+// Copy constructor
+KnxComObject::KnxComObject(const KnxComObject& ori)
+#ifdef KNX_COM_OBJ_SUPPORT_ALL_PRIORITIES
+: _active(ori._active), _addr(ori._addr), _dptId(ori._dptId), _indicator(ori._indicator), _length(ori._length), _prio(ori._prio)
+#else
+: _active(ori._active), _addr(ori._addr), _dptId(ori._dptId), _indicator(ori._indicator), _length(ori._length)
+#endif
+{
+	_validity = ori._validity;
+	_txPending = ori._txPending;
+#ifdef KNX_STATS
+	_stats = ori._stats;
+#endif
+	if (_length <= 2) { _longValue = NULL; _value = ori._value; } // short value case
+	else { // long value case
+#ifdef KNX_NO_HEAP
+		_longValue = ori._longValue; // the arena is never released
+#else
+		_longValue = (byte *) malloc(_length-1);
+		ori.GetValue(_longValue);
+#endif
+	}
+}
+
+
 // Destructor
+#ifdef KNX_NO_HEAP
+KnxComObject::~KnxComObject() {}
+#else
 KnxComObject::~KnxComObject() { if (_length > 2) free(_longValue); }
+#endif
 
 bool KnxComObject::isActive() {
     return _active;
@@ -80,6 +131,9 @@ void KnxComObject::UpdateValue(const byte ori[])
 	if (_length <=2) _value = ori[0]; // short value case, UpdateValue(byte) fct should rather be used
 	else for (byte i=0; i < _length-1 ; i++) _longValue[i] = ori[i]; // long value case
 	_validity = true;  // com obj set to valid
+#ifdef KNX_STATS
+	_stats.lastUpdateMillis = millis();
+#endif
 }
 
 
@@ -91,6 +145,9 @@ byte KnxComObject::UpdateValue(const KnxTelegram& ori)
 	else if (_length == 2) ori.GetLongPayload(&_value,1);
 	else ori.GetLongPayload(_longValue, _length - 1);
 	_validity = true;  // com object set to valid
+#ifdef KNX_STATS
+	_stats.lastUpdateMillis = millis();
+#endif
 	return KNX_COM_OBJECT_OK;
 }
 
@@ -113,6 +170,7 @@ void KnxComObject::CopyValue(KnxTelegram& dest) const
 }
 
 
+#ifndef KNX_NO_HEAP
 // DEBUG function
 void KnxComObject::Info(String& str) const
 {
@@ -138,10 +196,11 @@ byte length = GetLength();
 	else 
         {
 		str+="\nLongValue=";
-		byte *longValue = (byte *) malloc(length- 1);
+		byte longValue[KNX_TELEGRAM_PAYLOAD_MAX_SIZE - 1];
                 GetValue(longValue);
 		for (byte i = 0; i < length-1; i++) str+=String(longValue[i], HEX)+' ';
 	}
 }
+#endif
 
 //EOF
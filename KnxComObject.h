@@ -36,6 +36,15 @@
 // By default, all the objects have NORMAL priority, other priorities are not supported
 // turn KNX_COM_OBJ_SUPPORT_ALL_PRIORITIES flag on to allow support of all the priorities
 // #define KNX_COM_OBJ_SUPPORT_ALL_PRIORITIES
+// MEMORY :
+// By default, the long com object values and the TPUART index table are allocated on the heap
+// turn KNX_NO_HEAP flag on to carve them from static storage sized by the sketch (see KNX_DEVICE_STATIC_STORAGE())
+// NB : the library sources then fail to compile if they use malloc()/free()
+// #define KNX_NO_HEAP
+// STATISTICS :
+// turn KNX_STATS flag on to keep the statistics of the com objects (telegrams count, last update time) and of
+// the RX/TX paths (see KnxDevice::getStatistics())
+// #define KNX_STATS
 
 // Definition of com obj indicator values
 // See "knx.org" for com obj indicators specification
@@ -68,6 +77,37 @@
 #define KNX_COM_OBJECT_OK       0
 #define KNX_COM_OBJECT_ERROR    255
 
+// Transmit pending flags : telegrams to be sent for the com object
+// The value sent is the com object value when the telegram is built
+#define KNX_COM_OBJ_TX_WRITE_PENDING    0x01 // WRITE telegram (value updated locally)
+#define KNX_COM_OBJ_TX_RESPONSE_PENDING 0x02 // RESPONSE telegram (value read by the bus)
+#define KNX_COM_OBJ_TX_READ_PENDING     0x04 // READ telegram (value update requested to the bus)
+
+// Nb of bytes of value storage needed by a com object of the given DPT (0 for short values)
+// NB : to be used in constant expressions only, the DPT tables are read directly, not from the flash
+constexpr byte KnxComObjectLongValueSize(e_KnxDPT_ID dptId) {
+    return (KnxDPTFormatToLengthBit[KnxDPTIdToFormat[dptId]] >= 16) ? (KnxDPTFormatToLengthBit[KnxDPTIdToFormat[dptId]] / 8) : 0;
+}
+
+// Nb of bytes of value storage needed by a list of com objects, given their DPTs
+// e.g. KnxLongValuesSize(KNX_DPT_60000_000, KNX_DPT_1_001, KNX_DPT_9_001) == 16
+constexpr word KnxLongValuesSize(void) { return 0; }
+
+template <typename... DptIds>
+constexpr word KnxLongValuesSize(e_KnxDPT_ID dptId, DptIds... others) {
+    return KnxComObjectLongValueSize(dptId) + KnxLongValuesSize(others...);
+}
+
+#ifdef KNX_STATS
+// Statistics of a com object
+typedef struct {
+    word rxNb;                       // nb of telegrams received for the com object (write, response, read served), saturated
+    word txNb;                       // nb of telegrams sent for the com object and positively confirmed, saturated
+    unsigned long lastUpdateMillis;  // time (millis()) of the last value update, by the bus or locally
+    word txRequestMillis;            // time (millis()) of the oldest transmit request still pending
+} type_knx_com_object_stats;
+#endif
+
 class KnxComObject {
     
     // true: CO can be used, false: CO is "offline"
@@ -93,6 +133,9 @@ class KnxComObject {
     // NB : the objects not typed "InitRead" get "true" validity value
     boolean _validity;
 
+    // Transmit pending flags (KNX_COM_OBJ_TX_xxx_PENDING)
+    byte _txPending;
+
     union {
         // field used in case of short value (1 byte max width, i.e. length <= 2)
 
@@ -102,9 +145,28 @@ class KnxComObject {
         };
         // field used in case of long value (2 bytes width or more, i.e. length > 2)
         // The data space is allocated dynamically by the constructor
+        // (carved from _longValuesArena with KNX_NO_HEAP)
         byte *_longValue;
     };
 
+#ifdef KNX_STATS
+    type_knx_com_object_stats _stats;
+#endif
+
+#ifdef KNX_NO_HEAP
+    // Storage of the long values
+    // The definition shall be provided by the end-user (see KNX_DEVICE_STATIC_STORAGE())
+    static byte _longValuesArena[];
+    static const word _longValuesArenaSize;
+
+    // Nb of arena bytes already given to com objects
+    static word _longValuesArenaUsedNb;
+
+    // Storage shared by the com objects the arena could not hold
+    static byte _longValuesOverflow[KNX_TELEGRAM_PAYLOAD_MAX_SIZE - 1];
+    static boolean _longValuesArenaOverflow;
+#endif
+
 public:
     // Constructor :
 #ifdef KNX_COM_OBJ_SUPPORT_ALL_PRIORITIES	
@@ -112,6 +174,13 @@ public:
 #else
     KnxComObject(e_KnxDPT_ID dptId, byte indicator);
 #endif
+    // Copy constructor : the copy gets its own long value storage
+    // (with KNX_NO_HEAP, the storage is shared, the arena is never released)
+    KnxComObject(const KnxComObject&);
+
+    // No assignment : the attributes are constant and each com object owns its long value storage
+    KnxComObject& operator=(const KnxComObject&) = delete;
+
     // Destructor
     ~KnxComObject();
     
@@ -146,6 +215,21 @@ public:
     // NB : the function does not change the validity.
     void ToggleValue(void);
 
+    // Get the transmit pending flags (KNX_COM_OBJ_TX_xxx_PENDING)
+    byte GetTxPending(void) const;
+
+    // Set/Clear transmit pending flags (KNX_COM_OBJ_TX_xxx_PENDING)
+    void SetTxPending(byte flags);
+    void ClearTxPending(byte flags);
+
+#ifdef KNX_STATS
+    // Statistics, the value updates are timestamped by UpdateValue(), the telegrams are accounted by KnxDevice
+    const type_knx_com_object_stats& GetStats(void) const;
+    void AccountRx(void);
+    void AccountTx(void);
+    void ClearStats(void);
+#endif
+
     // functions NOT INLINED :
 
     // Get the com obj value (short and long value cases)
@@ -164,8 +248,16 @@ public:
     // Copy the com obj value into a telegram object
     void CopyValue(KnxTelegram& dest) const;
 
+#ifndef KNX_NO_HEAP
     // DEBUG function
+    // NB : String uses the heap, not available with KNX_NO_HEAP
     void Info(String&) const;
+#endif
+
+#ifdef KNX_NO_HEAP
+    // Return true if the long values arena has been too small for the com objects constructed so far
+    static boolean LongValuesArenaOverflow(void);
+#endif
 };
 
 
@@ -215,6 +307,9 @@ inline byte KnxComObject::UpdateValue(byte newValue) {
     if (_length > 2) return KNX_COM_OBJECT_ERROR;
     _value = newValue;
     _validity = true;
+#ifdef KNX_STATS
+    _stats.lastUpdateMillis = millis();
+#endif
     return KNX_COM_OBJECT_OK;
 }
 
@@ -222,4 +317,46 @@ inline void KnxComObject::ToggleValue(void) {
     _value = !_value;
 }
 
+inline byte KnxComObject::GetTxPending(void) const {
+    return _txPending;
+}
+
+inline void KnxComObject::SetTxPending(byte flags) {
+#ifdef KNX_STATS
+    if (!_txPending) _stats.txRequestMillis = millis();
+#endif
+    _txPending |= flags;
+}
+
+inline void KnxComObject::ClearTxPending(byte flags) {
+    _txPending &= ~flags;
+}
+
+#ifdef KNX_STATS
+inline const type_knx_com_object_stats& KnxComObject::GetStats(void) const {
+    return _stats;
+}
+
+inline void KnxComObject::AccountRx(void) {
+    if (_stats.rxNb != 0xFFFF) _stats.rxNb++;
+}
+
+inline void KnxComObject::AccountTx(void) {
+    if (_stats.txNb != 0xFFFF) _stats.txNb++;
+}
+
+inline void KnxComObject::ClearStats(void) {
+    _stats.rxNb = 0;
+    _stats.txNb = 0;
+    _stats.lastUpdateMillis = 0;
+    _stats.txRequestMillis = 0;
+}
+#endif
+
+#ifdef KNX_NO_HEAP
+inline boolean KnxComObject::LongValuesArenaOverflow(void) {
+    return _longValuesArenaOverflow;
+}
+#endif
+
 #endif // KNXCOMOBJECT_H
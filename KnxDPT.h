@@ -113,7 +113,8 @@ enum eKnxDPT_Format {
 
 // Definition of the length in bits according to the format
 // NB : table is stored in flash program memory to save RAM
-const byte KnxDPTFormatToLengthBit[] PROGMEM = {
+// NB : constexpr, so that the com object lengths can be computed at compile time (see KnxComObjectLongValueSize())
+constexpr byte KnxDPTFormatToLengthBit[] PROGMEM = {
   1 , //  KNX_DPT_FORMAT_B1 = 0,
   2 , //  KNX_DPT_FORMAT_B2,
   4 , // KNX_DPT_FORMAT_B1U3
@@ -290,7 +291,8 @@ enum e_KnxDPT_ID {
 
 // Definition of the format according to the ID
 // NB : table is stored in flash program memory to save RAM
-const byte KnxDPTIdToFormat[] PROGMEM = {
+// NB : constexpr, so that the com object lengths can be computed at compile time (see KnxComObjectLongValueSize())
+constexpr byte KnxDPTIdToFormat[] PROGMEM = {
   KNX_DPT_FORMAT_B1, //  KNX_DPT_1_001, // 1.001 B1 DPT_Switch
   KNX_DPT_FORMAT_B1, //  KNX_DPT_1_002, // 1.002 B1 DPT_Bool
   KNX_DPT_FORMAT_B1, //  KNX_DPT_1_003, // 1.003 B1 DPT_Enable
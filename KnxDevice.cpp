@@ -28,6 +28,18 @@
 #include "KnxDevice.h"
 #include "KnxTools.h"
 
+#ifndef ESP8266
+#include <avr/sleep.h>
+#endif
+
+#ifdef KNX_NO_HEAP
+#include <new>
+#pragma GCC poison malloc free realloc calloc
+
+// Storage of the TPUART object
+alignas(KnxTpUart) static byte tpuartStorage[sizeof(KnxTpUart)];
+#endif
+
 static inline word TimeDeltaWord(word now, word before) {
     return (word) (now - before);
 }
@@ -46,10 +58,43 @@ KnxDevice& Knx = KnxDevice::Knx;
 KnxDevice::KnxDevice() {
     _state = INIT;
     _tpuart = NULL;
-    _txActionList = ActionRingBuffer<type_tx_action, ACTIONS_QUEUE_SIZE>();
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+    _listeningAddressesNb = 0;
+#endif
+    for (byte lane = 0; lane < TX_LANES_NB; lane++) {
+        _txPendingNb[lane] = 0;
+        _txPendingMaxNb[lane] = 0;
+        _txScanIndex[lane] = 0;
+        _txLaneSkipsNb[lane] = 0;
+        _txRetryAttemptsMax[lane] = 1;
+        _txRetryBackoffMillis[lane] = KNX_DEVICE_TX_RETRY_BACKOFF_MS;
+    }
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+    _txMessagesNb = 0;
+#endif
     _initCompleted = false;
     _initIndex = 0;
+    _initGapMillis = KNX_DEVICE_INIT_GAP_MIN_MS;
+    _initRoundsNb = 0;
+    _initJitterSeed = 1;
+    _txSentTimeMillis = 0;
+    _txConfirmLatencyMillis = 0;
+    _busLoadIndex = KNX_DEVICE_NO_COM_OBJECT;
+    _busLoadUpdateMillis = 0;
+    _monitorFrames = NULL;
+    _monitorFramesNb = 0;
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+    _txRetriesNb = 0;
+#endif
+    _txGiveUpCallback = NULL;
+    _txPreparedAction.command = _txSentAction.command = KNX_WRITE_REQUEST;
+    _txPreparedAction.index = _txSentAction.index = 0;
+#if defined(KNX_STATS)
+    _txPreparedRequestMillis = 0;
+#endif
     _rxTelegram = NULL;
+    _txSentSlot = 0;
+    _txPrepared = false;
 #if defined(KNXDEVICE_DEBUG_INFO)
     _nbOfInits = 0;
     _debugStrPtr = NULL;
@@ -62,29 +107,72 @@ int KnxDevice::getNumberOfComObjects() {
 
 
 // Start the KNX Device
-// return KNX_DEVICE_ERROR (255) if begin() failed
+// return KNX_DEVICE_INIT_ERROR (2) if begin() failed
 // else return KNX_DEVICE_OK
 
-e_KnxDeviceStatus KnxDevice::begin(HardwareSerial& serial, word physicalAddr) {
-    _tpuart = new KnxTpUart(serial, physicalAddr, NORMAL);
+e_KnxDeviceStatus KnxDevice::begin(HardwareSerial& serial, word physicalAddr, type_KnxTpUartMode mode) {
+    if ((mode == BUS_MONITOR) && (_monitorFrames == NULL)) {
+        DebugInfo("Init Error : no monitor buffer!\n");
+        return KNX_DEVICE_INIT_ERROR;
+    }
+#ifdef KNX_NO_HEAP
+    if (KnxComObject::LongValuesArenaOverflow()) {
+        DebugInfo("Init Error : long values storage too small!\n");
+        return KNX_DEVICE_INIT_ERROR;
+    }
+    _tpuart = new (tpuartStorage) KnxTpUart(serial, physicalAddr, mode);
+#else
+    _tpuart = new KnxTpUart(serial, physicalAddr, mode);
+#endif
     _rxTelegram = &_tpuart->GetReceivedTelegram();
     //delay(10000); // Workaround for init issue with bus-powered arduino
     // the issue is reproduced on one (faulty?) TPUART device only, so remove it for the moment.
     if (_tpuart->Reset() != KNX_TPUART_OK) {
+#ifdef KNX_NO_HEAP
+        _tpuart->~KnxTpUart();
+#else
         delete(_tpuart);
+#endif
         _tpuart = NULL;
         _rxTelegram = NULL;
         DebugInfo("Init Error!\n");
         return KNX_DEVICE_INIT_ERROR;
     }
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+#ifdef KNX_NO_HEAP
+    _tpuart->AttachComObjectsList(_comObjectsList, _numberOfComObjects, _tpuartIndexTable, _listeningAddresses, _listeningAddressesNb);
+#else
+    _tpuart->AttachComObjectsList(_comObjectsList, _numberOfComObjects, _listeningAddresses, _listeningAddressesNb);
+#endif
+#else
+#ifdef KNX_NO_HEAP
+    _tpuart->AttachComObjectsList(_comObjectsList, _numberOfComObjects, _tpuartIndexTable);
+#else
     _tpuart->AttachComObjectsList(_comObjectsList, _numberOfComObjects);
+#endif
+#endif
     _tpuart->SetEvtCallback(&KnxDevice::GetTpUartEvents);
     _tpuart->SetAckCallback(&KnxDevice::TxTelegramAck);
+    if (mode == BUS_MONITOR) {
+        _tpuart->AttachMonitorBuffer(_monitorFrames, _monitorFramesNb);
+        _initCompleted = true; // no init read in BUS_MONITOR mode
+    }
     _tpuart->Init();
     _state = IDLE;
     DebugInfo("Init successful\n");
     _lastInitTimeMillis = millis();
-    _lastTXTimeMicros = _lastTXTimeMicros = micros();
+    _lastRXTimeMicros = _lastTXTimeMicros = micros();
+    _initRoundsNb = 0;
+    _initJitterSeed = ((word) (physicalAddr * 40503U)) | 1; // multiplicative hash, close addresses get distant seeds
+    _initGapMillis = KNX_DEVICE_INIT_GAP_MIN_MS + NextInitJitter() % KNX_DEVICE_INIT_JITTER_MAX_MS; // first init read
+    _txConfirmLatencyMillis = 0;
+    _busLoadUpdateMillis = _lastInitTimeMillis;
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+    _txRetriesNb = 0;
+#endif
+#if defined(KNX_STATS)
+    clearStatistics();
+#endif
 #if defined(KNXDEVICE_DEBUG_INFO)
     _nbOfInits = 0;
 #endif
@@ -97,117 +185,362 @@ void KnxDevice::end() {
     type_tx_action action;
 
     _state = INIT;
-    while (_txActionList.Pop(action)); // empty ring buffer
+    while (PopTxAction(action)); // clear the transmit pending flags
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+    _txMessagesNb = 0;
+#endif
+    _txPrepared = false;
     _initCompleted = false;
     _initIndex = 0;
     _rxTelegram = NULL;
+#ifdef KNX_NO_HEAP
+    if (_tpuart) _tpuart->~KnxTpUart();
+#else
     delete(_tpuart);
+#endif
     _tpuart = NULL;
 }
 
 
 // KNX device execution task
 // This function call shall be placed in the "loop()" Arduino function
-void KnxDevice::task(void) {
+// It returns the time (in usec) before it needs to be called again, see KnxDevice.h
+
+unsigned long KnxDevice::task(void) {
     
     type_tx_action action;
-    word nowTimeMillis, nowTimeMicros;
-    
+    byte initIndex;
+    word nowTimeMillis, elapsedTime;
+    unsigned long nowTimeMicros;
+    unsigned long deadline = KNX_DEVICE_NO_DEADLINE, stepDeadline;
+    // no init read left, no bus load com object, no telegram to send, no TPUART activity
+    boolean idle = _initCompleted && (_busLoadIndex == KNX_DEVICE_NO_COM_OBJECT) && !isActive();
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+    if (_txRetriesNb) idle = false; // retry waiting for its backoff
+#endif
+
+    // IDLE FAST PATH : nothing to do but waiting for RX bytes
+#if defined(KNXTPUART_RX_ISR)
+    if (idle) return KNX_DEVICE_NO_DEADLINE; // the RX interrupt makes the task due
+    nowTimeMicros = micros();
+#else
+    nowTimeMicros = micros();
+    elapsedTime = TimeDeltaWord(nowTimeMicros, _lastRXTimeMicros);
+    if (idle && (elapsedTime <= 400)) return 401 - elapsedTime; // only the RX polling is due
+#endif
+
     // STEP 1 : Initialize Com Objects having Init Read attribute
     if (!_initCompleted) {
         nowTimeMillis = millis();
-        // To avoid KNX bus overloading, we wait for 500 ms between each Init read request
-        if (TimeDeltaWord(nowTimeMillis, _lastInitTimeMillis) > 500) {
-            while ((_initIndex < _numberOfComObjects) && (_comObjectsList[_initIndex].GetValidity())) _initIndex++;
-
-            if (_initIndex == _numberOfComObjects) {
+        elapsedTime = TimeDeltaWord(nowTimeMillis, _lastInitTimeMillis);
+        // To avoid KNX bus overloading, the Init read requests are paced (see UpdateInitGap())
+        if (elapsedTime > _initGapMillis) {
+            if (!FindInitComObject(initIndex)) {
                 _initCompleted = true; // All the Com Object initialization have been performed
                 //  DebugInfo(String("KNXDevice INFO: Com Object init completed, ")+ String( _nbOfInits) + String("objs initialized.\n"));
             } else { // Com Object to be initialised has been found
-                // Add a READ request in the TX action list
+                // Set the READ pending flag of the com object
 #if defined(KNXDEVICE_DEBUG_INFO) || defined(KNXDEVICE_DEBUG_INFO_VERBOSE)
                 _nbOfInits++;
 #endif
-                action.command = KNX_READ_REQUEST;
-                action.index = _initIndex;
-                _txActionList.Append(action);
-                _lastInitTimeMillis = millis(); // Update the timer
+                SetTxPending(initIndex, KNX_COM_OBJ_TX_READ_PENDING);
+                _initIndex = initIndex + 1;
+                UpdateInitGap();
+                _lastInitTimeMillis = nowTimeMillis; // Update the timer
+                elapsedTime = 0;
             }
         }
+        if (!_initCompleted) deadline = (_initGapMillis + 1 - elapsedTime) * 1000UL; // next init read
     }
 
+    // Update of the bus load diagnostic com object, once per bus load window
+    if (_busLoadIndex != KNX_DEVICE_NO_COM_OBJECT) {
+        nowTimeMillis = millis();
+        elapsedTime = TimeDeltaWord(nowTimeMillis, _busLoadUpdateMillis);
+        if (elapsedTime >= KNXTPUART_BUS_LOAD_SLOTS_NB * KNXTPUART_BUS_LOAD_SLOT_MS) {
+            byte busLoad = getBusLoad();
+            if (read(_busLoadIndex) != busLoad) write(_busLoadIndex, (unsigned int) busLoad);
+            _busLoadUpdateMillis = nowTimeMillis;
+            elapsedTime = 0;
+        }
+        stepDeadline = (KNXTPUART_BUS_LOAD_SLOTS_NB * KNXTPUART_BUS_LOAD_SLOT_MS - elapsedTime) * 1000UL;
+        if (stepDeadline < deadline) deadline = stepDeadline;
+    }
+
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+    // Failed telegrams : the retries are queued once their backoff elapsed (see UpdateTxRetries())
+    if (_txRetriesNb) {
+        stepDeadline = ServeTxRetries();
+        if (stepDeadline < deadline) deadline = stepDeadline;
+    }
+#endif
+
     // STEP 2 : Get new received KNX messages from the TPUART
+#if defined(KNXTPUART_RX_ISR)
+    // The bytes are received under interrupt, the TPUART RX task processes them at each call
+    _tpuart->RXTask();
+    stepDeadline = _tpuart->GetRxDeadline(nowTimeMicros); // EOP of the telegram being received
+#else
     // The TPUART RX task is executed every 400 us
-    nowTimeMicros = micros();
-    if (TimeDeltaWord(nowTimeMicros, _lastRXTimeMicros) > 400) {
+    elapsedTime = TimeDeltaWord(nowTimeMicros, _lastRXTimeMicros);
+    if (elapsedTime > 400) {
         _lastRXTimeMicros = nowTimeMicros;
         _tpuart->RXTask();
+        elapsedTime = 0;
     }
+    stepDeadline = 401 - elapsedTime;
+#endif
+    if (stepDeadline < deadline) deadline = stepDeadline;
+
+    // BUS MONITOR mode : the frames are captured by the TPUART RX task, the device does not send
+    if (_tpuart->GetMode() == BUS_MONITOR) return deadline;
 
     // STEP 3 : Send KNX messages following TX actions
-    if (_state == IDLE) {
-        if (_txActionList.Pop(action)) { // Data to be transmitted
-//            Serial.println("Something to do");
-            switch (action.command) {
-                
-                case KNX_READ_REQUEST: // a read operation of a Com Object on the KNX network is required
-//                    Serial.println("KNX_READ_REQUEST");
-                    //_objectsList[action.index].CopyToTelegram(_txTelegram, KNX_COMMAND_VALUE_READ);
-                    _comObjectsList[action.index].CopyAttributes(_txTelegram);
-                    _txTelegram.ClearLongPayload();
-                    _txTelegram.ClearFirstPayloadByte(); // Is it required to have a clean payload ??
-                    _txTelegram.SetCommand(KNX_COMMAND_VALUE_READ);
-                    _txTelegram.UpdateChecksum();
-                    _tpuart->SendTelegram(_txTelegram);
-                    _state = TX_ONGOING;
-                    break;
+    // The next telegram is prepared while the current one is being sent, it is handed to the TPUART as soon as
+    // the current one is acknowledged (see TxTelegramAck())
+    // NB : a prepared telegram is not overtaken by an action of higher priority popped after it
+    if ((!_txPrepared) && PopTxAction(action)) {
+        BuildTxTelegram(action, _txTelegrams[_txSentSlot ^ 1]);
+        _txPreparedAction = action;
+        _txPrepared = true;
+    }
+    if ((_state == IDLE) && _txPrepared) SendPreparedTelegram();
 
-                case KNX_RESPONSE_REQUEST: // a response operation of a Com Object on the KNX network is required
-//                    Serial.println("KNX_RESPONSE_REQUEST");
-                    _comObjectsList[action.index].CopyAttributes(_txTelegram);
-                    _comObjectsList[action.index].CopyValue(_txTelegram);
-                    _txTelegram.SetCommand(KNX_COMMAND_VALUE_RESPONSE);
-                    _txTelegram.UpdateChecksum();
-                    _tpuart->SendTelegram(_txTelegram);
-                    _state = TX_ONGOING;
-                    break;
+    // STEP 4 : LET THE TP-UART TRANSMIT KNX MESSAGES
+    // The TPUART TX task is executed every 800 us while a telegram is handed over, or once the ACK timeout elapsed
+    stepDeadline = _tpuart->GetTxDeadline();
+    if (stepDeadline == 0) {
+        nowTimeMicros = micros(); // a telegram handed in STEP 2 or 3 has restarted the TX period
+        elapsedTime = TimeDeltaWord(nowTimeMicros, _lastTXTimeMicros);
+        if (elapsedTime > 800) {
+            _lastTXTimeMicros = nowTimeMicros;
+            _tpuart->TXTask();
+            elapsedTime = 0;
+        }
+        stepDeadline = 801 - elapsedTime;
+    }
+    if (stepDeadline < deadline) deadline = stepDeadline;
 
-                case KNX_WRITE_REQUEST: // a write operation of a Com Object on the KNX network is required
-                    // update the com obj value
-//                    Serial.println("KNX_WRITE_REQUEST");
-                    if ((_comObjectsList[action.index].GetLength()) <= 2)
-                        _comObjectsList[action.index].UpdateValue(action.byteValue);
-                    else {
-                        _comObjectsList[action.index].UpdateValue(action.valuePtr);
-                        free(action.valuePtr);
-//                        Serial.println("KNX_WRITE_REQUEST2");
-                    }
-                    // transmit the value through KNX network only if the Com Object has transmit attribute
-                    if ((_comObjectsList[action.index].GetIndicator()) & KNX_COM_OBJ_T_INDICATOR) {
-//                        Serial.println("KNX_WRITE_REQUEST3");
-                        _comObjectsList[action.index].CopyAttributes(_txTelegram);
-                        _comObjectsList[action.index].CopyValue(_txTelegram);
-                        _txTelegram.SetCommand(KNX_COMMAND_VALUE_WRITE);
-                        _txTelegram.UpdateChecksum();
-//                        Serial.println("KNX_WRITE_REQUEST4");
-                        _tpuart->SendTelegram(_txTelegram);
-//                        Serial.println("KNX_WRITE_REQUEST5");
-                        _state = TX_ONGOING;
-                    }
-                    break;
+    // A TX action queued after STEP 3 (e.g. by the ACK callback) is prepared at the next call
+    if ((!_txPrepared) && IsTxActionPending()) deadline = 0;
+    return deadline;
+}
+
+
+// Build the telegram of a TX action
+
+void KnxDevice::BuildTxTelegram(const type_tx_action& action, KnxTelegram& telegram) {
+    switch (action.command) {
+
+        case KNX_READ_REQUEST: // a read operation of a Com Object on the KNX network is required
+            _comObjectsList[action.index].CopyAttributes(telegram);
+            telegram.ClearLongPayload();
+            telegram.ClearFirstPayloadByte(); // Is it required to have a clean payload ??
+            telegram.SetCommand(KNX_COMMAND_VALUE_READ);
+            break;
+
+        case KNX_RESPONSE_REQUEST: // a response operation of a Com Object on the KNX network is required
+            _comObjectsList[action.index].CopyAttributes(telegram);
+            _comObjectsList[action.index].CopyValue(telegram);
+            telegram.SetCommand(KNX_COMMAND_VALUE_RESPONSE);
+            break;
 
-                default: break;
+        case KNX_WRITE_REQUEST: // a write operation of a Com Object on the KNX network is required
+            // the com obj value has been updated by write(), and the com obj has transmit attribute
+            _comObjectsList[action.index].CopyAttributes(telegram);
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+            if (IsTxMessageObject(action.index)) { // message com object : the oldest value queued by write()
+                byte position = FindTxMessage(action.index);
+                if (position < _txMessagesNb) {
+                    telegram.SetLongPayload(_txMessages[position].value, sizeof(_txMessages[position].value));
+                    telegram.SetCommand(KNX_COMMAND_VALUE_WRITE);
+                    break;
+                }
             }
+#endif
+            _comObjectsList[action.index].CopyValue(telegram);
+            telegram.SetCommand(KNX_COMMAND_VALUE_WRITE);
+            break;
+
+        default: break;
+    }
+    telegram.UpdateChecksum();
+}
+
+
+// Hand the prepared telegram to the TPUART
+
+void KnxDevice::SendPreparedTelegram(void) {
+    byte slot = _txSentSlot ^ 1;
+    if (_tpuart->SendTelegram(_txTelegrams[slot]) != KNX_TPUART_OK) return; // TPUART busy, retried later
+    _txSentSlot = slot;
+    _txPrepared = false;
+    _state = TX_ONGOING;
+    _txSentTimeMillis = millis();
+    _txSentAction = _txPreparedAction;
+#if defined(KNX_STATS)
+    _stats.txQueueWaitMillis.Add(TimeDeltaWord(_txSentTimeMillis, _txPreparedRequestMillis));
+#endif
+    // the first piece of the telegram is written right away, the TPUART TX task period restarts from now
+    _lastTXTimeMicros = micros();
+    _tpuart->TXTask();
+}
+
+
+// Find the next com object waiting for its init value, round robin from _initIndex
+// A com object sharing its address with a lower index one waiting as well is skipped : the response
+// to the read request of the latter updates both
+// Return false if all the com objects have been initialized
+
+boolean KnxDevice::FindInitComObject(byte& index) {
+    byte candidate = _initIndex;
+
+    for (byte scannedNb = 0; scannedNb < _numberOfComObjects; scannedNb++, candidate++) {
+        if (candidate >= _numberOfComObjects) { // new round, the com objects left got no response so far
+            candidate = 0;
+            if (_initRoundsNb < 0xFF) _initRoundsNb++;
+        }
+        if (_comObjectsList[candidate].GetValidity()) continue;
+        // lower index com objects with the same address, found in the ordered index table of the TPUART
+        if (!_tpuart->HasLowerInvalidComObject(_comObjectsList[candidate].GetAddr(), candidate)) {
+            index = candidate;
+            return true;
         }
     }
+    return false;
+}
 
-    // STEP 4 : LET THE TP-UART TRANSMIT KNX MESSAGES
-    // The TPUART TX task is executed every 800 us
-    nowTimeMicros = micros();
-    if (TimeDeltaWord(nowTimeMicros, _lastTXTimeMicros) > 800) {
-        _lastTXTimeMicros = nowTimeMicros;
-        _tpuart->TXTask();
+
+// Compute the gap before the next init read request :
+// - KNX_DEVICE_INIT_GAP_MIN_MS on a free bus, stretched by the load of the other devices over the last bus load
+//   slot (see KnxTpUart::GetBusLoad()) so that
+//   the other devices keep their share of the bus (about 500 ms on a saturated bus)
+// - 2 confirm latencies at least (the request and its response), the latency grows with the bus access time
+//   and the repetitions
+// - doubled at each new round over the com objects left without response
+// - plus a pseudo random jitter seeded with the physical address, to desynchronize identical devices
+
+void KnxDevice::UpdateInitGap(void) {
+    type_tpuart_bus_load busLoad;
+    unsigned long gap, load;
+
+    _tpuart->GetBusLoad(1, busLoad); // zero load till the first slot is completed
+    // bus load in 1/256, up to 90%
+    load = ((unsigned long) busLoad.rxUtilizationPercent << 8) / 100;
+    if (load > 230) load = 230;
+
+    gap = ((unsigned long) KNX_DEVICE_INIT_GAP_MIN_MS << 8) / (256 - load);
+    if (gap < 2UL * _txConfirmLatencyMillis) gap = 2UL * _txConfirmLatencyMillis;
+    gap <<= (_initRoundsNb < 5) ? _initRoundsNb : 5;
+    gap += NextInitJitter() % (gap / 4 + 1);
+    _initGapMillis = (gap < KNX_DEVICE_INIT_GAP_MAX_MS) ? gap : KNX_DEVICE_INIT_GAP_MAX_MS;
+}
+
+
+// Next value of the init jitter pseudo random sequence (16 bit xorshift)
+
+word KnxDevice::NextInitJitter(void) {
+    _initJitterSeed ^= _initJitterSeed << 7;
+    _initJitterSeed ^= _initJitterSeed >> 9;
+    _initJitterSeed ^= _initJitterSeed << 8;
+    return _initJitterSeed;
+}
+
+
+// Retry or give up the telegram handed to the TPUART according to its result :
+// - a delivered telegram ends its retry, if any
+// - a failed telegram is retried after a backoff doubled at each failure, plus a pseudo random jitter (the init
+//   jitter sequence) so that the devices having failed on the same collision do not retry together
+// - it is given up once it has been sent attemptsMax times, or if the retry table is full
+
+boolean KnxDevice::UpdateTxRetries(e_TpUartTxAck value) {
+    const type_tx_action& action = _txSentAction;
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+    byte lane = TxLane(_comObjectsList[action.index].GetPriority());
+    byte i;
+
+    for (i = 0; i < _txRetriesNb; i++)
+        if ((_txRetries[i].index == action.index) && (_txRetries[i].command == action.command)) break;
+    if (value == ACK_RESPONSE) {
+        if (i < _txRetriesNb) _txRetries[i] = _txRetries[--_txRetriesNb]; // delivered, the retry is over
+        return true;
+    }
+    byte attemptsNb = (i < _txRetriesNb) ? _txRetries[i].attemptsNb + 1 : 1;
+    if ((attemptsNb < _txRetryAttemptsMax[lane]) && (i < KNX_DEVICE_TX_RETRIES_MAX)) {
+        type_tx_retry& retry = _txRetries[i];
+        if (i == _txRetriesNb) { // first failure
+            _txRetriesNb++;
+            retry.index = action.index;
+            retry.command = action.command;
+        }
+        unsigned long backoff = (unsigned long) _txRetryBackoffMillis[lane] << ((attemptsNb < 9) ? attemptsNb - 1 : 8);
+        backoff += NextInitJitter() % (backoff / 2 + 1);
+        retry.attemptsNb = attemptsNb;
+        retry.waiting = true;
+        retry.failureMillis = millis();
+        retry.backoffMillis = (backoff < KNX_DEVICE_TX_RETRY_BACKOFF_MAX_MS) ? backoff : KNX_DEVICE_TX_RETRY_BACKOFF_MAX_MS;
+#if defined(KNX_STATS)
+        KNXTPUART_STATS_INC(_stats.txRetryNb);
+#endif
+        return false;
+    }
+    if (i < _txRetriesNb) _txRetries[i] = _txRetries[--_txRetriesNb];
+#else
+    if (value == ACK_RESPONSE) return true;
+#endif
+    // the telegram is given up
+#if defined(KNX_STATS)
+    KNXTPUART_STATS_INC(_stats.txGiveUpNb);
+#endif
+    if (_txGiveUpCallback != NULL) _txGiveUpCallback(action.index, action.command);
+    return true;
+}
+
+
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+// Queue the retries whose backoff elapsed, return the time (in usec) before the next one is due
+// The retry stays in the table till the result of its telegram (see UpdateTxRetries())
+
+unsigned long KnxDevice::ServeTxRetries(void) {
+    unsigned long deadline = KNX_DEVICE_NO_DEADLINE, stepDeadline;
+    word nowTimeMillis = millis(), elapsedTime;
+
+    for (byte i = 0; i < _txRetriesNb; i++) {
+        type_tx_retry& retry = _txRetries[i];
+        if (!retry.waiting) continue;
+        elapsedTime = TimeDeltaWord(nowTimeMillis, retry.failureMillis);
+        if (elapsedTime >= retry.backoffMillis) {
+            retry.waiting = false;
+            switch (retry.command) {
+                case KNX_READ_REQUEST: SetTxPending(retry.index, KNX_COM_OBJ_TX_READ_PENDING); break;
+                case KNX_RESPONSE_REQUEST: SetTxPending(retry.index, KNX_COM_OBJ_TX_RESPONSE_PENDING); break;
+                default: SetTxPending(retry.index, KNX_COM_OBJ_TX_WRITE_PENDING); break;
+            }
+        } else {
+            stepDeadline = (retry.backoffMillis - elapsedTime) * 1000UL;
+            if (stepDeadline < deadline) deadline = stepDeadline;
+        }
     }
+    return deadline;
+}
+#endif
+
+
+// Set the retry policy of a priority lane
+
+e_KnxDeviceStatus KnxDevice::setTxRetryPolicy(e_KnxPriority priority, byte attemptsMax, word backoffMillis) {
+    if (attemptsMax == 0) return KNX_DEVICE_ERROR;
+#if KNX_DEVICE_TX_RETRIES_MAX == 0
+    if (attemptsMax > 1) return KNX_DEVICE_NOT_IMPLEMENTED;
+#endif
+    byte lane = TxLane(priority);
+    _txRetryAttemptsMax[lane] = attemptsMax;
+    _txRetryBackoffMillis[lane] = backoffMillis;
+    return KNX_DEVICE_OK;
+}
+
+void KnxDevice::setTxGiveUpCallback(type_TxGiveUpCallbackFctPtr callback) {
+    _txGiveUpCallback = callback;
 }
 
 
@@ -261,29 +594,21 @@ e_KnxDeviceStatus KnxDevice::read(byte objectIndex, byte returnedValue[]) {
 // And a telegram is sent on the KNX bus if the com object has communication & transmit attributes
 
 template <typename T> e_KnxDeviceStatus KnxDevice::write(byte objectIndex, T value) {
-    type_tx_action action;
-    byte *destValue;
+    byte destValue[14]; // define temporary DPT value with max length
     
     if (!_comObjectsList[objectIndex].isActive()) {
         return KNX_DEVICE_COMOBJ_INACTIVE;
     }
     byte length = _comObjectsList[objectIndex].GetLength();
 
-    if (length <= 2) action.byteValue = (byte) value; // short object case
+    if (length <= 2) _comObjectsList[objectIndex].UpdateValue((byte) value); // short object case
     else { // long object case, let's try to translate value to the com object DPT
-        destValue = (byte *) malloc(length - 1); // allocate the memory for DPT
         e_KnxDeviceStatus status = ConvertToDpt(value, destValue, pgm_read_byte(&KnxDPTIdToFormat[_comObjectsList[objectIndex].GetDptId()]));
-        if (status) // translation error
-        {
-            free(destValue);
-            return status; // we cannot convert, we stop here
-        } else action.valuePtr = destValue;
-    }
-    // add WRITE action in the TX action queue
-    action.command = KNX_WRITE_REQUEST;
-    action.index = objectIndex;
-    _txActionList.Append(action);
-    return KNX_DEVICE_OK;
+        if (status) return status; // translation error, we cannot convert, we stop here
+        _comObjectsList[objectIndex].UpdateValue(destValue);
+    }
+    // transmit the value through KNX network only if the Com Object has transmit attribute
+    return RequestTxWrite(objectIndex);
 }
 
 template e_KnxDeviceStatus KnxDevice::write <bool>(byte objectIndex, bool value);
@@ -302,24 +627,12 @@ template e_KnxDeviceStatus KnxDevice::write <double>(byte objectIndex, double va
 // And a telegram is sent on the KNX bus if the com object has communication & transmit attributes
 
 e_KnxDeviceStatus KnxDevice::write(byte objectIndex, byte valuePtr[]) {
-    type_tx_action action;
-    byte *dptValue;
     byte length = _comObjectsList[objectIndex].GetLength();
-//    Serial.println("Writing to actionlist0");
-//    Serial.print("len: ");
-//    Serial.println(length);
     if (length > 2) // check we are in long object case
-    { // add WRITE action in the TX action queue
-//        Serial.println("Writing to actionlist1");
-        action.command = KNX_WRITE_REQUEST;
-        action.index = objectIndex;
-        dptValue = (byte *) malloc(length - 1); // allocate the memory for long value
-        for (byte i = 0; i < length - 1; i++) dptValue[i] = valuePtr[i]; // copy value
-//        Serial.println("Writing to actionlist2");
-        action.valuePtr = (byte *) dptValue;
-        _txActionList.Append(action);
-//        Serial.println("Writing to actionlist3");
-        return KNX_DEVICE_OK;
+    {
+        _comObjectsList[objectIndex].UpdateValue(valuePtr);
+        // transmit the value through KNX network only if the Com Object has transmit attribute
+        return RequestTxWrite(objectIndex);
     }
     return KNX_DEVICE_ERROR;
 }
@@ -330,10 +643,7 @@ e_KnxDeviceStatus KnxDevice::write(byte objectIndex, byte valuePtr[]) {
 // NB : the function is asynchroneous, the update completion is notified by the knxEvents() callback
 
 void KnxDevice::update(byte objectIndex) {
-    type_tx_action action;
-    action.command = KNX_READ_REQUEST;
-    action.index = objectIndex;
-    _txActionList.Append(action);
+    SetTxPending(objectIndex, KNX_COM_OBJ_TX_READ_PENDING);
 }
 
 
@@ -342,8 +652,170 @@ void KnxDevice::update(byte objectIndex) {
 boolean KnxDevice::isActive(void) const {
     if (_tpuart->IsActive()) return true; // TPUART is active
     if (_state == TX_ONGOING) return true; // the Device is sending a request
-    if (_txActionList.ElementsNb()) return true; // there is at least one tx action in the queue
+    if (_txPrepared) return true; // a telegram is ready to be sent
+    return IsTxActionPending();
+}
+
+
+// The function returns true if the device has nothing to do until the next received byte
+
+boolean KnxDevice::canSleep(void) const {
+    if (isActive()) return false; // RX in progress or TX pending
+    // the next init read shall not be due
+    if ((!_initCompleted) && (TimeDeltaWord(millis(), _lastInitTimeMillis) > _initGapMillis)) return false;
+    // the bus load com object update shall not be due
+    if ((_busLoadIndex != KNX_DEVICE_NO_COM_OBJECT)
+        && (TimeDeltaWord(millis(), _busLoadUpdateMillis) >= KNXTPUART_BUS_LOAD_SLOTS_NB * KNXTPUART_BUS_LOAD_SLOT_MS)) return false;
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+    // no retry shall be due
+    for (byte i = 0; i < _txRetriesNb; i++)
+        if (_txRetries[i].waiting && (TimeDeltaWord(millis(), _txRetries[i].failureMillis) >= _txRetries[i].backoffMillis)) return false;
+#endif
+    return true;
+}
+
+
+// Put the CPU in IDLE sleep mode if canSleep()
+// The UART and the timers keep running in IDLE mode : the UART RX interrupt of the next byte wakes the CPU up,
+// with the byte stored. Deeper modes stop the UART clock, the control field of the next telegram would be lost.
+
+boolean KnxDevice::sleep(void) {
+#ifndef ESP8266
+    boolean slept = false;
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    noInterrupts(); // a byte received between the check and the sleep would not wake the CPU up
+    if (canSleep()) {
+        sleep_enable();
+        interrupts(); // the instruction following SEI is executed before any pending interrupt
+        sleep_cpu();
+        sleep_disable();
+        slept = true;
+    }
+    interrupts();
+    return slept;
+#else
     return false;
+#endif
+}
+
+
+// TX statistics of a priority lane
+
+byte KnxDevice::getTxQueueDepth(e_KnxPriority priority) {
+    return _txPendingNb[TxLane(priority)];
+}
+
+byte KnxDevice::getTxQueueMaxDepth(e_KnxPriority priority) {
+    return _txPendingMaxNb[TxLane(priority)];
+}
+
+
+// Bus load statistics over the last "slotsNb" completed slots
+
+boolean KnxDevice::getBusStatistics(type_tpuart_bus_load& busLoad, byte slotsNb) {
+    return _tpuart->GetBusLoad(slotsNb, busLoad);
+}
+
+byte KnxDevice::getBusLoad(byte slotsNb) {
+    type_tpuart_bus_load busLoad;
+    _tpuart->GetBusLoad(slotsNb, busLoad);
+    return busLoad.utilizationPercent;
+}
+
+float KnxDevice::getBusTelegramsRate(byte slotsNb) {
+    type_tpuart_bus_load busLoad;
+    if (!_tpuart->GetBusLoad(slotsNb, busLoad)) return 0;
+    return (busLoad.rxTelegramsNb + busLoad.txTelegramsNb) * 1000.0 / busLoad.periodMillis;
+}
+
+byte KnxDevice::getBusAddressedRatio(byte slotsNb) {
+    type_tpuart_bus_load busLoad;
+    if ((!_tpuart->GetBusLoad(slotsNb, busLoad)) || (!busLoad.rxTelegramsNb)) return 0;
+    return (byte) ((busLoad.addressedNb * 100UL) / busLoad.rxTelegramsNb);
+}
+
+
+// Provide the frames ring of the BUS MONITOR mode (before begin())
+
+e_KnxDeviceStatus KnxDevice::setMonitorBuffer(type_tpuart_monitor_frame frames[], byte framesNb) {
+    if (_state != INIT) return KNX_DEVICE_INIT_ERROR;
+    if ((frames == NULL) || (!framesNb)) return KNX_DEVICE_ERROR;
+    _monitorFrames = frames;
+    _monitorFramesNb = framesNb;
+    return KNX_DEVICE_OK;
+}
+
+boolean KnxDevice::getMonitorFrame(type_tpuart_monitor_frame& frame) {
+    if (_tpuart == NULL) return false;
+    return _tpuart->GetMonitorFrame(frame);
+}
+
+word KnxDevice::getMonitorLostFramesNb(void) {
+    if (_tpuart == NULL) return 0;
+    return _tpuart->GetMonitorLostFramesNb();
+}
+
+
+// Confirm latency estimate of the TPUART
+
+boolean KnxDevice::getTxConfirmTiming(type_tpuart_confirm_timing& timing) {
+    if (_tpuart == NULL) return false;
+    timing = _tpuart->GetConfirmTiming();
+    return true;
+}
+
+#if defined(KNXTPUART_RX_ISR)
+word KnxDevice::getRxOverrunsNb(void) {
+    if (_tpuart == NULL) return 0;
+    return _tpuart->GetRxOverrunsNb();
+}
+#endif
+
+#if defined(KNX_STATS)
+const type_knx_device_stats& KnxDevice::getStatistics(void) {
+    if (_tpuart != NULL) { // the TPUART layer counters are copied
+        _stats.rxErrors = _tpuart->GetRxStats();
+#if defined(KNXTPUART_RX_ISR)
+        _stats.rxIsrBufferMaxNb = _tpuart->GetRxIsrBufferMaxNb();
+        _stats.rxIsrBufferLostNb = _tpuart->GetRxOverrunsNb();
+#endif
+        _stats.monitorLostFramesNb = _tpuart->GetMonitorLostFramesNb();
+    }
+    return _stats;
+}
+
+e_KnxDeviceStatus KnxDevice::getComObjectStatistics(byte index, type_knx_com_object_stats& stats) {
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    stats = _comObjectsList[index].GetStats();
+    return KNX_DEVICE_OK;
+}
+
+// NB : the RX interrupt ring and monitor ring counters are kept till end()
+void KnxDevice::clearStatistics(void) {
+    _stats = type_knx_device_stats(); // empty histograms, null counters
+    for (byte i = 0; i < _numberOfComObjects; i++) _comObjectsList[i].ClearStats();
+    if (_tpuart != NULL) _tpuart->ClearRxStats();
+}
+
+// A received telegram has updated a com object, knxEvents() is called next
+void KnxDevice::AccountRxEvent(byte index, unsigned long rxEndMicros) {
+    _comObjectsList[index].AccountRx();
+    // 32 bits delta : with a slow loop the latency exceeds the 65 ms a 16 bits delta could hold
+    unsigned long latency = micros() - rxEndMicros;
+    _stats.rxEventMicros.Add(((long) latency < 0) ? 0 : latency); // 0 for an end of packet found after the micros() read
+}
+#endif
+
+
+// Set the com object updated with the bus load
+
+e_KnxDeviceStatus KnxDevice::setBusLoadComObject(byte index) {
+    if (index != KNX_DEVICE_NO_COM_OBJECT) {
+        if ((index >= _numberOfComObjects) || (_comObjectsList[index].GetLength() != 2)) return KNX_DEVICE_INVALID_INDEX;
+    }
+    _busLoadIndex = index;
+    return KNX_DEVICE_OK;
 }
 
 // Overwrite the address of an attache Com Object
@@ -361,55 +833,242 @@ word KnxDevice::getComObjectAddress(byte index) {
     return _comObjectsList[index].GetAddr();
 }
 
+e_KnxDeviceStatus KnxDevice::addComObjectListeningAddress(byte index, word addr) {
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+    if (_state != INIT) return KNX_DEVICE_INIT_ERROR;
+    if (index >= _numberOfComObjects) return KNX_DEVICE_INVALID_INDEX;
+    for (byte i = 0; i < _listeningAddressesNb; i++) {
+        if ((_listeningAddresses[i].addr == addr) && (_listeningAddresses[i].index == index)) return KNX_DEVICE_OK;
+    }
+    if (_listeningAddressesNb >= KNX_DEVICE_LISTENING_ADDRESSES_MAX) return KNX_DEVICE_ERROR;
+    _listeningAddresses[_listeningAddressesNb].addr = addr;
+    _listeningAddresses[_listeningAddressesNb].index = index;
+    _listeningAddressesNb++;
+    return KNX_DEVICE_OK;
+#else
+    (void) index;
+    (void) addr;
+    return KNX_DEVICE_NOT_IMPLEMENTED;
+#endif
+}
+
+e_KnxDeviceStatus KnxDevice::clearComObjectListeningAddresses(void) {
+    if (_state != INIT) return KNX_DEVICE_INIT_ERROR;
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+    _listeningAddressesNb = 0;
+#endif
+    return KNX_DEVICE_OK;
+}
+
+
+// Set/Clear transmit pending flags (KNX_COM_OBJ_TX_xxx_PENDING) of a com object
+
+void KnxDevice::SetTxPending(byte index, byte flags) {
+    KnxComObject& comObject = _comObjectsList[index];
+    if (!comObject.GetTxPending()) { // the com object enters its lane
+        byte lane = TxLane(comObject.GetPriority());
+        if (++_txPendingNb[lane] > _txPendingMaxNb[lane]) _txPendingMaxNb[lane] = _txPendingNb[lane];
+    }
+    comObject.SetTxPending(flags);
+}
+
+void KnxDevice::ClearTxPending(byte index, byte flags) {
+    KnxComObject& comObject = _comObjectsList[index];
+    if (!comObject.GetTxPending()) return;
+    comObject.ClearTxPending(flags);
+    if (!comObject.GetTxPending()) _txPendingNb[TxLane(comObject.GetPriority())]--; // the com object leaves its lane
+}
+
+
+// Request the WRITE telegram of a com object whose value has just been updated locally
+// The telegram of a plain com object carries its value when it is built, several updates meanwhile give one telegram.
+// The value of a message com object is queued : a single telegram of the com object is pending at a time, the
+// next queued value gets pending once the telegram is over (see ReleaseTxMessage())
+
+e_KnxDeviceStatus KnxDevice::RequestTxWrite(byte index) {
+    if (!((_comObjectsList[index].GetIndicator()) & KNX_COM_OBJ_T_INDICATOR)) return KNX_DEVICE_OK;
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+    if (IsTxMessageObject(index)) {
+        if (_txMessagesNb == KNX_DEVICE_TX_MESSAGES_MAX) return KNX_DEVICE_TX_QUEUE_FULL;
+        boolean waiting = (FindTxMessage(index) < _txMessagesNb); // a telegram of the com object is already on its way
+        type_tx_message& message = _txMessages[_txMessagesNb++];
+        message.index = index;
+        _comObjectsList[index].GetValue(message.value);
+        if (waiting) return KNX_DEVICE_OK;
+    }
+#endif
+    SetTxPending(index, KNX_COM_OBJ_TX_WRITE_PENDING);
+    return KNX_DEVICE_OK;
+}
+
+
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+// Check whether a com object is a message com object
+
+boolean KnxDevice::IsTxMessageObject(byte index) const {
+    return _comObjectsList[index].GetDptId() == KNX_DPT_60000_000;
+}
+
+
+// Position of the oldest value queued for a com object, KNX_DEVICE_TX_MESSAGES_MAX if none
+
+byte KnxDevice::FindTxMessage(byte index) const {
+    for (byte position = 0; position < _txMessagesNb; position++)
+        if (_txMessages[position].index == index) return position;
+    return KNX_DEVICE_TX_MESSAGES_MAX;
+}
+
+
+// Forget the oldest value queued for a com object once its telegram is over (delivered or given up)
+// The next value queued for the com object, if any, gets pending
+
+void KnxDevice::ReleaseTxMessage(byte index) {
+    byte position = FindTxMessage(index);
+    if (position >= _txMessagesNb) return;
+    for (_txMessagesNb--; position < _txMessagesNb; position++) _txMessages[position] = _txMessages[position + 1];
+    if (FindTxMessage(index) < _txMessagesNb) SetTxPending(index, KNX_COM_OBJ_TX_WRITE_PENDING);
+}
+#endif
+
+
+// Return true if at least one com object is waiting for a telegram sending
+
+boolean KnxDevice::IsTxActionPending(void) const {
+    for (byte lane = 0; lane < TX_LANES_NB; lane++)
+        if (_txPendingNb[lane]) return true;
+    return false;
+}
+
+
+// Get the next action to be performed : highest priority lane first, unless a lower
+// priority lane has been passed over TX_LANE_MAX_SKIPS times in a row.
+// Inside a lane, the com objects are served in a round robin way
+// The transmit pending flag of the action is cleared
+// Return false if there is no action to be performed
+
+boolean KnxDevice::PopTxAction(type_tx_action& action) {
+    byte lane, servedLane = TX_LANES_NB;
+
+    for (lane = 0; lane < TX_LANES_NB; lane++) { // starving lane first
+        if ((_txLaneSkipsNb[lane] >= TX_LANE_MAX_SKIPS) && _txPendingNb[lane]) {
+            servedLane = lane;
+            break;
+        }
+    }
+    if (servedLane == TX_LANES_NB) { // strict priority
+        for (lane = 0; (lane < TX_LANES_NB) && !_txPendingNb[lane]; lane++);
+        if (lane == TX_LANES_NB) return false; // no com object waiting for a telegram sending
+        servedLane = lane;
+    }
+    // the other lanes of lower priority with pending com objects are passed over
+    for (lane = servedLane + 1; lane < TX_LANES_NB; lane++)
+        if (_txPendingNb[lane] && (_txLaneSkipsNb[lane] < TX_LANE_MAX_SKIPS)) _txLaneSkipsNb[lane]++;
+    _txLaneSkipsNb[servedLane] = 0;
+
+    // scan the com objects of the lane, starting after the last served one
+    byte index = _txScanIndex[servedLane];
+    for (byte i = 0; i < _numberOfComObjects; i++, index++) {
+        if (index >= _numberOfComObjects) index = 0;
+        byte pending = _comObjectsList[index].GetTxPending();
+        if ((!pending) || (TxLane(_comObjectsList[index].GetPriority()) != servedLane)) continue;
+        // a RESPONSE is sent first (a device is waiting for it), then a WRITE, then a READ
+        if (pending & KNX_COM_OBJ_TX_RESPONSE_PENDING) {
+            action.command = KNX_RESPONSE_REQUEST;
+            ClearTxPending(index, KNX_COM_OBJ_TX_RESPONSE_PENDING);
+        } else if (pending & KNX_COM_OBJ_TX_WRITE_PENDING) {
+            action.command = KNX_WRITE_REQUEST;
+            ClearTxPending(index, KNX_COM_OBJ_TX_WRITE_PENDING);
+        } else {
+            action.command = KNX_READ_REQUEST;
+            ClearTxPending(index, KNX_COM_OBJ_TX_READ_PENDING);
+        }
+        action.index = index;
+#if defined(KNX_STATS)
+        _txPreparedRequestMillis = _comObjectsList[index].GetStats().txRequestMillis;
+#endif
+        // the com object stays first in the scan if it has other pending flags
+        _txScanIndex[servedLane] = _comObjectsList[index].GetTxPending() ? index : index + 1;
+        return true;
+    }
+    return false; // not reached, _txPendingNb and the com objects flags are consistent
+}
+
+
+// Get the TX lane of a priority
+
+e_KnxDeviceTxLane KnxDevice::TxLane(e_KnxPriority priority) {
+    switch (priority) {
+        case KNX_PRIORITY_SYSTEM_VALUE : return TX_LANE_SYSTEM;
+        case KNX_PRIORITY_ALARM_VALUE : return TX_LANE_ALARM;
+        case KNX_PRIORITY_HIGH_VALUE : return TX_LANE_HIGH;
+        default : return TX_LANE_NORMAL;
+    }
+}
+
 
 // Static GetTpUartEvents() function called by the KnxTpUart layer (callback)
 
 void KnxDevice::GetTpUartEvents(e_KnxTpUartEvent event) {
-    type_tx_action action;
     byte targetedComObjIndex; // index of the Com Object targeted by the event
+    byte cursor = 0; // iteration over the Com Objects targeted by the event
 
     // Manage RECEIVED MESSAGES
+    // All the com objects with the target address are concerned (association)
     if (event == TPUART_EVENT_RECEIVED_KNX_TELEGRAM) {
-        Knx._state = IDLE;
-        targetedComObjIndex = Knx._tpuart->GetTargetedComObjectIndex();
-
+#if defined(KNX_STATS)
+        unsigned long rxEndMicros = Knx._tpuart->GetRxTelegramEndMicros();
+#endif
         switch (Knx._rxTelegram->GetCommand()) {
             case KNX_COMMAND_VALUE_READ:
                 Knx.DebugInfo("READ req.\n");
                 // READ command coming from the bus
-                // if the Com Object has read attribute, then add RESPONSE action in the TX action list
-                if ((_comObjectsList[targetedComObjIndex].GetIndicator()) & KNX_COM_OBJ_R_INDICATOR) { // The targeted Com Object can indeed be read
-                    action.command = KNX_RESPONSE_REQUEST;
-                    action.index = targetedComObjIndex;
-                    Knx._txActionList.Append(action);
+                // the first Com Object with read attribute answers, add RESPONSE action in the TX action list
+                while (Knx._tpuart->GetTargetedComObject(cursor, targetedComObjIndex)) {
+                    if ((_comObjectsList[targetedComObjIndex].GetIndicator()) & KNX_COM_OBJ_R_INDICATOR) { // The targeted Com Object can indeed be read
+#if defined(KNX_STATS)
+                        _comObjectsList[targetedComObjIndex].AccountRx();
+#endif
+                        Knx.SetTxPending(targetedComObjIndex, KNX_COM_OBJ_TX_RESPONSE_PENDING);
+                        break;
+                    }
                 }
                 break;
 
             case KNX_COMMAND_VALUE_RESPONSE:
                 Knx.DebugInfo("RESP req.\n");
-                // RESPONSE command coming from KNX network, we update the value of the corresponding Com Object.
+                // RESPONSE command coming from KNX network, we update the value of the corresponding Com Objects.
                 // We 1st check that the corresponding Com Object has UPDATE attribute
-                if ((_comObjectsList[targetedComObjIndex].GetIndicator()) & KNX_COM_OBJ_U_INDICATOR) {
-                    _comObjectsList[targetedComObjIndex].UpdateValue(*(Knx._rxTelegram));
-                    //We notify the upper layer of the update
-                    knxEvents(targetedComObjIndex);
+                while (Knx._tpuart->GetTargetedComObject(cursor, targetedComObjIndex)) {
+                    if (((_comObjectsList[targetedComObjIndex].GetIndicator()) & KNX_COM_OBJ_U_INDICATOR)
+                        && (_comObjectsList[targetedComObjIndex].UpdateValue(*(Knx._rxTelegram)) == KNX_COM_OBJECT_OK)) {
+                        //We notify the upper layer of the update
+#if defined(KNX_STATS)
+                        Knx.AccountRxEvent(targetedComObjIndex, rxEndMicros);
+#endif
+                        knxEvents(targetedComObjIndex);
+                    }
                 }
                 break;
 
 
             case KNX_COMMAND_VALUE_WRITE:
                 Knx.DebugInfo("WRITE req.\n");
-                // WRITE command coming from KNX network, we update the value of the corresponding Com Object.
+                // WRITE command coming from KNX network, we update the value of the corresponding Com Objects.
                 // We 1st check that the corresponding Com Object has WRITE attribute
-                if ((_comObjectsList[targetedComObjIndex].GetIndicator()) & KNX_COM_OBJ_W_INDICATOR) {
-                    _comObjectsList[targetedComObjIndex].UpdateValue(*(Knx._rxTelegram));
-                    //We notify the upper layer of the update
-                    if (Tools.isActive()) {
-//                        Serial.println("Routing event to tools");
-                        knxToolsEvents(targetedComObjIndex);
-                    } else {
-//                        Serial.println("No event routing");
-                        knxEvents(targetedComObjIndex);
+                while (Knx._tpuart->GetTargetedComObject(cursor, targetedComObjIndex)) {
+                    if (((_comObjectsList[targetedComObjIndex].GetIndicator()) & KNX_COM_OBJ_W_INDICATOR)
+                        && (_comObjectsList[targetedComObjIndex].UpdateValue(*(Knx._rxTelegram)) == KNX_COM_OBJECT_OK)) {
+                        //We notify the upper layer of the update
+#if defined(KNX_STATS)
+                        Knx.AccountRxEvent(targetedComObjIndex, rxEndMicros);
+#endif
+                        if (Tools.isActive()) {
+//                            Serial.println("Routing event to tools");
+                            knxToolsEvents(targetedComObjIndex);
+                        } else {
+//                            Serial.println("No event routing");
+                            knxEvents(targetedComObjIndex);
+                        }
                     }
                 }
                 break;
@@ -433,6 +1092,29 @@ void KnxDevice::GetTpUartEvents(e_KnxTpUartEvent event) {
 
 void KnxDevice::TxTelegramAck(e_TpUartTxAck value) {
     Knx._state = IDLE;
+    Knx._txConfirmLatencyMillis = TimeDeltaWord(millis(), Knx._txSentTimeMillis);
+#if defined(KNX_STATS)
+    type_knx_device_stats& stats = Knx._stats;
+    stats.txConfirmMillis.Add(Knx._txConfirmLatencyMillis);
+    switch (value) {
+        case ACK_RESPONSE:
+            KNXTPUART_STATS_INC(stats.txAckNb);
+            _comObjectsList[Knx._txSentAction.index].AccountTx();
+            break;
+        case NACK_RESPONSE: KNXTPUART_STATS_INC(stats.txNackNb); break;
+        case NO_ANSWER_TIMEOUT: KNXTPUART_STATS_INC(stats.txNoAnswerNb); break;
+        default: KNXTPUART_STATS_INC(stats.txResetNb); break;
+    }
+#endif
+    boolean over = Knx.UpdateTxRetries(value);
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+    const type_tx_action& action = Knx._txSentAction;
+    if (over && (action.command == KNX_WRITE_REQUEST) && Knx.IsTxMessageObject(action.index)) Knx.ReleaseTxMessage(action.index);
+#else
+    (void) over;
+#endif
+    // the TPUART TX is idle, the prepared telegram follows without waiting for the next task() call
+    if (Knx._txPrepared) Knx.SendPreparedTelegram();
 #ifdef KNXDevice_DEBUG
     if (value != ACK_RESPONSE) {
         switch (value) {
@@ -490,7 +1172,7 @@ template <typename T> e_KnxDeviceStatus ConvertFromDpt(const byte dptOriginValue
             return KNX_DEVICE_NOT_IMPLEMENTED;
             break;
 
-        default: KNX_DEVICE_ERROR;
+        default: return KNX_DEVICE_ERROR;
     }
 }
 
@@ -560,7 +1242,7 @@ template <typename T> e_KnxDeviceStatus ConvertToDpt(T originValue, byte dptDest
             return KNX_DEVICE_NOT_IMPLEMENTED;
             break;
 
-        default: KNX_DEVICE_ERROR;
+        default: return KNX_DEVICE_ERROR;
     }
 }
 
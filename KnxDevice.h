@@ -23,7 +23,7 @@
 // Author : Franck Marini
 // Modified: Alexander Christian <info(at)root1.de>
 // Description : KnxDevice Abstraction Layer
-// Module dependencies : HardwareSerial, KnxTelegram, KnxComObject, KnxTpUart, RingBuffer
+// Module dependencies : HardwareSerial, KnxTelegram, KnxComObject, KnxTpUart, KnxHistogram
 
 #ifndef KNXDEVICE_H
 #define KNXDEVICE_H
@@ -31,13 +31,72 @@
 #include "Arduino.h"
 #include "KnxTelegram.h"
 #include "KnxComObject.h"
-#include "ActionRingBuffer.h"
 #include "KnxTpUart.h"
 #include "KnxTools.h"
+#include "KnxHistogram.h"
 
 // !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
 // DEBUG :
 //#define KNXDEVICE_DEBUG_INFO   // Uncomment to activate info traces
+// TX MESSAGES :
+// Max nb of WRITE telegrams of message com objects (DPT 60000.000, e.g. the programming com object) waiting for
+// their result. The value of such a com object is a message, not a state : write() queues a copy of it, each
+// write() gives its own telegram, in order, and a telegram received meanwhile does not overwrite it.
+// 0 handles them as the other com objects (last value sent)
+#ifndef KNX_DEVICE_TX_MESSAGES_MAX
+#define KNX_DEVICE_TX_MESSAGES_MAX 4
+#endif
+
+static_assert(KNX_DEVICE_TX_MESSAGES_MAX < 256, "KNX_DEVICE_TX_MESSAGES_MAX shall be lower than 256");
+
+// LISTENING ADDRESSES :
+// Max nb of additional group addresses the com objects listen to, shared by all the com objects
+// (see addComObjectListeningAddress()). 0 keeps one address per com object
+#ifndef KNX_DEVICE_LISTENING_ADDRESSES_MAX
+#define KNX_DEVICE_LISTENING_ADDRESSES_MAX 0
+#endif
+
+static_assert(KNX_DEVICE_LISTENING_ADDRESSES_MAX < 256, "KNX_DEVICE_LISTENING_ADDRESSES_MAX shall be lower than 256");
+
+// INIT READ PACING :
+// Min/max gap (in msec) between two init read requests. The gap grows with the confirm latency, the bus load
+// seen by the bus load monitor and the retries (see UpdateInitGap())
+#ifndef KNX_DEVICE_INIT_GAP_MIN_MS
+#define KNX_DEVICE_INIT_GAP_MIN_MS 50
+#endif
+#ifndef KNX_DEVICE_INIT_GAP_MAX_MS
+#define KNX_DEVICE_INIT_GAP_MAX_MS 2000
+#endif
+// Max delay (in msec) of the first init read request, derived from the physical address so that identical
+// devices do not start together after a bus power return
+#ifndef KNX_DEVICE_INIT_JITTER_MAX_MS
+#define KNX_DEVICE_INIT_JITTER_MAX_MS 500
+#endif
+
+static_assert((KNX_DEVICE_INIT_GAP_MIN_MS > 0) && (KNX_DEVICE_INIT_GAP_MIN_MS <= KNX_DEVICE_INIT_GAP_MAX_MS)
+              && (KNX_DEVICE_INIT_GAP_MAX_MS + KNX_DEVICE_INIT_JITTER_MAX_MS < 32768), "Invalid init read pacing values");
+
+// TX RETRIES :
+// Max nb of failed telegrams waiting for their retry at the same time (see setTxRetryPolicy()), 0 disables the
+// retries. A failed telegram is given up when the table is full
+#ifndef KNX_DEVICE_TX_RETRIES_MAX
+#define KNX_DEVICE_TX_RETRIES_MAX 4
+#endif
+// Default backoff (in msec) before the first retry, and max backoff (jitter included)
+#ifndef KNX_DEVICE_TX_RETRY_BACKOFF_MS
+#define KNX_DEVICE_TX_RETRY_BACKOFF_MS 100
+#endif
+#ifndef KNX_DEVICE_TX_RETRY_BACKOFF_MAX_MS
+#define KNX_DEVICE_TX_RETRY_BACKOFF_MAX_MS 10000
+#endif
+
+static_assert(KNX_DEVICE_TX_RETRIES_MAX < 256, "KNX_DEVICE_TX_RETRIES_MAX shall be lower than 256");
+static_assert((KNX_DEVICE_TX_RETRY_BACKOFF_MS <= KNX_DEVICE_TX_RETRY_BACKOFF_MAX_MS)
+              && (KNX_DEVICE_TX_RETRY_BACKOFF_MAX_MS < 32768), "Invalid TX retry backoff values");
+
+#if defined(KNX_NO_HEAP) && defined(KNXDEVICE_DEBUG_INFO)
+#error "KNXDEVICE debug traces use String (heap), they are not available with KNX_NO_HEAP"
+#endif
 
 // Values returned by the KnxDevice member functions :
 enum e_KnxDeviceStatus {
@@ -45,10 +104,17 @@ enum e_KnxDeviceStatus {
   KNX_DEVICE_INVALID_INDEX = 1,
   KNX_DEVICE_INIT_ERROR = 2,
   KNX_DEVICE_COMOBJ_INACTIVE = 3,
+  KNX_DEVICE_TX_QUEUE_FULL = 4,
   KNX_DEVICE_NOT_IMPLEMENTED = 254,
   KNX_DEVICE_ERROR = 255
 };
 
+// Value returned by task() when it has nothing to do until the next RX interrupt or API call
+#define KNX_DEVICE_NO_DEADLINE 0xFFFFFFFFUL
+
+// Index value disabling the bus load com object (see setBusLoadComObject())
+#define KNX_DEVICE_NO_COM_OBJECT 0xFF
+
 // Macro functions for conversion of physical and 2/3 level group addresses
 inline word P_ADDR(byte area, byte line, byte busdevice)
 { return (word) ( ((area&0xF)<<12) + ((line&0xF)<<8) + busdevice ); }
@@ -59,7 +125,20 @@ inline word G_ADDR(byte maingrp, byte midgrp, byte subgrp)
 inline word G_ADDR(byte maingrp, byte subgrp)
 { return (word) ( ((maingrp&0x1F)<<11) + subgrp ); }
 
-#define ACTIONS_QUEUE_SIZE 16
+// TX lanes, by decreasing priority
+// The com objects with transmit pending flags are served by lane, highest priority lane first.
+// Without KNX_COM_OBJ_SUPPORT_ALL_PRIORITIES, all the com objects have normal priority
+enum e_KnxDeviceTxLane {
+  TX_LANE_SYSTEM = 0,
+  TX_LANE_ALARM,
+  TX_LANE_HIGH,
+  TX_LANE_NORMAL,
+  TX_LANES_NB
+};
+
+// Starvation protection : a lane with pending com objects is served once it has been passed over by
+// TX_LANE_MAX_SKIPS telegrams of higher priority lanes in a row
+#define TX_LANE_MAX_SKIPS 8
 
 // KnxDevice internal state
 enum e_KnxDeviceState {
@@ -78,20 +157,67 @@ enum e_KnxDeviceTxActionType {
 struct struct_tx_action{
   e_KnxDeviceTxActionType command; // Action type to be performed
   byte index; // Index of the involved ComObject
-  union { // Value
-    // Field used in case of short value (value width <= 1 byte)
-    struct {
-      byte byteValue;
-      byte notUsed;
-    };
-    byte *valuePtr; // Field used in case of long value (width > 1 byte), space is allocated dynamically
-  };
 };// type_tx_action;
 typedef struct struct_tx_action type_tx_action;
 
+// Failed telegram waiting for its retry (see setTxRetryPolicy())
+typedef struct {
+  byte index;          // com object
+  byte command;        // e_KnxDeviceTxActionType of the telegram
+  byte attemptsNb;     // nb of failed attempts
+  boolean waiting;     // true during the backoff, false once the retry is queued
+  word failureMillis;  // time (in msec) of the last failure
+  word backoffMillis;  // backoff (in msec) before the retry
+} type_tx_retry;
+
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+// Message com object value waiting for the result of its WRITE telegram (see KNX_DEVICE_TX_MESSAGES_MAX)
+typedef struct {
+  byte index;                                                   // com object
+  byte value[KnxComObjectLongValueSize(KNX_DPT_60000_000)];     // value given to write()
+} type_tx_message;
+#endif
+
+// Function called when a telegram is given up (see setTxGiveUpCallback())
+typedef void (*type_TxGiveUpCallbackFctPtr) (byte index, e_KnxDeviceTxActionType command);
+
+#if defined(KNX_STATS)
+// Statistics of the RX/TX paths (see getStatistics()), the counters saturate
+typedef struct {
+  // TX path, per telegram handed to the TPUART
+  KnxHistogram txQueueWaitMillis; // from the transmit request of the com object to the handover to the TPUART
+  KnxHistogram txConfirmMillis;   // from the handover to the TPUART to its answer (repetitions included)
+  word txAckNb;                   // positive confirms (ACK_RESPONSE)
+  word txNackNb;                  // negative confirms (NACK_RESPONSE)
+  word txNoAnswerNb;              // no answer from the TPUART (NO_ANSWER_TIMEOUT)
+  word txResetNb;                 // TPUART reset before the answer (TPUART_RESET_RESPONSE)
+  word txRetryNb;                 // failed telegrams scheduled for a retry
+  word txGiveUpNb;                // failed telegrams given up (see setTxGiveUpCallback())
+  // RX path
+  KnxHistogram rxEventMicros;     // from the last char of a telegram to the knxEvents() call, 2 ms EOP gap included
+  type_tpuart_rx_stats rxErrors;  // reception errors of the TPUART layer
+  // Buffers (the TX queue depths are given by getTxQueueMaxDepth())
+  word rxIsrBufferMaxNb;          // max nb of bytes waiting in the RX interrupt ring (KNXTPUART_RX_ISR only)
+  word rxIsrBufferLostNb;         // nb of bytes lost because the RX interrupt ring was full (KNXTPUART_RX_ISR only)
+  word monitorLostFramesNb;       // nb of frames lost because the monitor ring was full (BUS_MONITOR mode only)
+} type_knx_device_stats;
+#endif
+
+#ifdef KNX_NO_HEAP
+// Definition of the static storage used instead of the heap
+// To be placed in the sketch, after the com objects list definition, with the DPTs of all the
+// com objects of the list (including the programming com object, KNX_DPT_60000_000), e.g. :
+// KNX_DEVICE_STATIC_STORAGE(KnxLongValuesSize(KNX_DPT_60000_000, KNX_DPT_1_001, KNX_DPT_9_001));
+// NB : begin() returns KNX_DEVICE_INIT_ERROR if the long values size is too small
+#define KNX_DEVICE_STATIC_STORAGE(longValuesSize) \
+  byte KnxComObject::_longValuesArena[(longValuesSize) > 0 ? (longValuesSize) : 1]; \
+  const word KnxComObject::_longValuesArenaSize = (longValuesSize); \
+  type_tpuart_index_entry KnxDevice::_tpuartIndexTable[sizeof (KnxDevice::_comObjectsList) / sizeof (KnxComObject) + KNX_DEVICE_LISTENING_ADDRESSES_MAX]
+#endif
 
 // Callback function to catch and treat KNX events
 // The definition shall be provided by the end-user
+// NB : a telegram received for an address shared by several com objects is notified once per updated com object
 extern void knxEvents(byte);
 
 
@@ -114,24 +240,106 @@ class KnxDevice {
     // Nb of attached Com Objects
     // The value shall be provided by the end-user
     static const byte _numberOfComObjects;                
+
+#ifdef KNX_NO_HEAP
+    // Storage of the TPUART index table, one entry per com object and per listening address
+    // The definition shall be provided by the end-user (see KNX_DEVICE_STATIC_STORAGE())
+    static type_tpuart_index_entry _tpuartIndexTable[];
+#endif
     
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+    // Additional (address, com object index) pairs the com objects listen to
+    type_tpuart_index_entry _listeningAddresses[KNX_DEVICE_LISTENING_ADDRESSES_MAX];
+
+    // Nb of used entries of _listeningAddresses
+    byte _listeningAddressesNb;
+#endif
+
     // Current KnxDevice state
     e_KnxDeviceState _state;  
     
     // TPUART associated to the KNX Device
     KnxTpUart *_tpuart;                             
     
-    // Queue of transmit actions to be performed
-    ActionRingBuffer<type_tx_action, ACTIONS_QUEUE_SIZE> _txActionList; 
+    // Nb of com objects with transmit pending flags, per lane
+    byte _txPendingNb[TX_LANES_NB];
+
+    // Max value reached by _txPendingNb, per lane
+    byte _txPendingMaxNb[TX_LANES_NB];
+
+    // Index of the com object the scan of the lane starts from (round robin)
+    byte _txScanIndex[TX_LANES_NB];
+
+    // Nb of telegrams of higher priority lanes sent in a row while the lane had pending com objects
+    byte _txLaneSkipsNb[TX_LANES_NB];
     
     // True when all the Com Object with Init attr have been initialized
     boolean _initCompleted;                         
     
-    // Index to the last initiated object
+    // Index of the com object the next init read scan starts from (round robin)
     byte _initIndex;                                
     
     // Time (in msec) of the last init (read) request on the bus
     word _lastInitTimeMillis;                       
+
+    // Gap (in msec) before the next init (read) request
+    word _initGapMillis;
+
+    // Nb of scans over the com objects list restarted because some objects got no init value (saturated)
+    byte _initRoundsNb;
+
+    // Pseudo random state of the init jitter, seeded with the physical address
+    word _initJitterSeed;
+
+    // Time (in msec) the last telegram has been handed to the TPUART
+    word _txSentTimeMillis;
+
+    // Time (in msec) from the handover to the TPUART to the confirm, for the last telegram
+    word _txConfirmLatencyMillis;
+
+    // Index of the com object updated with the bus load, KNX_DEVICE_NO_COM_OBJECT if none
+    byte _busLoadIndex;
+
+    // Time (in msec) of the last bus load com object update
+    word _busLoadUpdateMillis;
+
+    // Retry policy per lane : max nb of attempts (1 : no retry) and backoff (in msec) before the first retry
+    byte _txRetryAttemptsMax[TX_LANES_NB];
+    word _txRetryBackoffMillis[TX_LANES_NB];
+
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+    // Failed telegrams waiting for their retry or being retried
+    type_tx_retry _txRetries[KNX_DEVICE_TX_RETRIES_MAX];
+
+    // Nb of used entries of _txRetries
+    byte _txRetriesNb;
+#endif
+
+    // Function called when a telegram is given up, NULL if none
+    type_TxGiveUpCallbackFctPtr _txGiveUpCallback;
+
+#if defined(KNX_STATS)
+    type_knx_device_stats _stats;
+
+    // Transmit request time (millis()) of the prepared telegram
+    word _txPreparedRequestMillis;
+#endif
+
+    // Frames ring of the BUS MONITOR mode (see setMonitorBuffer())
+    type_tpuart_monitor_frame *_monitorFrames;
+    byte _monitorFramesNb;
+    
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+    // Message com objects values waiting for the result of their WRITE telegram, oldest first
+    type_tx_message _txMessages[KNX_DEVICE_TX_MESSAGES_MAX];
+
+    // Nb of used entries of _txMessages
+    byte _txMessagesNb;
+#endif
+
+    // Actions of the prepared telegram and of the telegram handed to the TPUART
+    type_tx_action _txPreparedAction;
+    type_tx_action _txSentAction;
     
     // Time (in msec) of the last Tpuart Rx activity;
     word _lastRXTimeMicros;                         
@@ -139,8 +347,15 @@ class KnxDevice {
     // Time (in msec) of the last Tpuart Tx activity;
     word _lastTXTimeMicros;                         
     
-    // Telegram object used for telegrams sending
-    KnxTelegram _txTelegram;                        
+    // Telegram objects used for telegrams sending : one is handed to the TPUART, the next one is prepared
+    // in the other slot meanwhile
+    KnxTelegram _txTelegrams[2];
+
+    // Slot of the telegram handed to the TPUART
+    byte _txSentSlot;
+
+    // True when the other slot holds a telegram ready to be sent
+    boolean _txPrepared;
     
     // Reference to the telegram received by the TPUART
     KnxTelegram *_rxTelegram;                       
@@ -169,10 +384,13 @@ class KnxDevice {
     
     /*
      * Start the KNX Device
-     * return KNX_DEVICE_ERROR (255) if begin() failed
+     * In BUS_MONITOR mode, the device captures all the frames of the bus into the monitor buffer (see
+     * setMonitorBuffer()), it neither acknowledges nor sends telegrams and its com objects are not used
+     * return KNX_DEVICE_INIT_ERROR (2) if begin() failed
+     * (TPUART reset failure, long values storage too small with KNX_NO_HEAP, or no monitor buffer in BUS_MONITOR mode)
      * else return KNX_DEVICE_OK
      */
-    e_KnxDeviceStatus begin(HardwareSerial& serial, word physicalAddr);
+    e_KnxDeviceStatus begin(HardwareSerial& serial, word physicalAddr, type_KnxTpUartMode mode = NORMAL);
 
     /*
      * Stop the KNX Device
@@ -182,8 +400,14 @@ class KnxDevice {
     /*
      * KNX device execution task
      * This function shall be called in the "loop()" Arduino function
+     * return the time (in usec) before it needs to be called again (EOP detection, TX pacing, ACK timeout,
+     * next init read), KNX_DEVICE_NO_DEADLINE when nothing is pending.
+     * The sketch may sleep or do other work meanwhile, or ignore the value and call it at each loop.
+     * NB1 : the value is only valid until the next RX byte or API call (write(), update()...), both make
+     *       the task due right away. With KNXTPUART_RX_ISR the RX interrupt wakes the sketch up
+     * NB2 : without KNXTPUART_RX_ISR, the bytes are polled : the value never exceeds 401 usec
      */
-    void task(void);
+    unsigned long task(void);
 
     /* 
      * Quick method to read a short (<=1 byte) com object
@@ -203,8 +427,13 @@ class KnxDevice {
     e_KnxDeviceStatus read(byte objectIndex, byte returnedValue[]);
 
     // Update com object functions :
-    // For all the update functions, the com object value is updated locally
+    // For all the update functions, the com object value is updated locally (immediately)
     // and a telegram is sent on the KNX bus if the object has both COMMUNICATION & TRANSMIT attributes set
+    // NB : the telegram carries the com object value when it is sent, i.e. several updates done
+    // before the sending result in a single telegram with the last value
+    // NB2 : except for the message com objects (DPT 60000.000, see KNX_DEVICE_TX_MESSAGES_MAX), each update of
+    // which gives its own telegram. KNX_DEVICE_TX_QUEUE_FULL is returned when too many are waiting, the value
+    // is then updated locally only
 
     /*
      * Update an usual format com object
@@ -227,7 +456,116 @@ class KnxDevice {
 
     // The function returns true if there is rx/tx activity ongoing, else false
     boolean isActive(void) const;
+
+    /*
+     * Low power operation
+     * canSleep() returns true when the device has nothing to do until the next received byte :
+     * no RX in progress, no TX pending, no init read due.
+     * sleep() puts the CPU in IDLE sleep mode if canSleep() (AVR only, else it returns false at once)
+     * The UART RX interrupt of the next byte wakes the CPU up, as does any other interrupt (e.g. the
+     * timer 0 overflow every 1 ms), then task() shall be called again. Typical loop() :
+     *   Knx.task(); ... sketch work ... Knx.sleep();
+     * return true if the CPU has slept
+     * NB : without KNXTPUART_RX_ISR, task() shall be called right after the wake-up and then every
+     *      400 us till the telegram is received (canSleep() returns false meanwhile)
+     */
+    boolean canSleep(void) const;
+    boolean sleep(void);
+
+    /*
+     * TX statistics of a priority lane
+     * Without KNX_COM_OBJ_SUPPORT_ALL_PRIORITIES, all the priorities share the normal priority lane
+     */
+    // Nb of com objects currently waiting for a telegram sending
+    byte getTxQueueDepth(e_KnxPriority priority);
+    // Max nb of com objects waiting for a telegram sending since the start
+    byte getTxQueueMaxDepth(e_KnxPriority priority);
+
+    /*
+     * Retransmission of the telegrams failed on the bus (NACK after the TPUART repetitions, no confirm from the
+     * TPUART or TPUART reset), per priority lane. Without KNX_COM_OBJ_SUPPORT_ALL_PRIORITIES, all the com objects
+     * have normal priority and follow the KNX_PRIORITY_NORMAL_VALUE policy. To be called before or after begin()
+     * "attemptsMax" is the max nb of sendings of a telegram (1, the default, for no retry), the n-th retry waits
+     * for backoffMillis * 2^(n-1) plus a pseudo random jitter of up to the half, KNX_DEVICE_TX_RETRY_BACKOFF_MAX_MS max
+     * NB : the retried telegram carries the com object value at the time of the retry, a new write() during the
+     *      backoff is sent at once and replaces the retry, except for a message com object (see write()) whose
+     *      retry keeps its value and is followed by the new one
+     * return KNX_DEVICE_NOT_IMPLEMENTED for retries with KNX_DEVICE_TX_RETRIES_MAX at 0,
+     * KNX_DEVICE_ERROR for a null attemptsMax, else KNX_DEVICE_OK
+     */
+    e_KnxDeviceStatus setTxRetryPolicy(e_KnxPriority priority, byte attemptsMax,
+                                       word backoffMillis = KNX_DEVICE_TX_RETRY_BACKOFF_MS);
+
+    /*
+     * Function called when a telegram is given up : its attempts all failed, or the retry table was full
+     * NULL (the default) for no notification. The function is called from task(), it may call write() or update()
+     */
+    void setTxGiveUpCallback(type_TxGiveUpCallbackFctPtr callback);
+
+    /*
+     * Confirm latency estimate of the TPUART and ACK timeout statistics (see KNXTPUART_CONFIRM_TIMEOUT_xxx flags)
+     * With KNX_STATS, getStatistics().txConfirmMillis gives the distribution of the confirm latencies
+     * return false before begin()
+     */
+    boolean getTxConfirmTiming(type_tpuart_confirm_timing& timing);
+
+    /*
+     * Bus load statistics, from the TPUART bus load monitor
+     * All the telegrams seen on the bus are accounted, the device ones included, with their bus time
+     * (13 bit times per char, ACK slot included). The values are averaged over the last "slotsNb" completed
+     * slots of KNXTPUART_BUS_LOAD_SLOT_MS msec, KNXTPUART_BUS_LOAD_SLOTS_NB slots at most
+     * NB : all the values are 0 until the first slot is completed
+     */
+    // Raw statistics, return false until the first slot is completed
+    boolean getBusStatistics(type_tpuart_bus_load& busLoad, byte slotsNb = KNXTPUART_BUS_LOAD_SLOTS_NB);
+    // Bus utilization (in %)
+    byte getBusLoad(byte slotsNb = KNXTPUART_BUS_LOAD_SLOTS_NB);
+    // Nb of telegrams per second on the bus
+    float getBusTelegramsRate(byte slotsNb = KNXTPUART_BUS_LOAD_SLOTS_NB);
+    // Share (in %) of the received telegrams addressed to the device
+    byte getBusAddressedRatio(byte slotsNb = KNXTPUART_BUS_LOAD_SLOTS_NB);
+
+    /*
+     * Diagnostic com object : the com object is updated with getBusLoad() every
+     * KNXTPUART_BUS_LOAD_SLOTS_NB * KNXTPUART_BUS_LOAD_SLOT_MS msec, a telegram is sent on value change
+     * if it has the TRANSMIT attribute
+     * The com object shall be a 1 byte one (e.g. KNX_DPT_5_004), KNX_DEVICE_NO_COM_OBJECT disables the update
+     * return KNX_DEVICE_INVALID_INDEX for a missing or not 1 byte com object, else KNX_DEVICE_OK
+     */
+    e_KnxDeviceStatus setBusLoadComObject(byte index);
     
+    /*
+     * Bus monitor capture (BUS_MONITOR mode)
+     * setMonitorBuffer() provides the frames ring, to be called before begin(), e.g. :
+     *   type_tpuart_monitor_frame monitorFrames[8]; // one frame is about 30 bytes
+     *   Knx.setMonitorBuffer(monitorFrames, 8); Knx.begin(Serial, P_ADDR(1,1,255), BUS_MONITOR);
+     * task() assembles the received chars into complete frames, with their reception time (micros()), checksum
+     * status and bus ACK char. getMonitorFrame() gets the oldest frame out of the ring, it returns false if the
+     * ring is empty. The frames received while the ring is full are lost (see KNX_MONITOR_FRAMES_LOST)
+     * NB : at 100% bus load, a frame is received every 20 ms at most
+     */
+    e_KnxDeviceStatus setMonitorBuffer(type_tpuart_monitor_frame frames[], byte framesNb);
+    boolean getMonitorFrame(type_tpuart_monitor_frame& frame);
+    // Nb of frames lost because the ring was full
+    word getMonitorLostFramesNb(void);
+
+#if defined(KNXTPUART_RX_ISR)
+    // Nb of bytes lost because task() has not been called for too long (RX interrupt ring full)
+    word getRxOverrunsNb(void);
+#endif
+
+#if defined(KNX_STATS)
+    /*
+     * Statistics (KNX_STATS flag, see KnxComObject.h), kept since begin() or the last clearStatistics()
+     * The durations are log2 histograms (see KnxHistogram.h), e.g. :
+     *   Knx.getStatistics().txConfirmMillis.Percentile(99)
+     * getComObjectStatistics() returns KNX_DEVICE_INVALID_INDEX for a missing com object
+     */
+    const type_knx_device_stats& getStatistics(void);
+    e_KnxDeviceStatus getComObjectStatistics(byte index, type_knx_com_object_stats& stats);
+    void clearStatistics(void);
+#endif
+
     /*
      * Overwrite the address of an attache Com Object
      * Overwriting is allowed only when the KnxDevice is in INIT state
@@ -239,6 +577,20 @@ class KnxDevice {
      *  Gets the address of an commobjects
      */
     word getComObjectAddress(byte index);
+
+    /*
+     * Add a group address the Com Object listens to, in addition to its own address
+     * The Com Object is updated by the telegrams sent to any of its addresses, it still sends with its own address
+     * Allowed only when the KnxDevice is in INIT state, at most KNX_DEVICE_LISTENING_ADDRESSES_MAX addresses in total
+     * return KNX_DEVICE_ERROR when the listening addresses table is full,
+     * KNX_DEVICE_NOT_IMPLEMENTED when KNX_DEVICE_LISTENING_ADDRESSES_MAX is 0
+     */
+    e_KnxDeviceStatus addComObjectListeningAddress(byte index, word addr);
+
+    /*
+     * Remove all the listening addresses of all the Com Objects (INIT state only)
+     */
+    e_KnxDeviceStatus clearComObjectListeningAddresses(void);
     
     // Inline Debug function (definition later in this file)
     // Set the string used for debug traces
@@ -257,6 +609,105 @@ class KnxDevice {
      */
     static void TxTelegramAck(e_TpUartTxAck);
 
+    /*
+     * Set/Clear transmit pending flags (KNX_COM_OBJ_TX_xxx_PENDING) of a com object
+     */
+    void SetTxPending(byte index, byte flags);
+    void ClearTxPending(byte index, byte flags);
+
+    /*
+     * Get the next action to be performed : highest priority lane first, unless a lower
+     * priority lane has been passed over TX_LANE_MAX_SKIPS times in a row.
+     * Inside a lane, the com objects are served in a round robin way
+     * The transmit pending flag of the action is cleared
+     * Return false if there is no action to be performed
+     */
+    boolean PopTxAction(type_tx_action& action);
+
+    /*
+     * Return true if at least one com object is waiting for a telegram sending
+     */
+    boolean IsTxActionPending(void) const;
+
+    /*
+     * Get the TX lane of a priority
+     */
+    static e_KnxDeviceTxLane TxLane(e_KnxPriority priority);
+
+    /*
+     * Build the telegram of a TX action
+     */
+    void BuildTxTelegram(const type_tx_action& action, KnxTelegram& telegram);
+
+    /*
+     * Hand the prepared telegram to the TPUART, the device is then TX_ONGOING
+     * The telegram stays prepared if the TPUART is busy
+     */
+    void SendPreparedTelegram(void);
+
+    /*
+     * Find the next com object waiting for its init value, round robin from _initIndex
+     * A com object sharing its address with a lower index one waiting as well is skipped : the response
+     * to the read request of the latter updates both
+     * Return false if all the com objects have been initialized
+     */
+    boolean FindInitComObject(byte& index);
+
+    /*
+     * Retry or give up the telegram handed to the TPUART according to its result, forget its retry once delivered
+     * return true once the telegram is over (delivered or given up), false if it is retried later
+     */
+    boolean UpdateTxRetries(e_TpUartTxAck value);
+
+#if KNX_DEVICE_TX_RETRIES_MAX > 0
+    /*
+     * Queue the retries whose backoff elapsed
+     * return the time (in usec) before the next one is due, KNX_DEVICE_NO_DEADLINE if none is waiting
+     */
+    unsigned long ServeTxRetries(void);
+#endif
+
+#if defined(KNX_STATS)
+    /*
+     * Account a com object updated by a received telegram, before the knxEvents() call
+     */
+    void AccountRxEvent(byte index, unsigned long rxEndMicros);
+#endif
+
+    /*
+     * Compute the gap before the next init read request
+     */
+    void UpdateInitGap(void);
+
+    /*
+     * Next value of the init jitter pseudo random sequence
+     */
+    word NextInitJitter(void);
+
+    /*
+     * Request the WRITE telegram of a com object whose value has just been updated locally, if the com object
+     * has the transmit attribute. The value of a message com object is queued
+     * return KNX_DEVICE_TX_QUEUE_FULL if the message queue is full
+     */
+    e_KnxDeviceStatus RequestTxWrite(byte index);
+
+#if KNX_DEVICE_TX_MESSAGES_MAX > 0
+    /*
+     * Check whether a com object is a message com object (see KNX_DEVICE_TX_MESSAGES_MAX)
+     */
+    boolean IsTxMessageObject(byte index) const;
+
+    /*
+     * Position in _txMessages of the oldest value queued for a com object, KNX_DEVICE_TX_MESSAGES_MAX if none
+     */
+    byte FindTxMessage(byte index) const;
+
+    /*
+     * Forget the oldest value queued for a com object once its telegram is over, the next one gets pending
+     */
+    void ReleaseTxMessage(byte index);
+#endif
+
     /* 
      * Inline Debug function (definition later in this file)
      */
@@ -274,6 +725,8 @@ inline void KnxDevice::DebugInfo(const char comment[]) const
 {
 #if defined(KNXDEVICE_DEBUG_INFO)
 	if (_debugStrPtr != NULL) *_debugStrPtr += String(_debugInfoText) + String(comment);
+#else
+	(void) comment;
 #endif
 }
 
@@ -0,0 +1,116 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ *
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : KnxHistogram.h
+// Description : Fixed size histogram of durations with log2 buckets
+//               bucket 0 counts the 0 values, bucket n (n >= 1) the values from 2^(n-1) to 2^n - 1,
+//               the last bucket all the values from 2^(KNX_HISTOGRAM_BUCKETS_NB-2) upwards.
+//               The counters saturate, no heap nor String is used
+// Module dependencies : none
+
+#ifndef KNXHISTOGRAM_H
+#define KNXHISTOGRAM_H
+
+#include "Arduino.h"
+
+// !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
+// Nb of buckets : with 16 buckets, the last one starts at 16384 (16 s in msec, 16 ms in usec)
+#ifndef KNX_HISTOGRAM_BUCKETS_NB
+#define KNX_HISTOGRAM_BUCKETS_NB 16
+#endif
+
+static_assert((KNX_HISTOGRAM_BUCKETS_NB >= 2) && (KNX_HISTOGRAM_BUCKETS_NB <= 32),
+              "KNX_HISTOGRAM_BUCKETS_NB shall be in the 2 to 32 range");
+
+class KnxHistogram {
+    word _counts[KNX_HISTOGRAM_BUCKETS_NB]; // nb of values per bucket (saturated)
+    unsigned long _valuesNb;                // nb of values (saturated)
+    unsigned long _sum;                     // sum of the values (saturated)
+    unsigned long _max;                     // max value
+
+  public :
+
+    // Constructor
+    KnxHistogram() { Clear(); }
+
+    void Clear(void)
+    {
+      for (byte i = 0; i < KNX_HISTOGRAM_BUCKETS_NB; i++) _counts[i] = 0;
+      _valuesNb = 0;
+      _sum = 0;
+      _max = 0;
+    }
+
+    // Account a value
+    void Add(unsigned long value)
+    {
+      byte bucket = Bucket(value);
+      if (_counts[bucket] != 0xFFFF) _counts[bucket]++;
+      if (_valuesNb != 0xFFFFFFFFUL) _valuesNb++;
+      _sum = (_sum > 0xFFFFFFFFUL - value) ? 0xFFFFFFFFUL : _sum + value;
+      if (value > _max) _max = value;
+    }
+
+    unsigned long ValuesNb(void) const { return _valuesNb; }
+    unsigned long Max(void) const { return _max; }
+
+    // Mean value (rounded down), 0 without any value
+    // NB : not exact anymore once the sum is saturated
+    unsigned long Mean(void) const { return _valuesNb ? _sum / _valuesNb : 0; }
+
+    // Nb of values of a bucket (0 for a bucket index out of range)
+    word BucketCount(byte bucket) const { return (bucket < KNX_HISTOGRAM_BUCKETS_NB) ? _counts[bucket] : 0; }
+
+    // Lowest value of a bucket
+    static unsigned long BucketMin(byte bucket) { return bucket ? 1UL << (bucket - 1) : 0; }
+
+    // Upper bound of the bucket holding the "percent" percentile, i.e. at least "percent" % of the values
+    // are lower or equal. The max value is returned for the last bucket and when it is lower than the bound
+    unsigned long Percentile(byte percent) const
+    {
+      unsigned long totalNb = 0, countedNb = 0, targetNb;
+      byte bucket;
+      for (bucket = 0; bucket < KNX_HISTOGRAM_BUCKETS_NB; bucket++) totalNb += _counts[bucket];
+      if (totalNb == 0) return 0;
+      targetNb = (totalNb * (percent > 100 ? 100 : percent) + 99) / 100;
+      if (targetNb == 0) targetNb = 1;
+      for (bucket = 0; bucket < KNX_HISTOGRAM_BUCKETS_NB - 1; bucket++) {
+        countedNb += _counts[bucket];
+        if (countedNb >= targetNb) break;
+      }
+      if (bucket == KNX_HISTOGRAM_BUCKETS_NB - 1) return _max;
+      unsigned long bound = BucketMin(bucket + 1) - 1;
+      return (bound < _max) ? bound : _max;
+    }
+
+    // Bucket of a value
+    static byte Bucket(unsigned long value)
+    {
+      byte bucket = 0;
+      while (value && (bucket < KNX_HISTOGRAM_BUCKETS_NB - 1)) {
+        value >>= 1;
+        bucket++;
+      }
+      return bucket;
+    }
+};
+
+#endif // KNXHISTOGRAM_H
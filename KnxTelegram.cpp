@@ -36,68 +36,108 @@ void KnxTelegram::ClearTelegram(void)
 // clear telegram with default values :
 // std FF, no repeat, normal prio, empty payload
 // multicast, routing counter = 6, payload length = 1
-  for (byte i =0; i < KNX_TELEGRAM_MAX_SIZE; i++) _telegram[i] = 0; 
+  for (word i =0; i < KNX_TELEGRAM_MAX_SIZE; i++) _telegram[i] = 0; 
   _controlField = CONTROL_FIELD_DEFAULT_VALUE ; _routing= ROUTING_FIELD_DEFAULT_VALUE;
 }
 
+
+void KnxTelegram::SetExtendedFrame(boolean extended)
+{
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+  if (extended == IsExtendedFrame()) return;
+  byte length = GetPayloadLength();
+  if (extended) {
+  // the fields from byte 1 move 1 byte up, the routing field is split into the extended control field and the length
+    byte routing = _routing;
+    for (byte i = KNX_TELEGRAM_HEADER_SIZE + length; i > 0; i--) _telegram[i + 1] = _telegram[i];
+    _telegram[1] = (routing & ~ROUTING_FIELD_PAYLOAD_LENGTH_MASK) | EXTENDED_CONTROL_FIELD_LDATA_FORMAT;
+    _telegram[KNX_TELEGRAM_HEADER_SIZE] = length;
+    _controlField &= ~CONTROL_FIELD_FRAME_FORMAT_MASK; // CONTROL_FIELD_EXTENDED_FRAME_FORMAT
+  } else {
+  // the fields from byte 2 move 1 byte down, the routing field is rebuilt from the extended control field
+    byte extendedControl = _telegram[1];
+    if (length > KNX_TELEGRAM_STANDARD_MAX_LENGTH) length = KNX_TELEGRAM_STANDARD_MAX_LENGTH;
+    for (byte i = 2; i <= KNX_TELEGRAM_HEADER_SIZE + 1 + length; i++) _telegram[i - 1] = _telegram[i];
+    _routing = (extendedControl & ~EXTENDED_CONTROL_FIELD_FORMAT_MASK) | length;
+    _controlField |= CONTROL_FIELD_STANDARD_FRAME_FORMAT;
+  }
+#else
+  (void) extended;
+#endif
+}
+
    
 void KnxTelegram::SetLongPayload(const byte origin[], byte nbOfBytes) 
 {
-  if (nbOfBytes > KNX_TELEGRAM_PAYLOAD_MAX_SIZE-2) nbOfBytes = KNX_TELEGRAM_PAYLOAD_MAX_SIZE-2;
-  for(byte i=0; i < nbOfBytes; i++) _payloadChecksum[i] = origin[i];
+  byte *payload = &_telegram[KNX_TELEGRAM_LENGTH_OFFSET + ExtendedShift()];
+  if (nbOfBytes > LongPayloadMaxSize()) nbOfBytes = LongPayloadMaxSize();
+  for(byte i=0; i < nbOfBytes; i++) payload[i] = origin[i];
 }
 
 
 void KnxTelegram::ClearLongPayload(void)
 {
-  for(byte i=0; i < KNX_TELEGRAM_PAYLOAD_MAX_SIZE-1; i++) _payloadChecksum[i] = 0;
+  // the checksum is cleared too
+  byte *payload = &_telegram[KNX_TELEGRAM_LENGTH_OFFSET + ExtendedShift()];
+  byte nbOfBytes = LongPayloadMaxSize() + 1;
+  for(byte i=0; i < nbOfBytes; i++) payload[i] = 0;
 }
 
 
 void KnxTelegram::GetLongPayload(byte destination[], byte nbOfBytes) const
 {
-  if (nbOfBytes > KNX_TELEGRAM_PAYLOAD_MAX_SIZE-2) nbOfBytes = KNX_TELEGRAM_PAYLOAD_MAX_SIZE-2 ;
-  for(byte i=0; i < nbOfBytes; i++) destination[i] = _payloadChecksum[i];
+  const byte *payload = &_telegram[KNX_TELEGRAM_LENGTH_OFFSET + ExtendedShift()];
+  if (nbOfBytes > LongPayloadMaxSize()) nbOfBytes = LongPayloadMaxSize();
+  for(byte i=0; i < nbOfBytes; i++) destination[i] = payload[i];
 };
     
 
 byte KnxTelegram::CalculateChecksum(void) const
 {
-  byte indexChecksum, xorSum=0;  
-  indexChecksum = KNX_TELEGRAM_HEADER_SIZE + GetPayloadLength() + 1;
-  for (byte i = 0; i < indexChecksum ; i++)   xorSum ^= _telegram[i]; // XOR Sum of all the databytes
+  word indexChecksum; byte xorSum=0;  
+  indexChecksum = StoredLength() - 1;
+  for (word i = 0; i < indexChecksum ; i++)   xorSum ^= _telegram[i]; // XOR Sum of all the databytes
   return (byte)(~xorSum); // Checksum equals 1's complement of databytes XOR sum
 }
 
 
 void KnxTelegram::UpdateChecksum(void)
 {
-  byte indexChecksum, xorSum=0; 
-  indexChecksum = KNX_TELEGRAM_HEADER_SIZE + GetPayloadLength() + 1;
-  for (byte i = 0; i < indexChecksum ; i++)   xorSum ^= _telegram[i]; // XOR Sum of all the databytes
+  word indexChecksum; byte xorSum=0; 
+  indexChecksum = StoredLength() - 1;
+  for (word i = 0; i < indexChecksum ; i++)   xorSum ^= _telegram[i]; // XOR Sum of all the databytes
   _telegram[indexChecksum] = ~xorSum; // Checksum equals 1's complement of databytes XOR sum
 }
 
 
 void KnxTelegram::Copy(KnxTelegram& dest) const
 {
-  byte length = GetTelegramLength();
-  for (byte i=0; i<length ; i++)  dest._telegram[i] = _telegram[i];
+  word length = StoredLength();
+  for (word i=0; i<length ; i++)  dest._telegram[i] = _telegram[i];
 }
 
 
 void KnxTelegram::CopyHeader(KnxTelegram& dest) const
 {
-  for(byte i=0; i < KNX_TELEGRAM_HEADER_SIZE; i++) dest._telegram[i] = _telegram[i];
+  byte length = KNX_TELEGRAM_HEADER_SIZE + ExtendedShift();
+  for(byte i=0; i < length; i++) dest._telegram[i] = _telegram[i];
 }
 
 
 e_KnxTelegramValidity KnxTelegram::GetValidity(void) const
 {
+  byte shift = ExtendedShift();
   if ((_controlField & CONTROL_FIELD_PATTERN_MASK) != CONTROL_FIELD_VALID_PATTERN) return KNX_TELEGRAM_INVALID_CONTROL_FIELD; 
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+  if (shift) {
+    if (((_controlField & CONTROL_FIELD_FRAME_FORMAT_MASK) != CONTROL_FIELD_EXTENDED_FRAME_FORMAT)
+        || ((_telegram[1] & EXTENDED_CONTROL_FIELD_FORMAT_MASK) != EXTENDED_CONTROL_FIELD_LDATA_FORMAT)) return KNX_TELEGRAM_UNSUPPORTED_FRAME_FORMAT;
+    if (GetPayloadLength() > KNX_TELEGRAM_EXTENDED_MAX_LENGTH) return KNX_TELEGRAM_INCORRECT_PAYLOAD_LENGTH;
+  } else
+#endif
   if ((_controlField & CONTROL_FIELD_FRAME_FORMAT_MASK) != CONTROL_FIELD_STANDARD_FRAME_FORMAT) return KNX_TELEGRAM_UNSUPPORTED_FRAME_FORMAT; 
   if (!GetPayloadLength()) return KNX_TELEGRAM_INCORRECT_PAYLOAD_LENGTH ;
-  if ((_commandH & COMMAND_FIELD_PATTERN_MASK) != COMMAND_FIELD_VALID_PATTERN) return KNX_TELEGRAM_INVALID_COMMAND_FIELD;
+  if ((_telegram[6 + shift] & COMMAND_FIELD_PATTERN_MASK) != COMMAND_FIELD_VALID_PATTERN) return KNX_TELEGRAM_INVALID_COMMAND_FIELD;
   if ( GetChecksum() != CalculateChecksum()) return KNX_TELEGRAM_INCORRECT_CHECKSUM ;
   byte cmd=GetCommand();
   if  (    (cmd!=KNX_COMMAND_VALUE_READ) && (cmd!=KNX_COMMAND_VALUE_RESPONSE) 
@@ -106,6 +146,7 @@ e_KnxTelegramValidity KnxTelegram::GetValidity(void) const
 };
 
 
+#ifndef KNX_NO_HEAP
 void KnxTelegram::Info(String& str) const
 {
   byte payloadLength = GetPayloadLength();
@@ -123,14 +164,15 @@ void KnxTelegram::Info(String& str) const
     default : str+="ERR_VAL!"; break;
   }
   str+="\nPayload=" + String(GetFirstPayloadByte(),HEX)+' ';
-  for (byte i = 0; i < payloadLength-1; i++) str+=String(_payloadChecksum[i], HEX)+' ';
+  for (byte i = 0; i < payloadLength-1; i++) str+=String(_telegram[KNX_TELEGRAM_LENGTH_OFFSET + ExtendedShift() + i], HEX)+' ';
   str+='\n';
 }
 
 
 void KnxTelegram::KnxTelegram::InfoRaw(String& str) const
 {
-  for (byte i = 0; i < KNX_TELEGRAM_MAX_SIZE; i++) str+=String(_telegram[i], HEX)+' ';
+  word length = IsExtendedFrame() ? KNX_TELEGRAM_MAX_SIZE : KNX_TELEGRAM_STANDARD_MAX_SIZE;
+  for (word i = 0; i < length; i++) str+=String(_telegram[i], HEX)+' ';
   str+='\n';
 }
 
@@ -150,6 +192,7 @@ void KnxTelegram::InfoVerbose(String& str) const
   }
   str+="\nSrcAddr=" + String(GetSourceAddress(),HEX);
   str+="\nTargetAddr=" + String(GetTargetAddress(),HEX);
+  str+="\nExtendedFrame="; str+= IsExtendedFrame() ? "YES" : "NO";
   str+="\nGroupAddr="; if (IsMulticast()) str+= "YES"; else str+="NO";
   str+="\nRout.Counter=" + String(GetRoutingCounter(),DEC);
   str+="\nPayloadLgth=" + String(payloadLength,DEC);
@@ -164,7 +207,7 @@ void KnxTelegram::InfoVerbose(String& str) const
     default : str+="ERR_VAL!"; break;
   }
   str+="\nPayload=" + String(GetFirstPayloadByte(),HEX)+' ';
-  for (byte i = 0; i < payloadLength-1; i++) str+=String(_payloadChecksum[i], HEX)+' ';
+  for (byte i = 0; i < payloadLength-1; i++) str+=String(_telegram[KNX_TELEGRAM_LENGTH_OFFSET + ExtendedShift() + i], HEX)+' ';
   str+="\nValidity=";
    switch(GetValidity())
   {
@@ -179,5 +222,6 @@ void KnxTelegram::InfoVerbose(String& str) const
   }
   str+='\n';
 }
+#endif // KNX_NO_HEAP
 
 // EOF
@@ -32,7 +32,7 @@
 #include "Arduino.h"
 
 // ---------- Knx Telegram description (visit "www.knx.org" for more info) -----------
-// => Length : 9 bytes min. to 23 bytes max.
+// => Length : 9 bytes min. to 23 bytes max. (standard frame), up to 263 bytes (extended frame)
 //
 // => Structure :
 //      -Header (6 bytes):
@@ -62,18 +62,48 @@
 //         CC = command (0000 = Value Read, 0001 = Value Response, 0010 = Value Write, 1010 = Memory Write)
 //         DD = Payload Data (1st payload byte)
 //
+// => Extended frame (L_DATA extended service, see KNX_TELEGRAM_EXTENDED_MAX_LENGTH) :
+//      -Header (7 bytes):
+//        Byte 0 | Control Field ("00R1 PP00" format)
+//        Byte 1 | Extended Control Field ("TCCC EEEE" format, T and CCC as in the Routing field, EEEE = 0000 for L_DATA)
+//        Byte 2 & 3 | Source Address
+//        Byte 4 & 5 | Destination Address
+//        Byte 6 | Payload Length (0-254)
+//      -Payload (from 2 up to 255 bytes), from byte 7, with the same Command Field as the standard frame
+//      -Checksum (1 byte)
+//
 // => Transmit timings :
 //     -Tbit = 104us, Tbyte=1,35ms (13 bits per character)
 //     -from 20ms for 1 byte payload telegram (Bus temporisation + Telegram transmit + ACK)
 //     -up to 40ms for 15 bytes payload (Bus temporisation + Telegram transmit + ACK)
+//     -up to 370ms for 254 bytes payload (extended frame)
 //
 
+// !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
+// Max payload length of the extended frames, from 15 up to 254, 0 (default) to handle the standard frames only
+// Each KnxTelegram object takes KNX_TELEGRAM_MAX_SIZE bytes, i.e. 23 bytes with the standard frames only,
+// 9 + KNX_TELEGRAM_EXTENDED_MAX_LENGTH bytes with the extended frames (the TPUART keeps 2 telegrams, KnxDevice 2,
+// and each BUS_MONITOR frame holds one)
+#ifndef KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+#define KNX_TELEGRAM_EXTENDED_MAX_LENGTH 0
+#endif
+
+static_assert((KNX_TELEGRAM_EXTENDED_MAX_LENGTH == 0)
+              || ((KNX_TELEGRAM_EXTENDED_MAX_LENGTH >= 15) && (KNX_TELEGRAM_EXTENDED_MAX_LENGTH <= 254)),
+              "KNX_TELEGRAM_EXTENDED_MAX_LENGTH shall be 0 or in the 15 to 254 range");
+
 // Define for lengths & offsets
 #define KNX_TELEGRAM_HEADER_SIZE        6
 #define KNX_TELEGRAM_PAYLOAD_MAX_SIZE  16
 #define KNX_TELEGRAM_MIN_SIZE           9
-#define KNX_TELEGRAM_MAX_SIZE          23
+#define KNX_TELEGRAM_STANDARD_MAX_SIZE 23
 #define KNX_TELEGRAM_LENGTH_OFFSET      8 // Offset between payload length and telegram length
+#define KNX_TELEGRAM_STANDARD_MAX_LENGTH 15 // Max payload length of the standard frames
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+#define KNX_TELEGRAM_MAX_SIZE          (KNX_TELEGRAM_LENGTH_OFFSET + 1 + KNX_TELEGRAM_EXTENDED_MAX_LENGTH)
+#else
+#define KNX_TELEGRAM_MAX_SIZE          KNX_TELEGRAM_STANDARD_MAX_SIZE
+#endif
 
 enum e_KnxPriority {
   KNX_PRIORITY_SYSTEM_VALUE  = B00000000,
@@ -93,6 +123,7 @@ enum e_KnxCommand {
 #define CONTROL_FIELD_DEFAULT_VALUE         B10111100 // Standard FF; No Repeat; Normal Priority
 #define CONTROL_FIELD_FRAME_FORMAT_MASK     B11000000
 #define CONTROL_FIELD_STANDARD_FRAME_FORMAT B10000000
+#define CONTROL_FIELD_EXTENDED_FRAME_FORMAT B00000000
 #define CONTROL_FIELD_REPEATED_MASK         B00100000
 #define CONTROL_FIELD_SET_REPEATED(x)       (x&=B11011111)
 #define CONTROL_FIELD_PRIORITY_MASK         B00001100
@@ -105,6 +136,11 @@ enum e_KnxCommand {
 #define ROUTING_FIELD_COUNTER_MASK             B01110000 
 #define ROUTING_FIELD_PAYLOAD_LENGTH_MASK      B00001111
 
+// --- EXTENDED CONTROL FIELD values & masks (extended frame, byte 1) ---
+// The address type and the counter are the ones of the routing field
+#define EXTENDED_CONTROL_FIELD_FORMAT_MASK     B00001111
+#define EXTENDED_CONTROL_FIELD_LDATA_FORMAT    B00000000
+
 // --- COMMAND FIELD values & masks ---
 #define COMMAND_FIELD_HIGH_COMMAND_MASK 0x03 
 #define COMMAND_FIELD_LOW_COMMAND_MASK  0xC0 // 2 first bytes on _commandL
@@ -122,8 +158,8 @@ enum e_KnxTelegramValidity { KNX_TELEGRAM_VALID = 0 ,
 
 class KnxTelegram {
     union {
-        byte _telegram[KNX_TELEGRAM_MAX_SIZE]; // byte 0 to 22
-        struct {
+        byte _telegram[KNX_TELEGRAM_MAX_SIZE]; // byte 0 to 22, up to 262 with the extended frames
+        struct { // standard frame layout, the fields from byte 1 are shifted by 1 byte in the extended frames
         byte _controlField; // byte 0
         byte _sourceAddrH;  // byte 1
         byte _sourceAddrL;  // byte 2
@@ -136,6 +172,16 @@ class KnxTelegram {
       };
     };
 
+    // Shift of the fields of the extended frame from their standard frame position (0 or 1)
+    byte ExtendedShift(void) const;
+    // Index of the field holding the address type and the routing counter
+    byte RoutingIndex(void) const;
+    // Max nb of payload bytes after the 1st one (the frame format max length - 1)
+    byte LongPayloadMaxSize(void) const;
+    // Telegram length limited to KNX_TELEGRAM_MAX_SIZE : the length field of a received extended frame
+    // may give more bytes than stored
+    word StoredLength(void) const;
+
   public:
   // CONSTRUCTOR
     // builds telegram with following default values :
@@ -160,10 +206,15 @@ class KnxTelegram {
     void ChangeRoutingCounter(byte counter);
     byte GetRoutingCounter(void) const;
 
+    // NB : with KNX_TELEGRAM_EXTENDED_MAX_LENGTH, the length selects the frame format (standard up to 15, extended above)
+    //      and is limited to KNX_TELEGRAM_EXTENDED_MAX_LENGTH
     void SetPayloadLength(byte length);
     byte GetPayloadLength(void) const;
 
-    byte GetTelegramLength(void) const;
+    word GetTelegramLength(void) const;
+
+    // Extended frame (L_DATA extended), always false without KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+    boolean IsExtendedFrame(void) const;
 
     void SetCommand(e_KnxCommand cmd);
     e_KnxCommand GetCommand(void) const;
@@ -175,11 +226,11 @@ class KnxTelegram {
 
     // Read of the telegram byte per byte
     // NB : do not check that the index is in the range
-    byte ReadRawByte(byte byteIndex) const;
+    byte ReadRawByte(word byteIndex) const;
 
     // Write of the telegram byte per byte
     // NB : do not check that the index is in the range
-    void WriteRawByte(byte data, byte byteIndex);
+    void WriteRawByte(byte data, word byteIndex);
 
     byte GetChecksum(void) const;
     boolean IsChecksumCorrect(void) const;
@@ -187,6 +238,11 @@ class KnxTelegram {
   // functions NOT INLINED (see definitions in KnxTelegram.cpp)
     void ClearTelegram(void); // (re)set telegram with default values
 
+    // Change the frame format, the header fields and the payload are kept
+    // NB : a payload longer than 15 bytes is truncated by the change to the standard format,
+    //      the call has no effect without KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+    void SetExtendedFrame(boolean extended);
+
     // Set 'nbOfBytes' bytes of the payload starting from the 2nd payload byte
     // if 'nbOfBytes' val is out of range, then we use the max allowed value instead
     void SetLongPayload(const byte origin[], byte  nbOfBytes);
@@ -203,19 +259,41 @@ class KnxTelegram {
 
     // Whole telegram copy
     void Copy(KnxTelegram& dest) const;
-    // Header Copy (6 1st bytes of the telegram)
+    // Header Copy (6 1st bytes of the telegram, 7 for an extended frame)
     void CopyHeader(KnxTelegram& dest) const;
 
     e_KnxTelegramValidity GetValidity(void) const;
 
-  // DEBUG functions :
+#ifndef KNX_NO_HEAP
+  // DEBUG functions (String uses the heap, not available with KNX_NO_HEAP) :
     void Info(String&) const; // copy telegram info into a string
     void InfoRaw(String&) const; // copy raw data telegram into a string
     void InfoVerbose(String&) const; // copy verbose telegram info into a string
+#endif
 };
 
 
 // --------------- Definition of the INLINED functions : -----------------
+inline byte KnxTelegram::ExtendedShift(void) const
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+{ return (_controlField & CONTROL_FIELD_STANDARD_FRAME_FORMAT) ? 0 : 1; }
+#else
+{ return 0; }
+#endif
+
+inline byte KnxTelegram::RoutingIndex(void) const
+{ return ExtendedShift() ? 1 : 5; }
+
+inline byte KnxTelegram::LongPayloadMaxSize(void) const
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+{ return (ExtendedShift() ? KNX_TELEGRAM_EXTENDED_MAX_LENGTH : KNX_TELEGRAM_STANDARD_MAX_LENGTH) - 1; }
+#else
+{ return KNX_TELEGRAM_STANDARD_MAX_LENGTH - 1; }
+#endif
+
+inline boolean KnxTelegram::IsExtendedFrame(void) const
+{ return ExtendedShift(); }
+
 inline void KnxTelegram::ChangePriority(e_KnxPriority priority)
 { _controlField &= ~CONTROL_FIELD_PRIORITY_MASK; _controlField |= priority & CONTROL_FIELD_PRIORITY_MASK;}
     
@@ -231,69 +309,86 @@ inline boolean KnxTelegram::IsRepeated(void) const
 inline void KnxTelegram::SetSourceAddress(word addr) { 
   // WARNING : works with little endianness only
   // The adresses within KNX telegram are big endian
-  _sourceAddrL = (byte) addr; _sourceAddrH = byte(addr>>8);}
+  byte shift = ExtendedShift(); _telegram[2 + shift] = (byte) addr; _telegram[1 + shift] = byte(addr>>8);}
 
 inline word KnxTelegram::GetSourceAddress(void) const {
   // WARNING : works with little endianness only
   // The adresses within KNX telegram are big endian
-  word addr; addr = _sourceAddrL + (_sourceAddrH<<8); return addr; }
+  byte shift = ExtendedShift(); word addr; addr = _telegram[2 + shift] + (_telegram[1 + shift]<<8); return addr; }
 
 inline void KnxTelegram:: SetTargetAddress(word addr) { 
   // WARNING : works with little endianness only
   // The adresses within KNX telegram are big endian
-  _targetAddrL = (byte) addr; _targetAddrH = byte(addr>>8);}
+  byte shift = ExtendedShift(); _telegram[4 + shift] = (byte) addr; _telegram[3 + shift] = byte(addr>>8);}
 
 inline word KnxTelegram::GetTargetAddress(void) const {
  // WARNING : endianess sensitive!! Code below is for LITTLE ENDIAN chip
  // The KNX telegram uses BIG ENDIANNESS (Hight byte placed before Low Byte)
-  word addr; addr = _targetAddrL + (_targetAddrH<<8); return addr; }
+  byte shift = ExtendedShift(); word addr; addr = _telegram[4 + shift] + (_telegram[3 + shift]<<8); return addr; }
 
 inline boolean KnxTelegram::IsMulticast(void) const 
-{return (_routing & ROUTING_FIELD_TARGET_ADDRESS_TYPE_MASK);}
+{return (_telegram[RoutingIndex()] & ROUTING_FIELD_TARGET_ADDRESS_TYPE_MASK);}
 
 inline void KnxTelegram::SetMulticast(boolean mode)
-{ if (mode) _routing|= ROUTING_FIELD_TARGET_ADDRESS_TYPE_MASK;
-  else _routing &= ~ROUTING_FIELD_TARGET_ADDRESS_TYPE_MASK; }
+{ if (mode) _telegram[RoutingIndex()] |= ROUTING_FIELD_TARGET_ADDRESS_TYPE_MASK;
+  else _telegram[RoutingIndex()] &= ~ROUTING_FIELD_TARGET_ADDRESS_TYPE_MASK; }
  
 inline void KnxTelegram::ChangeRoutingCounter(byte counter) 
-{ counter <<= 4; _routing &= ~ROUTING_FIELD_COUNTER_MASK; _routing |= (counter & ROUTING_FIELD_COUNTER_MASK); }
+{ byte& routing = _telegram[RoutingIndex()];
+  counter <<= 4; routing &= ~ROUTING_FIELD_COUNTER_MASK; routing |= (counter & ROUTING_FIELD_COUNTER_MASK); }
 
 inline byte KnxTelegram::GetRoutingCounter(void) const 
-{ return ((_routing & ROUTING_FIELD_COUNTER_MASK)>>4); }
-
-inline void KnxTelegram::SetPayloadLength(byte length) 
-{ _routing&= ~ROUTING_FIELD_PAYLOAD_LENGTH_MASK ; _routing |= length & ROUTING_FIELD_PAYLOAD_LENGTH_MASK; }
-
-inline byte KnxTelegram::GetPayloadLength(void) const 
-{return (_routing & ROUTING_FIELD_PAYLOAD_LENGTH_MASK);}
-
-inline byte KnxTelegram::GetTelegramLength(void) const 
-{ return (KNX_TELEGRAM_LENGTH_OFFSET + GetPayloadLength());}
+{ return ((_telegram[RoutingIndex()] & ROUTING_FIELD_COUNTER_MASK)>>4); }
+
+inline void KnxTelegram::SetPayloadLength(byte length) {
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+  SetExtendedFrame(length > KNX_TELEGRAM_STANDARD_MAX_LENGTH);
+  if (ExtendedShift()) {
+    _telegram[KNX_TELEGRAM_HEADER_SIZE] = (length < KNX_TELEGRAM_EXTENDED_MAX_LENGTH) ? length : KNX_TELEGRAM_EXTENDED_MAX_LENGTH;
+    return;
+  }
+#endif
+  _routing&= ~ROUTING_FIELD_PAYLOAD_LENGTH_MASK ; _routing |= length & ROUTING_FIELD_PAYLOAD_LENGTH_MASK; }
+
+inline byte KnxTelegram::GetPayloadLength(void) const {
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+  if (ExtendedShift()) return _telegram[KNX_TELEGRAM_HEADER_SIZE];
+#endif
+  return (_routing & ROUTING_FIELD_PAYLOAD_LENGTH_MASK);}
+
+inline word KnxTelegram::GetTelegramLength(void) const 
+{ return (KNX_TELEGRAM_LENGTH_OFFSET + ExtendedShift() + (word) GetPayloadLength());}
+
+inline word KnxTelegram::StoredLength(void) const
+{ word length = GetTelegramLength(); return (length < KNX_TELEGRAM_MAX_SIZE) ? length : KNX_TELEGRAM_MAX_SIZE;}
 
 inline void KnxTelegram::SetCommand(e_KnxCommand cmd) {
-  _commandH &= ~COMMAND_FIELD_HIGH_COMMAND_MASK; _commandH |= (cmd >> 2);
-  _commandL &= ~COMMAND_FIELD_LOW_COMMAND_MASK;  _commandL |= (cmd << 6);}
+  byte shift = ExtendedShift();
+  _telegram[6 + shift] &= ~COMMAND_FIELD_HIGH_COMMAND_MASK; _telegram[6 + shift] |= (cmd >> 2);
+  _telegram[7 + shift] &= ~COMMAND_FIELD_LOW_COMMAND_MASK;  _telegram[7 + shift] |= (cmd << 6);}
 
 inline e_KnxCommand KnxTelegram::GetCommand(void) const 
-{return (e_KnxCommand)(((_commandL & COMMAND_FIELD_LOW_COMMAND_MASK)>>6) + ((_commandH & COMMAND_FIELD_HIGH_COMMAND_MASK)<<2)); };
+{ byte shift = ExtendedShift();
+  return (e_KnxCommand)(((_telegram[7 + shift] & COMMAND_FIELD_LOW_COMMAND_MASK)>>6) + ((_telegram[6 + shift] & COMMAND_FIELD_HIGH_COMMAND_MASK)<<2)); };
     
 inline void KnxTelegram::SetFirstPayloadByte(byte data) 
-{ _commandL &= ~COMMAND_FIELD_LOW_DATA_MASK ; _commandL |= data & COMMAND_FIELD_LOW_DATA_MASK; }
+{ byte& commandL = _telegram[7 + ExtendedShift()];
+  commandL &= ~COMMAND_FIELD_LOW_DATA_MASK ; commandL |= data & COMMAND_FIELD_LOW_DATA_MASK; }
 
 inline void KnxTelegram::ClearFirstPayloadByte(void)
-{ _commandL &= ~COMMAND_FIELD_LOW_DATA_MASK;}
+{ _telegram[7 + ExtendedShift()] &= ~COMMAND_FIELD_LOW_DATA_MASK;}
 
 inline byte KnxTelegram::GetFirstPayloadByte(void) const 
-{ return (_commandL & COMMAND_FIELD_LOW_DATA_MASK);}
+{ return (_telegram[7 + ExtendedShift()] & COMMAND_FIELD_LOW_DATA_MASK);}
 
-inline byte KnxTelegram::ReadRawByte(byte byteIndex) const
+inline byte KnxTelegram::ReadRawByte(word byteIndex) const
 { return _telegram[byteIndex];}
 
-inline void KnxTelegram::WriteRawByte(byte data, byte byteIndex)
+inline void KnxTelegram::WriteRawByte(byte data, word byteIndex)
 { _telegram[byteIndex] = data;}
 
 inline byte KnxTelegram::GetChecksum(void) const 
-{ return (_payloadChecksum[GetPayloadLength() - 1]);}
+{ return (_telegram[StoredLength() - 1]);}
 
 inline boolean KnxTelegram::IsChecksumCorrect(void) const 
 { return (GetChecksum()==CalculateChecksum());}
@@ -29,6 +29,10 @@
 #include <ESP8266WiFi.h>
 #endif
 
+#ifdef KNX_NO_HEAP
+#pragma GCC poison malloc free realloc calloc
+#endif
+
 /*
  * !!!!! IMPORTANT !!!!!
  * if "#define DEBUG" is set, you must run your KONNEKTING Suite with "-Dde.root1.slicknx.konnekting.debug=true" 
@@ -75,10 +79,24 @@ SoftwareSerial knxToolsDebugSerial(10, 11); // RX, TX
 #define MSGTYPE_WRITE_PARAMETER             30 // 0x1E
 #define MSGTYPE_READ_PARAMETER              31 // 0x1F
 #define MSGTYPE_ANSWER_PARAMETER            32 // 0x20
+#define MSGTYPE_WRITE_PARAMETER_BLOCK       33 // 0x21
+#define MSGTYPE_READ_PARAMETER_BLOCK        34 // 0x22
+#define MSGTYPE_ANSWER_PARAMETER_BLOCK      35 // 0x23
 
 #define MSGTYPE_WRITE_COM_OBJECT            40 // 0x28
 #define MSGTYPE_READ_COM_OBJECT             41 // 0x29
 #define MSGTYPE_ANSWER_COM_OBJECT           42 // 0x2A
+#define MSGTYPE_WRITE_COM_OBJECT_LISTENING  43 // 0x2B
+#define MSGTYPE_READ_COM_OBJECT_LISTENING   44 // 0x2C
+#define MSGTYPE_ANSWER_COM_OBJECT_LISTENING 45 // 0x2D
+#define MSGTYPE_WRITE_COM_OBJECT_BLOCK      46 // 0x2E
+#define MSGTYPE_READ_COM_OBJECT_BLOCK       47 // 0x2F
+#define MSGTYPE_ANSWER_COM_OBJECT_BLOCK     48 // 0x30
+
+// Block messages : a contiguous range of the parameter table bytes (offset hi, offset lo, nb of bytes, data...)
+// or of com object table entries (first Suite-ID, nb of entries, GA hi/GA lo/settings per entry), one ACK per block
+#define PARAMETER_BLOCK_MAX_SIZE             9 // 14 bytes message - version, type, offset (2 bytes), nb
+#define COM_OBJECT_BLOCK_MAX_NB              3 // 14 bytes message - version, type, first Suite-ID, nb, 3 bytes per entry
 
 // KnxTools unique instance creation
 KnxTools KnxTools::Tools;
@@ -173,6 +191,13 @@ void KnxTools::init(HardwareSerial& serial, int progButtonPin, int progLedPin, w
 
     // calc index of parameter table in eeprom --> depends on number of com objects
     _paramTableStartindex = EEPROM_COMOBJECTTABLE_START + (Knx.getNumberOfComObjects() * 3);
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+    // listening addresses table follows the parameter table, 3 bytes per slot: Suite-ID (0xFF: free slot), GA hi, GA lo
+    _listeningTableStartindex = _paramTableStartindex;
+    for (byte i = 0; i < _numberOfParams; i++) {
+        _listeningTableStartindex += _paramSizeList[i];
+    }
+#endif
 
     _deviceFlags = EEPROM.read(EEPROM_DEVICE_FLAGS);
 
@@ -220,6 +245,31 @@ void KnxTools::init(HardwareSerial& serial, int progButtonPin, int progLedPin, w
             CONSOLEDEBUGLN(F(""));
         }
 
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+        // ComObjects listening addresses
+        for (byte i = 0; i < KNX_DEVICE_LISTENING_ADDRESSES_MAX; i++) {
+            byte comObjId = EEPROM.read(_listeningTableStartindex + (i * 3));
+            if (comObjId == 0xFF) continue; // free slot
+            byte hi = EEPROM.read(_listeningTableStartindex + (i * 3) + 1);
+            byte lo = EEPROM.read(_listeningTableStartindex + (i * 3) + 2);
+            word listeningAddr = (hi << 8) + (lo << 0);
+
+            e_KnxDeviceStatus listeningStatus = Knx.addComObjectListeningAddress((comObjId + 1), listeningAddr);
+
+            CONSOLEDEBUG(F("ComObj listening slot="));
+            CONSOLEDEBUG(i);
+            CONSOLEDEBUG(F(" Suite-ID="));
+            CONSOLEDEBUG(comObjId);
+            CONSOLEDEBUG(F(" GA: 0x"));
+            CONSOLEDEBUG(listeningAddr, HEX);
+            CONSOLEDEBUGLN(F(""));
+            if (listeningStatus != KNX_DEVICE_OK) {
+                CONSOLEDEBUG(F("ComObj listening address rejected, status: 0x"));
+                CONSOLEDEBUGLN(listeningStatus, HEX);
+            }
+        }
+#endif
+
     } else {
         CONSOLEDEBUGLN(F("Using FACTORY"));
     }
@@ -350,7 +400,12 @@ bool KnxTools::isMatchingIA(byte hi, byte lo) {
 
 KnxComObject KnxTools::createProgComObject() {
     CONSOLEDEBUGLN(F("createProgComObject"));
+#ifdef KNX_COM_OBJ_SUPPORT_ALL_PRIORITIES
+    // the programming messages are sent with system priority
+    KnxComObject p = KnxComObject(G_ADDR(15, 7, 255), KNX_DPT_60000_000 /* KNX PROGRAM */, KNX_PRIORITY_SYSTEM_VALUE, KNX_COM_OBJ_C_W_U_T_INDICATOR); /* NEEDS TO BE THERE FOR PROGRAMMING PURPOSE */
+#else
     KnxComObject p = KnxComObject(KNX_DPT_60000_000 /* KNX PROGRAM */, KNX_COM_OBJ_C_W_U_T_INDICATOR); /* NEEDS TO BE THERE FOR PROGRAMMING PURPOSE */
+#endif
     p.SetAddr(G_ADDR(15, 7, 255));
     p.setActive(true);
     return /* Index 0 */ p;
@@ -451,12 +506,32 @@ bool KnxTools::internalComObject(byte index) {
                     case MSGTYPE_READ_PARAMETER:
                         handleMsgReadParameter(buffer);
                         break;
+                    case MSGTYPE_WRITE_PARAMETER_BLOCK:
+                        if (_progState) handleMsgWriteParameterBlock(buffer);
+                        break;
+                    case MSGTYPE_READ_PARAMETER_BLOCK:
+                        handleMsgReadParameterBlock(buffer);
+                        break;
                     case MSGTYPE_WRITE_COM_OBJECT:
                         if (_progState) handleMsgWriteComObject(buffer);
                         break;
                     case MSGTYPE_READ_COM_OBJECT:
                         handleMsgReadComObject(buffer);
                         break;
+                    case MSGTYPE_WRITE_COM_OBJECT_BLOCK:
+                        if (_progState) handleMsgWriteComObjectBlock(buffer);
+                        break;
+                    case MSGTYPE_READ_COM_OBJECT_BLOCK:
+                        handleMsgReadComObjectBlock(buffer);
+                        break;
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+                    case MSGTYPE_WRITE_COM_OBJECT_LISTENING:
+                        if (_progState) handleMsgWriteComObjectListening(buffer);
+                        break;
+                    case MSGTYPE_READ_COM_OBJECT_LISTENING:
+                        handleMsgReadComObjectListening(buffer);
+                        break;
+#endif
                     default:
                         CONSOLEDEBUG(F("Unsupported msgtype: 0x"));
                         CONSOLEDEBUG(msgType, HEX);
@@ -558,6 +633,7 @@ void KnxTools::handleMsgWriteProgrammingMode(byte msg[]) {
 }
 
 void KnxTools::handleMsgReadProgrammingMode(byte msg[]) {
+    (void) msg; // no argument
     CONSOLEDEBUGLN(F("handleMsgReadProgrammingMode"));
     if (_progState) {
         byte response[14];
@@ -600,6 +676,7 @@ void KnxTools::handleMsgWriteIndividualAddress(byte msg[]) {
 }
 
 void KnxTools::handleMsgReadIndividualAddress(byte msg[]) {
+    (void) msg; // no argument
     CONSOLEDEBUGLN(F("handleMsgReadIndividualAddress"));
     byte response[14];
     response[0] = PROTOCOLVERSION;
@@ -683,6 +760,58 @@ void KnxTools::handleMsgReadParameter(byte msg[]) {
 
 }
 
+void KnxTools::handleMsgWriteParameterBlock(byte msg[]) {
+    CONSOLEDEBUGLN(F("handleMsgWriteParameterBlock"));
+
+    int offset = (msg[2] << 8) + (msg[3] << 0);
+    byte nb = msg[4];
+
+#ifdef DEBUG_PROTOCOL
+    CONSOLEDEBUG(F("offset="));
+    CONSOLEDEBUG(offset);
+    CONSOLEDEBUG(F(" nb="));
+    CONSOLEDEBUG(nb);
+    CONSOLEDEBUGLN(F(""))
+#endif
+
+    // the range shall lie within the parameter table
+    if ((nb == 0) || (nb > PARAMETER_BLOCK_MAX_SIZE) || (offset + nb > calcParamSkipBytes(_numberOfParams))) {
+        sendAck(KNX_DEVICE_INVALID_INDEX, msg[3]);
+        return;
+    }
+
+#if defined(WRITEMEM)    
+    for (byte i = 0; i < nb; i++) {
+        memoryUpdate(_paramTableStartindex + offset + i, msg[5 + i]);
+    }
+#endif
+    sendAck(0x00, 0x00);
+}
+
+void KnxTools::handleMsgReadParameterBlock(byte msg[]) {
+    CONSOLEDEBUGLN(F("handleMsgReadParameterBlock"));
+
+    int offset = (msg[2] << 8) + (msg[3] << 0);
+    byte nb = msg[4];
+
+    if ((nb == 0) || (nb > PARAMETER_BLOCK_MAX_SIZE) || (offset + nb > calcParamSkipBytes(_numberOfParams))) {
+        sendAck(KNX_DEVICE_INVALID_INDEX, msg[3]);
+        return;
+    }
+
+    byte response[14];
+    response[0] = PROTOCOLVERSION;
+    response[1] = MSGTYPE_ANSWER_PARAMETER_BLOCK;
+    response[2] = msg[2];
+    response[3] = msg[3];
+    response[4] = nb;
+    for (byte i = 0; i < PARAMETER_BLOCK_MAX_SIZE; i++) {
+        response[5 + i] = (i < nb) ? EEPROM.read(_paramTableStartindex + offset + i) : 0x00;
+    }
+
+    Knx.write(0, response);
+}
+
 void KnxTools::handleMsgWriteComObject(byte msg[]) {
     CONSOLEDEBUGLN(F("handleMsgWriteComObject"));
 
@@ -765,6 +894,136 @@ void KnxTools::handleMsgReadComObject(byte msg[]) {
     Knx.write(0, response);
 }
 
+void KnxTools::handleMsgWriteComObjectBlock(byte msg[]) {
+#ifdef DEBUG_PROTOCOL
+    CONSOLEDEBUGLN(F("handleMsgWriteComObjectBlock"));
+#endif
+
+    byte comObjId = msg[2];
+    byte nb = msg[3];
+
+#ifdef DEBUG_PROTOCOL
+    CONSOLEDEBUG(F("first CO id="));
+    CONSOLEDEBUG(comObjId);
+    CONSOLEDEBUG(F(" nb="));
+    CONSOLEDEBUG(nb);
+    CONSOLEDEBUGLN(F(""));
+#endif
+
+    if ((nb == 0) || (nb > COM_OBJECT_BLOCK_MAX_NB) || (comObjId + nb > Knx.getNumberOfComObjects())) {
+        sendAck(KNX_DEVICE_INVALID_INDEX, comObjId);
+        return;
+    }
+
+#if defined(WRITEMEM)            
+    // GA hi, GA lo and settings of each entry, in the com object table layout
+    for (byte i = 0; i < nb * 3; i++) {
+        memoryUpdate(EEPROM_COMOBJECTTABLE_START + (comObjId * 3) + i, msg[4 + i]);
+    }
+#endif
+
+    sendAck(0x00, 0x00);
+}
+
+void KnxTools::handleMsgReadComObjectBlock(byte msg[]) {
+#ifdef DEBUG_PROTOCOL
+    CONSOLEDEBUGLN(F("handleMsgReadComObjectBlock"));
+#endif
+
+    byte comObjId = msg[2];
+    byte nb = msg[3];
+
+    if ((nb == 0) || (nb > COM_OBJECT_BLOCK_MAX_NB) || (comObjId + nb > Knx.getNumberOfComObjects())) {
+        sendAck(KNX_DEVICE_INVALID_INDEX, comObjId);
+        return;
+    }
+
+    // the entries are read back from the com object table, as they have been written
+    byte response[14];
+    response[0] = PROTOCOLVERSION;
+    response[1] = MSGTYPE_ANSWER_COM_OBJECT_BLOCK;
+    response[2] = comObjId;
+    response[3] = nb;
+    for (byte i = 0; i < COM_OBJECT_BLOCK_MAX_NB * 3; i++) {
+        response[4 + i] = (i < nb * 3) ? EEPROM.read(EEPROM_COMOBJECTTABLE_START + (comObjId * 3) + i) : 0x00;
+    }
+    response[13] = 0x00;
+
+    Knx.write(0, response);
+}
+
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+void KnxTools::handleMsgWriteComObjectListening(byte msg[]) {
+#ifdef DEBUG_PROTOCOL
+    CONSOLEDEBUGLN(F("handleMsgWriteComObjectListening"));
+#endif
+
+    byte slot = msg[2];
+    byte comObjId = msg[3]; // 0xFF frees the slot
+    byte gaHi = msg[4];
+    byte gaLo = msg[5];
+
+#ifdef DEBUG_PROTOCOL
+    CONSOLEDEBUG(F("slot="));
+    CONSOLEDEBUG(slot);
+    CONSOLEDEBUG(F(" CO id="));
+    CONSOLEDEBUG(comObjId);
+    CONSOLEDEBUG(F(" hi=0x"));
+    CONSOLEDEBUG(gaHi, HEX);
+    CONSOLEDEBUG(F(" lo=0x"));
+    CONSOLEDEBUG(gaLo, HEX);
+    CONSOLEDEBUGLN(F(""));
+#endif
+
+    if (slot >= KNX_DEVICE_LISTENING_ADDRESSES_MAX) {
+        sendAck(KNX_DEVICE_INVALID_INDEX, slot);
+        return;
+    }
+    // Suite-ID i is the com object i + 1 (the com object 0 is the programming one)
+    if ((comObjId != 0xFF) && (comObjId >= Knx.getNumberOfComObjects() - 1)) {
+        sendAck(KNX_DEVICE_INVALID_INDEX, comObjId);
+        return;
+    }
+
+#if defined(WRITEMEM)
+    // the listening addresses are taken into account after the next restart, as the com objects addresses
+    memoryUpdate(_listeningTableStartindex + (slot * 3) + 0, comObjId);
+    memoryUpdate(_listeningTableStartindex + (slot * 3) + 1, gaHi);
+    memoryUpdate(_listeningTableStartindex + (slot * 3) + 2, gaLo);
+#endif
+
+    sendAck(0x00, 0x00);
+}
+
+void KnxTools::handleMsgReadComObjectListening(byte msg[]) {
+#ifdef DEBUG_PROTOCOL
+    CONSOLEDEBUGLN(F("handleMsgReadComObjectListening"));
+#endif
+
+    byte slot = msg[2];
+
+    if (slot >= KNX_DEVICE_LISTENING_ADDRESSES_MAX) {
+        sendAck(KNX_DEVICE_INVALID_INDEX, slot);
+        return;
+    }
+
+    byte response[14];
+    response[0] = PROTOCOLVERSION;
+    response[1] = MSGTYPE_ANSWER_COM_OBJECT_LISTENING;
+    response[2] = slot;
+    response[3] = EEPROM.read(_listeningTableStartindex + (slot * 3) + 0); // Suite-ID
+    response[4] = EEPROM.read(_listeningTableStartindex + (slot * 3) + 1); // GA Hi
+    response[5] = EEPROM.read(_listeningTableStartindex + (slot * 3) + 2); // GA Lo
+
+    // fill rest with 0x00
+    for (byte i = 6; i < 13; i++) {
+        response[i] = 0;
+    }
+
+    Knx.write(0, response);
+}
+#endif
+
 void KnxTools::memoryUpdate(int index, byte data) {
 
 
@@ -903,5 +1162,6 @@ int KnxTools::getFreeEepromOffset() {
     for (int i = 0; i < _numberOfParams; i++) {
         offset += _paramSizeList[i];
     }
+    offset += KNX_DEVICE_LISTENING_ADDRESSES_MAX * 3; // listening addresses table
     return offset;
 }
\ No newline at end of file
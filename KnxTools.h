@@ -130,6 +130,9 @@ private:
     byte _revisionID;
 
     int _paramTableStartindex;
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+    int _listeningTableStartindex;
+#endif
 
 
     int _progLED; // default pin D8
@@ -156,8 +159,16 @@ private:
     void handleMsgReadIndividualAddress(byte* msg);
     void handleMsgWriteParameter(byte* msg);
     void handleMsgReadParameter(byte* msg);
+    void handleMsgWriteParameterBlock(byte* msg);
+    void handleMsgReadParameterBlock(byte* msg);
     void handleMsgWriteComObject(byte* msg);
     void handleMsgReadComObject(byte* msg);
+    void handleMsgWriteComObjectBlock(byte* msg);
+    void handleMsgReadComObjectBlock(byte* msg);
+#if KNX_DEVICE_LISTENING_ADDRESSES_MAX > 0
+    void handleMsgWriteComObjectListening(byte* msg);
+    void handleMsgReadComObjectListening(byte* msg);
+#endif
     
     void memoryUpdate(int index, byte date);        
 
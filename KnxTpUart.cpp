@@ -32,6 +32,10 @@
 #include <avr/pgmspace.h>
 #endif
 
+#ifdef KNX_NO_HEAP
+#pragma GCC poison malloc free realloc calloc
+#endif
+
 /*
  * !!!!! IMPORTANT !!!!!
  * if "#define DEBUG" is set, you must run your KONNEKTING Suite with "-Dde.root1.slicknx.konnekting.debug=true" 
@@ -53,6 +57,63 @@ static inline word TimeDeltaWord(word now, word before) {
     return (word) (now - before);
 }
 
+// The RX chars are timestamped on 32 bits : the 2 ms gap of an EOP is found whatever the delay of the
+// RXTask() call, where a 16 bits delta would wrap after 65 ms
+static inline unsigned long TimeDeltaMicros(unsigned long now, unsigned long before) {
+    return now - before;
+}
+
+// Same, 0 for a char received after "now" (timestamped under interrupt once "now" has been read)
+static inline unsigned long TimeSinceMicros(unsigned long now, unsigned long before) {
+    return ((long) (now - before) < 0) ? 0 : now - before;
+}
+
+// A U_L_DataOffset service goes before the data bytes 64, 128, 192... of an extended frame
+static inline byte NeedsDataOffset(word txByteIndex) {
+    return ((txByteIndex >= 64) && !(txByteIndex & 0x3F)) ? 1 : 0;
+}
+
+#if defined(KNXTPUART_RX_ISR)
+KnxTpUart *KnxTpUart::_rxIsrInstance = NULL;
+
+#if defined(HOST_BUILD)
+// The emulated UART calls this hook from its "RX complete" interrupt
+static void HostRxHook(void *context, uint8_t data) {
+    (void) context;
+    KnxTpUart::RxInterruptHandler(data);
+}
+#endif
+#endif
+
+// Order of the index table entries : by address, then by com object index
+static inline boolean IndexEntryLess(const type_tpuart_index_entry& a, const type_tpuart_index_entry& b) {
+    return (a.addr < b.addr) || ((a.addr == b.addr) && (a.index < b.index));
+}
+
+// Move down the entry at "pos" in the max-heap made of the "nb" first entries
+static void SiftDown(type_tpuart_index_entry table[], word pos, word nb) {
+    type_tpuart_index_entry entry = table[pos];
+    for (word child = 2 * pos + 1; child < nb; child = 2 * pos + 1) {
+        if ((child + 1 < nb) && IndexEntryLess(table[child], table[child + 1])) child++;
+        if (!IndexEntryLess(entry, table[child])) break;
+        table[pos] = table[child];
+        pos = child;
+    }
+    table[pos] = entry;
+}
+
+// In place heap sort of the index table (O(n log n), no extra memory)
+static void SortIndexTable(type_tpuart_index_entry table[], word nb) {
+    type_tpuart_index_entry entry;
+    for (word pos = nb / 2; pos > 0; pos--) SiftDown(table, pos - 1, nb);
+    for (word last = nb; last > 1; last--) {
+        entry = table[0];
+        table[0] = table[last - 1];
+        table[last - 1] = entry;
+        SiftDown(table, 0, last - 1);
+    }
+}
+
 #ifdef KNXTPUART_DEBUG_INFO
 const char KnxTpUart::_debugInfoText[] = "KNXTPUART INFO: ";
 #endif
@@ -73,17 +134,44 @@ KnxTpUart::KnxTpUart(HardwareSerial& serial, word physicalAddr, type_KnxTpUartMo
 #endif       
     _rx.state = RX_RESET;
     _rx.addressedComObjectIndex = 0;
+    _rx.pendingComObjectIndex = 0;
+    _rx.addressedComObjectPos = 0;
+    _rx.pendingComObjectPos = 0;
+    _rx.readBytesNb = 0;
+    _rx.charsNb = 0;
+    _rx.lastByteRxTimeMicrosec = 0;
     _tx.state = TX_RESET;
     _tx.sentTelegram = NULL;
     _tx.ackFctPtr = NULL;
     _tx.nbRemainingBytes = 0;
     _tx.txByteIndex = 0;
+    _tx.sentTimeMillisec = 0;
+    _tx.lateConfirmExpected = false;
+    _tx.timeoutBackoffNb = 0;
+    _tx.lateSentTimeMillisec = 0;
+    _tx.lateBusMillis = 0;
+    memset(&_confirmTiming, 0, sizeof(_confirmTiming));
+    _confirmTiming.timeoutMillis = KNXTPUART_CONFIRM_TIMEOUT_MAX_MS;
+#if defined(KNXTPUART_TX_BURST)
+    _tx.uartFreeNb = 0;
+#endif
     _stateIndication = 0;
+    memset(&_busLoad, 0, sizeof(_busLoad));
+    _busLoad.slotStartMillis = millis();
+    memset(&_monitor, 0, sizeof(_monitor)); // MONITOR_IDLE, no monitor buffer
+#if defined(KNX_STATS)
+    memset(&_rxStats, 0, sizeof(_rxStats));
+#endif
     _evtCallbackFct = NULL;
     _comObjectsList = NULL;
-    _assignedComObjectsNb = 0;
+    _indexTableEntriesNb = 0;
     _orderedIndexTable = NULL;
     _stateIndication = 0;
+#if defined(KNXTPUART_ACK_FILTER)
+    _rx.pendingAccepted = false;
+    for (byte i = 0; i < KNXTPUART_ACK_FILTER_SIZE; i++) _ackFilter[i] = 0;
+    _ackFilterFalsePositivesNb = 0;
+#endif
 #if defined(KNXTPUART_DEBUG_INFO) || defined(KNXTPUART_DEBUG_ERROR)
     _debugStrPtr = NULL;
 #endif
@@ -93,7 +181,12 @@ KnxTpUart::KnxTpUart(HardwareSerial& serial, word physicalAddr, type_KnxTpUartMo
 // Destructor
 
 KnxTpUart::~KnxTpUart() {
+#if defined(KNXTPUART_RX_ISR)
+    StopRxInterrupt();
+#endif
+#ifndef KNX_NO_HEAP
     if (_orderedIndexTable) free(_orderedIndexTable);
+#endif
     // close the serial communication if opened
     if ((_rx.state > RX_RESET) || (_tx.state > TX_RESET)) {
         _serial.end();
@@ -109,6 +202,10 @@ byte KnxTpUart::Reset(void) {
     word startTime, nowTime;
     byte attempts = 10;
 
+#if defined(KNXTPUART_RX_ISR)
+    // the reset indication is read by polling
+    StopRxInterrupt();
+#endif
     // HOT RESET case
     if ((_rx.state > RX_RESET) || (_tx.state > TX_RESET)) { 
         // stop the serial communication before restarting it
@@ -128,6 +225,9 @@ byte KnxTpUart::Reset(void) {
                 if (_serial.read() == TPUART_RESET_INDICATION) {
                     _rx.state = RX_INIT;
                     _tx.state = TX_INIT;
+#if defined(KNXTPUART_RX_ISR)
+                    StartRxInterrupt();
+#endif
                     DebugInfo("Reset successful\n");
                     return KNX_TPUART_OK;
                 }
@@ -142,60 +242,83 @@ byte KnxTpUart::Reset(void) {
 
 // Attach a list of com objects
 // NB1 : only the objects with "communication" attribute are considered by the TPUART
-// NB2 : In case of objects with identical address, the object with highest index only is considered
+// NB2 : several objects may share the same address (see IsAddressAssigned())
+// NB3 : the addresses are read once, the list shall be attached again after an address change
+// NB4 : listeningAddresses gives additional (address, index) pairs, a com object listens to
+//       its own address and to all the addresses of the pairs with its index
 // return KNX_TPUART_ERROR_NOT_INIT_STATE (254) if the TPUART is not in Init state
 // The function must be called prior to Init() execution
 
-byte KnxTpUart::AttachComObjectsList(KnxComObject comObjectsList[], byte listSize) {
+#ifdef KNX_NO_HEAP
+byte KnxTpUart::AttachComObjectsList(KnxComObject comObjectsList[], byte listSize, type_tpuart_index_entry orderedIndexTable[],
+                                     const type_tpuart_index_entry listeningAddresses[], byte listeningNb) {
+#else
+byte KnxTpUart::AttachComObjectsList(KnxComObject comObjectsList[], byte listSize,
+                                     const type_tpuart_index_entry listeningAddresses[], byte listeningNb) {
+#endif
 #define IS_COM(index) (comObjectsList[index].GetIndicator() & KNX_COM_OBJ_C_INDICATOR)
-#define ADDR(index) (comObjectsList[index].GetAddr())
+#define IS_LISTENING_COM(l) ((listeningAddresses[l].index < listSize) && IS_COM(listeningAddresses[l].index))
+    word j;
 
     if ((_rx.state != RX_INIT) || (_tx.state != TX_INIT)) return KNX_TPUART_ERROR_NOT_INIT_STATE;
 
     if (_orderedIndexTable) { // a list is already attached, we detach it
+#ifndef KNX_NO_HEAP
         free(_orderedIndexTable);
+#endif
         _orderedIndexTable = NULL;
         _comObjectsList = NULL;
-        _assignedComObjectsNb = 0;
+        _indexTableEntriesNb = 0;
     }
+#if defined(KNXTPUART_ACK_FILTER)
+    for (byte i = 0; i < KNXTPUART_ACK_FILTER_SIZE; i++) _ackFilter[i] = 0;
+#endif
     if ((!comObjectsList) || (!listSize)) {
         DebugInfo("AttachComObjectsList : warning : empty object list!\n");
         return KNX_TPUART_OK;
     }
-    // Count all the com objects with communication indicator
-    for (byte i = 0; i < listSize; i++) if (IS_COM(i)) _assignedComObjectsNb++;
-    if (!_assignedComObjectsNb) {
+    if (!listeningAddresses) listeningNb = 0;
+    // Count all the com objects with communication indicator, and their listening addresses
+    for (byte i = 0; i < listSize; i++) if (IS_COM(i)) _indexTableEntriesNb++;
+    for (byte l = 0; l < listeningNb; l++) if (IS_LISTENING_COM(l)) _indexTableEntriesNb++;
+    if (!_indexTableEntriesNb) {
         DebugInfo("AttachComObjectsList : warning : no object with com attribute in the list!\n");
         return KNX_TPUART_OK;
     }
-    // Deduct the duplicate addresses
+    _comObjectsList = comObjectsList;
+    // Creation of the ordered index table
+#ifdef KNX_NO_HEAP
+    _orderedIndexTable = orderedIndexTable;
+#else
+    _orderedIndexTable = (type_tpuart_index_entry*) malloc(_indexTableEntriesNb * sizeof(type_tpuart_index_entry));
+#endif
+    j = 0;
     for (byte i = 0; i < listSize; i++) {
         if (!IS_COM(i)) continue;
-        for (byte j = 0; j < listSize; j++) {
-            if ((i != j) && (ADDR(j) == ADDR(i)) && (IS_COM(j))) { // duplicate address found
-                if (j < i) break; // duplicate address already treated
-                else {
-                    _assignedComObjectsNb--;
-                    DebugInfo("AttachComObjectsList : warning : duplicate address found!\n");
-                }
-            }
-        }
+        _orderedIndexTable[j].addr = comObjectsList[i].GetAddr();
+        _orderedIndexTable[j].index = i;
+        j++;
     }
-    _comObjectsList = comObjectsList;
-    // Creation of the ordered index table
-    _orderedIndexTable = (byte*) malloc(_assignedComObjectsNb);
-    word minMin = 0x0000; // minimum min value searched  
-    word foundMin = 0xFFFF; // min value found so far
-    for (byte i = 0; i < _assignedComObjectsNb; i++) {
-        for (byte j = 0; j < listSize; j++) {
-            if ((IS_COM(j)) && (ADDR(j) >= minMin) && (ADDR(j) <= foundMin)) {
-                foundMin = ADDR(j);
-                _orderedIndexTable[i] = j;
-            }
+    for (byte l = 0; l < listeningNb; l++) {
+        if (!IS_LISTENING_COM(l)) continue;
+        _orderedIndexTable[j++] = listeningAddresses[l];
+    }
+    SortIndexTable(_orderedIndexTable, _indexTableEntriesNb);
+    // Remove the duplicated pairs, a com object gets each telegram once
+    j = 0;
+    for (word k = 0; k < _indexTableEntriesNb; k++) {
+        if (j && !IndexEntryLess(_orderedIndexTable[j - 1], _orderedIndexTable[k])) continue;
+        _orderedIndexTable[j++] = _orderedIndexTable[k];
+#if defined(KNXTPUART_ACK_FILTER)
+        if (comObjectsList[_orderedIndexTable[k].index].isActive()) {
+            word bit1 = KNXTPUART_ACK_FILTER_BIT1(_orderedIndexTable[k].addr);
+            word bit2 = KNXTPUART_ACK_FILTER_BIT2(_orderedIndexTable[k].addr);
+            _ackFilter[bit1 >> 3] |= 1 << (bit1 & 7);
+            _ackFilter[bit2 >> 3] |= 1 << (bit2 & 7);
         }
-        minMin = foundMin + 1;
-        foundMin = 0xFFFF;
+#endif
     }
+    _indexTableEntriesNb = j;
     DebugInfo("AttachComObjectsList successful\n");
     return KNX_TPUART_OK;
 }
@@ -210,6 +333,11 @@ byte KnxTpUart::Init(void) {
 
     if ((_rx.state != RX_INIT) || (_tx.state != TX_INIT)) return KNX_TPUART_ERROR_NOT_INIT_STATE;
 
+#if defined(KNXTPUART_TX_BURST)
+    // Nothing has been written since the reset answer, the UART TX buffer is empty
+    _tx.uartFreeNb = _serial.availableForWrite();
+#endif
+
     // BUS MONITORING MODE in case it is selected
     if (_mode == BUS_MONITOR) {
         _serial.write(TPUART_ACTIVATEBUSMON_REQ); // Send bus monitoring activation request
@@ -265,138 +393,264 @@ byte KnxTpUart::SendTelegram(KnxTelegram& sentTelegram) {
 // Typical calling period is 400 usec.
 
 void KnxTpUart::RXTask(void) {
-    byte incomingByte;
-    word nowTime;
-    static byte readBytesNb; // Nb of read bytes during an KNX telegram reception
-    static KnxTelegram telegram; // telegram being received
-    static byte addressedComObjectIndex; // index of the com object targeted by the received telegram
-    static word lastByteRxTimeMicrosec;
+    unsigned long nowTime;
+
+    if (_monitor.frames != NULL) { // BUS MONITOR mode with frames assembly
+        MonitorRXTask();
+        return;
+    }
+
+#if defined(KNXTPUART_RX_ISR)
+    // === STEP 1 : Process all the bytes received under interrupt ===
+    // the EOP are detected from the reception time of the bytes, so that a late call does not merge or split telegrams
+    nowTime = micros();
+    type_tpuart_rx_isr_byte rxByte;
+    while (_rxIsrBuffer.Pop(rxByte)) {
+        if ((_rx.state >= RX_KNX_TELEGRAM_RECEPTION_STARTED)
+                && (TimeDeltaMicros(rxByte.timeMicrosec, _rx.lastByteRxTimeMicrosec) > 2000 /* 2 ms */)) RxEndOfPacket();
+        RxByte(rxByte.data, rxByte.timeMicrosec, nowTime);
+        if (_rx.state == RX_STOPPED) return; // TPUART reset
+    }
 
+    // === STEP 2 : Check EOP of the telegram being received ===
+    // the bytes received after "nowTime" are not processed yet, there's no need to read the time again
+    if ((_rx.state >= RX_KNX_TELEGRAM_RECEPTION_STARTED)
+            && (TimeSinceMicros(nowTime, _rx.lastByteRxTimeMicrosec) > 2000 /* 2 ms */)
+            && (_rxIsrBuffer.IsEmpty())) RxEndOfPacket();
+#else
     // === STEP 1 : Check EOP in case a Telegram is being received ===
     if (_rx.state >= RX_KNX_TELEGRAM_RECEPTION_STARTED) { // a telegram reception is ongoing
-        nowTime = (word) micros(); // word cast because a 65ms looping counter is long enough
-        if (TimeDeltaWord(nowTime, lastByteRxTimeMicrosec) > 2000 /* 2 ms */) { // EOP detected, the telegram reception is completed
-
-            switch (_rx.state) {
-                case RX_KNX_TELEGRAM_RECEPTION_STARTED: // we are not supposed to get EOP now, the telegram is incomplete
-                case RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID:
-                    _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR); // Notify telegram reception error
-                    break;
-
-                case RX_KNX_TELEGRAM_RECEPTION_ADDRESSED:
-                    if (telegram.IsChecksumCorrect()) { // checksum correct, let's update the _rx struct with the received telegram and correct index
-                        telegram.Copy(_rx.receivedTelegram);
-                        _rx.addressedComObjectIndex = addressedComObjectIndex;
-                        _evtCallbackFct(TPUART_EVENT_RECEIVED_KNX_TELEGRAM); // Notify the new received telegram
-                    } else { // checksum incorrect, notify error
-                        _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR); // Notify telegram reception error
-                    }
-                    break;
+        nowTime = micros();
+        if (TimeDeltaMicros(nowTime, _rx.lastByteRxTimeMicrosec) > 2000 /* 2 ms */) { // EOP detected, the telegram reception is completed
+            RxEndOfPacket();
+        }
+    }
 
-                    // case RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED : break; // nothing to do!
+    // === STEP 2 : Get New RX Data ===
+    if (_serial.available() > 0) {
+        byte incomingByte = (byte) (_serial.read());
+        nowTime = micros();
+        RxByte(incomingByte, nowTime, nowTime);
+    }
+#endif
+}
 
-                default: break;
-            } // end of switch
 
-            // we move state back to RX IDLE in any case
-            _rx.state = RX_IDLE_WAITING_FOR_CTRL_FIELD;
-        } // end EOP detected
+// End Of Packet, complete the telegram reception
+
+void KnxTpUart::RxEndOfPacket(void) {
+    // Bus load accounting, the telegrams of the device itself are accounted when confirmed
+    if ((_rx.charsNb < 3 + _rx.pendingTelegram.IsExtendedFrame())
+            || (_rx.pendingTelegram.GetSourceAddress() != _physicalAddr)) {
+        type_tpuart_bus_load_slot& slot = CurrentBusLoadSlot();
+        slot.rxBits += KNX_BUS_TELEGRAM_BITS(_rx.charsNb);
+        if (slot.rxTelegramsNb < 0xFF) slot.rxTelegramsNb++;
+        if ((_rx.state == RX_KNX_TELEGRAM_RECEPTION_ADDRESSED) && (slot.addressedNb < 0xFF)) slot.addressedNb++;
     }
 
-    // === STEP 2 : Get New RX Data ===
-    if (_serial.available() > 0) {
-        incomingByte = (byte) (_serial.read());
-        lastByteRxTimeMicrosec = (word) micros();
-
-        switch (_rx.state) {
-            case RX_IDLE_WAITING_FOR_CTRL_FIELD:
-                // CASE OF KNX MESSAGE
-                if ((incomingByte & KNX_CONTROL_FIELD_PATTERN_MASK) == KNX_CONTROL_FIELD_VALID_PATTERN) {
-                    _rx.state = RX_KNX_TELEGRAM_RECEPTION_STARTED;
-                    readBytesNb = 1;
-                    telegram.WriteRawByte(incomingByte, 0);
-                }                    // CASE OF TPUART_DATA_CONFIRM_SUCCESS NOTIFICATION
-                else if (incomingByte == TPUART_DATA_CONFIRM_SUCCESS) {
-                    if (_tx.state == TX_WAITING_ACK) {
-                        _tx.ackFctPtr(ACK_RESPONSE);
-                        _tx.state = TX_IDLE;
-                    } else DebugError("Rx: unexpected TPUART_DATA_CONFIRM_SUCCESS received!\n");
-                }                    // CASE OF TPUART_RESET NOTIFICATION
-                else if (incomingByte == TPUART_RESET_INDICATION) {
-
-                    if ((_tx.state == TX_TELEGRAM_SENDING_ONGOING) || (_tx.state == TX_WAITING_ACK)) { // response to the TP UART transmission
-                        _tx.ackFctPtr(TPUART_RESET_RESPONSE);
-                    }
-                    _tx.state = TX_STOPPED;
-                    _rx.state = RX_STOPPED;
-                    _evtCallbackFct(TPUART_EVENT_RESET); // Notify RESET
-                    return;
-                }                    // CASE OF STATE_INDICATION RESPONSE
-                else if ((incomingByte & TPUART_STATE_INDICATION_MASK) == TPUART_STATE_INDICATION) {
-                    _evtCallbackFct(TPUART_EVENT_STATE_INDICATION); // Notify STATE INDICATION
-                    _stateIndication = incomingByte;
-                    DebugInfo("Rx: State Indication Received\n");
-                }                    // CASE OF TPUART_DATA_CONFIRM_FAILED NOTIFICATION
-                else if (incomingByte == TPUART_DATA_CONFIRM_FAILED) {
-                    // NACK following Telegram transmission
-                    if (_tx.state == TX_WAITING_ACK) {
-                        _tx.ackFctPtr(NACK_RESPONSE);
-                        _tx.state = TX_IDLE;
-                    } else DebugError("Rx: unexpected TPUART_DATA_CONFIRM_FAILED received!\n");
-                }                    // UNKNOWN CONTROL FIELD RECEIVED
-                else if (incomingByte)
-                    DebugError("Rx: Unknown Control Field received\n");
-                // else ignore "0" value sent on Reset by TPUART prior to TPUART_RESET_INDICATION
+    switch (_rx.state) {
+        case RX_KNX_TELEGRAM_RECEPTION_STARTED: // we are not supposed to get EOP now, the telegram is incomplete
+            KNXTPUART_STATS_INC(_rxStats.incompleteNb);
+            _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR); // Notify telegram reception error
+            break;
+
+        case RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID:
+            KNXTPUART_STATS_INC(_rxStats.lengthInvalidNb);
+            _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR); // Notify telegram reception error
+            break;
+
+        case RX_KNX_TELEGRAM_RECEPTION_ADDRESSED:
+#if defined(KNXTPUART_ACK_FILTER)
+            // the telegram has been accepted by the filter, look for the targeted com object now
+            if (!LookupPendingTelegram()) {
+                if (_ackFilterFalsePositivesNb < 0xFFFF) _ackFilterFalsePositivesNb++;
                 break;
+            }
+#endif
+            if (_rx.readBytesNb != _rx.pendingTelegram.GetTelegramLength()) { // EOP before the length given by the telegram
+                KNXTPUART_STATS_INC(_rxStats.incompleteNb);
+                _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR); // Notify telegram reception error
+            } else if (_rx.pendingTelegram.IsChecksumCorrect()) { // checksum correct, let's update the _rx struct with the received telegram and correct index
+                _rx.pendingTelegram.Copy(_rx.receivedTelegram);
+                _rx.addressedComObjectIndex = _rx.pendingComObjectIndex;
+                _rx.addressedComObjectPos = _rx.pendingComObjectPos;
+                _evtCallbackFct(TPUART_EVENT_RECEIVED_KNX_TELEGRAM); // Notify the new received telegram
+            } else { // checksum incorrect, notify error
+                KNXTPUART_STATS_INC(_rxStats.checksumErrorsNb);
+                _evtCallbackFct(TPUART_EVENT_KNX_TELEGRAM_RECEPTION_ERROR); // Notify telegram reception error
+            }
+            break;
 
-            case RX_KNX_TELEGRAM_RECEPTION_STARTED:
-                telegram.WriteRawByte(incomingByte, readBytesNb);
-                readBytesNb++;
+            // case RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED : break; // nothing to do!
 
-                if (readBytesNb == 3) { // We have just received the source address
-                    // we check whether the received KNX telegram is coming from us (i.e. telegram is sent by the TPUART itself)
-                    if (telegram.GetSourceAddress() == _physicalAddr) { // the message is coming from us, we consider it as not addressed and we don't send any ACK service
-                        _rx.state = RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
-                    }
-                } else if (readBytesNb == 6) // We have just read the routing field containing the address type and the payload length
-                { // We check if the message is addressed to us in order to send the appropriate acknowledge
-                    if (IsAddressAssigned(telegram.GetTargetAddress(), addressedComObjectIndex)) { // Message addressed to us
-                        _rx.state = RX_KNX_TELEGRAM_RECEPTION_ADDRESSED;
-                        //sent the correct ACK service now
-                        // the ACK info must be sent latest 1,7 ms after receiving the address type octet of an addressed frame
-                        _serial.write(TPUART_RX_ACK_SERVICE_ADDRESSED);
-
-                        // dirty workaround fpr sending ACk just before reset?
-                        //              _serial.flush();
-                    } else { // Message NOT addressed to us
-                        _rx.state = RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
-                        //sent the correct ACK service now
-                        // the ACK info must be sent latest 1,7 ms after receiving the address type octet of an addressed frame
-                        _serial.write(TPUART_RX_ACK_SERVICE_NOT_ADDRESSED);
-
-                        // dirty workaround fpr sending ACk just before reset?
-                        //              _serial.flush();
-                    }
+        default: break;
+    } // end of switch
+
+    // we move state back to RX IDLE in any case
+    _rx.state = RX_IDLE_WAITING_FOR_CTRL_FIELD;
+}
+
+
+// Process one byte of the TPUART RX stream received at "rxTime"
+// "nowTime" is used to check the ACK service deadline
+
+void KnxTpUart::RxByte(byte incomingByte, unsigned long rxTime, unsigned long nowTime) {
+    byte extendedShift; // the fields of an extended frame come 1 byte later (see KnxTelegram.h)
+
+    _rx.lastByteRxTimeMicrosec = rxTime;
+    // all the chars of the telegram being received use the bus, even the ignored ones
+    if ((_rx.state >= RX_KNX_TELEGRAM_RECEPTION_STARTED) && (_rx.charsNb < 0xFFFF)) _rx.charsNb++;
+
+    switch (_rx.state) {
+        case RX_IDLE_WAITING_FOR_CTRL_FIELD:
+            // CASE OF KNX MESSAGE
+            if ((incomingByte & KNX_CONTROL_FIELD_PATTERN_MASK) == KNX_CONTROL_FIELD_VALID_PATTERN) {
+                _rx.state = RX_KNX_TELEGRAM_RECEPTION_STARTED;
+                _rx.readBytesNb = 1;
+                _rx.charsNb = 1;
+                _rx.pendingTelegram.WriteRawByte(incomingByte, 0);
+            }                    // CASE OF TPUART_DATA_CONFIRM_SUCCESS NOTIFICATION
+            else if (incomingByte == TPUART_DATA_CONFIRM_SUCCESS) {
+                if (AcceptTxConfirm()) {
+                    AccountTxTelegram();
+                    _tx.state = TX_IDLE; // before the callback, so that it can send the next telegram
+                    _tx.ackFctPtr(ACK_RESPONSE);
                 }
-                break;
+            }                    // CASE OF TPUART_RESET NOTIFICATION
+            else if (incomingByte == TPUART_RESET_INDICATION) {
 
-            case RX_KNX_TELEGRAM_RECEPTION_ADDRESSED:
-                if (readBytesNb == KNX_TELEGRAM_MAX_SIZE) _rx.state = RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID;
-                else {
-                    telegram.WriteRawByte(incomingByte, readBytesNb);
-                    readBytesNb++;
+                if ((_tx.state == TX_TELEGRAM_SENDING_ONGOING) || (_tx.state == TX_WAITING_ACK)) { // response to the TP UART transmission
+                    _tx.ackFctPtr(TPUART_RESET_RESPONSE);
                 }
-                break;
+                _tx.state = TX_STOPPED;
+                _rx.state = RX_STOPPED;
+                _evtCallbackFct(TPUART_EVENT_RESET); // Notify RESET
+                return;
+            }                    // CASE OF STATE_INDICATION RESPONSE
+            else if ((incomingByte & TPUART_STATE_INDICATION_MASK) == TPUART_STATE_INDICATION) {
+                _evtCallbackFct(TPUART_EVENT_STATE_INDICATION); // Notify STATE INDICATION
+                _stateIndication = incomingByte;
+                DebugInfo("Rx: State Indication Received\n");
+            }                    // CASE OF TPUART_DATA_CONFIRM_FAILED NOTIFICATION
+            else if (incomingByte == TPUART_DATA_CONFIRM_FAILED) {
+                // NACK following Telegram transmission
+                if (AcceptTxConfirm()) {
+                    AccountTxTelegram();
+                    _tx.state = TX_IDLE; // before the callback, so that it can send the next telegram
+                    _tx.ackFctPtr(NACK_RESPONSE);
+                }
+            }                    // UNKNOWN CONTROL FIELD RECEIVED
+            else if (incomingByte)
+                DebugError("Rx: Unknown Control Field received\n");
+            // else ignore "0" value sent on Reset by TPUART prior to TPUART_RESET_INDICATION
+            break;
+
+        case RX_KNX_TELEGRAM_RECEPTION_STARTED:
+            _rx.pendingTelegram.WriteRawByte(incomingByte, _rx.readBytesNb);
+            _rx.readBytesNb++;
+            extendedShift = _rx.pendingTelegram.IsExtendedFrame() ? 1 : 0;
+
+            if (_rx.readBytesNb == 3 + extendedShift) { // We have just received the source address
+                // we check whether the received KNX telegram is coming from us (i.e. telegram is sent by the TPUART itself)
+                if (_rx.pendingTelegram.GetSourceAddress() == _physicalAddr) { // the message is coming from us, we consider it as not addressed and we don't send any ACK service
+                    _rx.state = RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
+                }
+            }
+#if defined(KNXTPUART_ACK_FILTER)
+            else if (_rx.readBytesNb == 5 + extendedShift) { // We have just received the target address
+                // The ACK service is decided by the filter, the index lookup is done at EOP
+                // The routing field comes 1 bus char (1,35 ms) later, so the ACK deadline is 1,1 ms + 1 bus char from now
+                // (the address type of an extended frame is already known, its deadline starts now)
+                _rx.pendingAccepted = IsAddressAccepted(_rx.pendingTelegram.GetTargetAddress());
+                if (TimeSinceMicros(nowTime, rxTime) > (extendedShift ? 1100 : 1100 + 1300) /* 1,7 ms - 1 char (+ 1 bus char) */) {
+                    KNXTPUART_STATS_INC(_rxStats.ackDeadlineMissedNb);
+                    DebugError("Rx: ACK service deadline missed\n");
+                } else {
+                    // sent the correct ACK service now
+                    _serial.write(_rx.pendingAccepted ? TPUART_RX_ACK_SERVICE_ADDRESSED : TPUART_RX_ACK_SERVICE_NOT_ADDRESSED);
+                }
+            }
+            if (_rx.readBytesNb == 6) { // We have just read the routing field (the target address of an extended frame)
+                _rx.state = _rx.pendingAccepted ? RX_KNX_TELEGRAM_RECEPTION_ADDRESSED : RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
+            }
+#else
+            else if (_rx.readBytesNb == 6) // We have just read the routing field containing the address type and the payload length
+            { // (or the target address of an extended frame, the address type being in its extended control field)
+              // We check if the message is addressed to us in order to send the appropriate acknowledge
+                boolean addressed = LookupPendingTelegram();
+                _rx.state = addressed ? RX_KNX_TELEGRAM_RECEPTION_ADDRESSED : RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED;
+                // the ACK info must be sent latest 1,7 ms after receiving the address type octet of an addressed frame
+                // i.e. the write must start at the latest 1,1 ms after, the ACK service char itself takes 0,58ms.
+                // A late ACK service would be applied by the TPUART to the next frame, so we don't send it at all
+                // (the telegram is then repeated by its sender)
+                if (TimeSinceMicros(nowTime, rxTime) > 1100 /* 1,7 ms - 1 char */) {
+                    KNXTPUART_STATS_INC(_rxStats.ackDeadlineMissedNb);
+                    DebugError("Rx: ACK service deadline missed\n");
+                } else {
+                    // sent the correct ACK service now
+                    _serial.write(addressed ? TPUART_RX_ACK_SERVICE_ADDRESSED : TPUART_RX_ACK_SERVICE_NOT_ADDRESSED);
+                }
+            }
+#endif
+            break;
+
+        case RX_KNX_TELEGRAM_RECEPTION_ADDRESSED:
+            if (_rx.readBytesNb == KNX_TELEGRAM_MAX_SIZE) _rx.state = RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID;
+            else {
+                _rx.pendingTelegram.WriteRawByte(incomingByte, _rx.readBytesNb);
+                _rx.readBytesNb++;
+            }
+            break;
+
+            //  case RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID : break; // if the message is too long, nothing to do except waiting for EOP
+            //  case RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED : break; // if the message is not addressed, nothing to do except waiting for EOP
+
+        default: break;
+    } // switch (_rx.state)
+}
 
-                //  case RX_KNX_TELEGRAM_RECEPTION_LENGTH_INVALID : break; // if the message is too long, nothing to do except waiting for EOP
-                //  case RX_KNX_TELEGRAM_RECEPTION_NOT_ADDRESSED : break; // if the message is not addressed, nothing to do except waiting for EOP
 
-            default: break;
-        } // switch (_rx.state)
-    } // if (_serial.available() > 0)
+#if defined(KNXTPUART_RX_ISR)
+// Route the bytes received under interrupt to this instance
+
+void KnxTpUart::StartRxInterrupt(void) {
+    noInterrupts();
+    _rxIsrBuffer.Clear();
+    _rxIsrInstance = this;
+    interrupts();
+#if defined(HOST_BUILD)
+    _serial.SetRxHook(HostRxHook, NULL);
+#endif
 }
 
 
+// Stop routing the bytes received under interrupt to this instance
+
+void KnxTpUart::StopRxInterrupt(void) {
+#if defined(HOST_BUILD)
+    _serial.SetRxHook(NULL, NULL);
+#endif
+    noInterrupts();
+    if (_rxIsrInstance == this) _rxIsrInstance = NULL;
+    interrupts();
+}
+
+
+// UART RX interrupt entry point (KNXTPUART_RX_ISR mode)
+// The byte is timestamped and queued for RXTask()
+
+void KnxTpUart::RxInterruptHandler(byte data) {
+    KnxTpUart *tpuart = _rxIsrInstance;
+    if (!tpuart) return; // no TPUART ready
+
+    type_tpuart_rx_isr_byte rxByte;
+    rxByte.data = data;
+    rxByte.timeMicrosec = micros();
+    tpuart->_rxIsrBuffer.Append(rxByte); // the byte is lost (and counted) if the buffer is full
+}
+#endif
+
+
 // Transmission task
 // This function shall be called periodically in order to allow a correct transmission of the KNX bus data
 // Assuming the TP-Uart speed is configured to 19200 baud, a character (8 data + 1 start + 1 parity + 1 stop)
@@ -404,25 +658,28 @@ void KnxTpUart::RXTask(void) {
 // Sending one byte of a telegram consists in transmitting 2 characters (1,16ms)
 // Let's wait around 800us between each telegram piece sending so that the 64byte TX buffer remains almost empty.
 // Typical calling period is 800 usec.
+// With KNXTPUART_TX_BURST, each call tops the UART TX buffer up to KNXTPUART_TX_BURST_MAX_BYTES queued bytes instead
+// of writing one piece, the sending still pauses while the ACK of a telegram being received is pending.
 
 void KnxTpUart::TXTask(void) {
     word nowTime;
-    byte txByte[2];
-    static word sentMessageTimeMillisec;
+    byte txByte[3], pieceNb;
 
     // STEP 1 : Manage Message Acknowledge timeout
     switch (_tx.state) {
         case TX_WAITING_ACK:
-            // A transmission ACK is awaited, increment Acknowledge timeout
-            nowTime = (word) millis(); // word is enough to count up to 500
-            if (TimeDeltaWord(nowTime, sentMessageTimeMillisec) > 500 /* 500 ms */) { // The no-answer timeout value is defined as follows :
-                // - The emission duration for a single max sized telegram is 40ms
-                // - The telegram emission might be repeated 3 times (120ms) 
-                // - The telegram emission might be delayed by another message transmission ongoing
-                // - The telegram emission might be delayed by the simultaneous transmission of higher prio messages
-                // Let's take around 3 times the max emission duration (160ms) as arbitrary value
+            // A transmission ACK is awaited for the timeout computed when the telegram has been written (see ConfirmTimeout())
+            nowTime = (word) millis();
+            if (TimeDeltaWord(nowTime, _tx.sentTimeMillisec) > _confirmTiming.timeoutMillis) {
+                // the confirm may still come if the timeout was too short, it is then accounted as late (see AcceptTxConfirm())
+                _tx.lateConfirmExpected = true;
+                _tx.lateSentTimeMillisec = _tx.sentTimeMillisec;
+                _tx.lateBusMillis = TelegramBusMillis(_tx.sentTelegram->GetTelegramLength());
+                if (_confirmTiming.timeoutsNb != 0xFFFF) _confirmTiming.timeoutsNb++;
+                // the next timeouts back off toward KNXTPUART_CONFIRM_TIMEOUT_MAX_MS till a confirm comes
+                if (_tx.timeoutBackoffNb < 3) _tx.timeoutBackoffNb++;
+                _tx.state = TX_IDLE; // before the callback, so that it can send the next telegram
                 _tx.ackFctPtr(NO_ANSWER_TIMEOUT); // Send a No Answer TIMEOUT
-                _tx.state = TX_IDLE;
             }
             break;
 
@@ -432,19 +689,31 @@ void KnxTpUart::TXTask(void) {
             // we block the transmission (for around 3,3ms) till the ACK is sent
             // In that way, the TX buffer will remain empty and the ACK will be sent immediately
             if (_rx.state != RX_KNX_TELEGRAM_RECEPTION_STARTED) {
+#if defined(KNXTPUART_TX_BURST)
+                // Burst mode : write (control field, data byte) pairs as long as the UART TX buffer holds less than
+                // KNXTPUART_TX_BURST_MAX_BYTES bytes, so that an ACK service written behind them remains in time
+                while ((_tx.state == TX_TELEGRAM_SENDING_ONGOING)
+                       && (_tx.uartFreeNb - _serial.availableForWrite() + 2 + NeedsDataOffset(_tx.txByteIndex)
+                           <= KNXTPUART_TX_BURST_MAX_BYTES))
+#endif
                 {
+                    // the index of the bytes of an extended frame from 64 on is extended by a U_L_DataOffset service,
+                    // sent when the offset changes : the TPUART keeps it for the next bytes of the frame
+                    pieceNb = 0;
+                    if (NeedsDataOffset(_tx.txByteIndex)) txByte[pieceNb++] = TPUART_DATA_OFFSET_REQ + (_tx.txByteIndex >> 6);
                     if (_tx.nbRemainingBytes == 1) { // We are sending the last byte, i.e checksum
-                        txByte[0] = TPUART_DATA_END_REQ + _tx.txByteIndex;
-                        txByte[1] = _tx.sentTelegram->ReadRawByte(_tx.txByteIndex);
-                        _serial.write(txByte, 2); // write the UART control field and the data byte
+                        txByte[pieceNb++] = TPUART_DATA_END_REQ + (_tx.txByteIndex & 0x3F);
+                        txByte[pieceNb++] = _tx.sentTelegram->ReadRawByte(_tx.txByteIndex);
+                        _serial.write(txByte, pieceNb); // write the UART control field(s) and the data byte
 
                         // Message sending completed
-                        sentMessageTimeMillisec = (word) millis(); // memorize sending time in order to manage ACK timeout
+                        _tx.sentTimeMillisec = (word) millis(); // memorize sending time in order to manage ACK timeout
+                        _confirmTiming.timeoutMillis = ConfirmTimeout();
                         _tx.state = TX_WAITING_ACK;
                     } else {
-                        txByte[0] = TPUART_DATA_START_CONTINUE_REQ + _tx.txByteIndex;
-                        txByte[1] = _tx.sentTelegram->ReadRawByte(_tx.txByteIndex);
-                        _serial.write(txByte, 2); // write the UART control field and the data byte
+                        txByte[pieceNb++] = TPUART_DATA_START_CONTINUE_REQ + (_tx.txByteIndex & 0x3F);
+                        txByte[pieceNb++] = _tx.sentTelegram->ReadRawByte(_tx.txByteIndex);
+                        _serial.write(txByte, pieceNb); // write the UART control field(s) and the data byte
                         _tx.txByteIndex++;
                         _tx.nbRemainingBytes--;
                     }
@@ -457,21 +726,368 @@ void KnxTpUart::TXTask(void) {
 }
 
 
+// Time (in usec) left before RXTask() needs to be called
+// A reception is completed by an EOP, i.e. 2 ms without any byte received
+
+unsigned long KnxTpUart::GetRxDeadline(unsigned long nowTime) const {
+    unsigned long elapsedTime;
+
+#if defined(KNXTPUART_RX_ISR)
+    if (!_rxIsrBuffer.IsEmpty()) return 0; // received bytes to be processed
+#else
+    if (_serial.available() > 0) return 0; // received bytes to be read
+#endif
+    if (_monitor.state != MONITOR_IDLE) { // EOP or ACK window of the frame being received
+        word timeout = (_monitor.state == MONITOR_RECEIVING) ? 2000 : KNXTPUART_MONITOR_ACK_WINDOW_US;
+        elapsedTime = TimeDeltaMicros(nowTime, _monitor.lastByteRxTimeMicrosec);
+        return (elapsedTime > timeout) ? 0 : timeout + 1 - elapsedTime;
+    }
+    if (_rx.state < RX_KNX_TELEGRAM_RECEPTION_STARTED) return KNX_TPUART_NO_DEADLINE;
+    // NB : a byte received after nowTime gives a huge delta, i.e. a null deadline (an early call is harmless)
+    elapsedTime = TimeDeltaMicros(nowTime, _rx.lastByteRxTimeMicrosec);
+    if (elapsedTime > 2000 /* 2 ms */) return 0; // EOP to be processed
+    return 2001 - elapsedTime;
+}
+
+
+// Time (in usec) left before TXTask() needs to be called
+
+unsigned long KnxTpUart::GetTxDeadline(void) const {
+    word elapsedTime;
+
+    switch (_tx.state) {
+        case TX_TELEGRAM_SENDING_ONGOING: return 0;
+
+        case TX_WAITING_ACK: // the ACK timeout (see TXTask()) is the only deadline
+            elapsedTime = TimeDeltaWord((word) millis(), _tx.sentTimeMillisec);
+            if (elapsedTime > _confirmTiming.timeoutMillis) return 0;
+            return (_confirmTiming.timeoutMillis + 1 - elapsedTime) * 1000UL;
+
+        default: return KNX_TPUART_NO_DEADLINE;
+    }
+}
+
+
+// Attach the frames ring of the BUS MONITOR mode
+
+byte KnxTpUart::AttachMonitorBuffer(type_tpuart_monitor_frame frames[], byte framesNb) {
+    if ((_rx.state != RX_INIT) || (_tx.state != TX_INIT)) return KNX_TPUART_ERROR_NOT_INIT_STATE;
+    if ((_mode != BUS_MONITOR) || (frames == NULL) || (!framesNb)) return KNX_TPUART_ERROR;
+    _monitor.frames = frames;
+    _monitor.framesNb = framesNb;
+    _monitor.readPos = _monitor.storedNb = 0;
+    _monitor.state = MONITOR_IDLE;
+    return KNX_TPUART_OK;
+}
+
+
+// Get the oldest captured frame out of the ring
+
+boolean KnxTpUart::GetMonitorFrame(type_tpuart_monitor_frame& frame) {
+    if (!_monitor.storedNb) return false;
+    type_tpuart_monitor_frame& stored = _monitor.frames[_monitor.readPos];
+    frame.timeMicrosec = stored.timeMicrosec;
+    frame.charsNb = stored.charsNb;
+    frame.status = stored.status;
+    frame.ack = stored.ack;
+    // the chars stored, whatever the length field of the frame gives (unknown format, incomplete or oversized frame)
+    word charsNb = (stored.charsNb < KNX_TELEGRAM_MAX_SIZE) ? stored.charsNb : KNX_TELEGRAM_MAX_SIZE;
+    for (word i = 0; i < charsNb; i++) frame.telegram.WriteRawByte(stored.telegram.ReadRawByte(i), i);
+    if (++_monitor.readPos == _monitor.framesNb) _monitor.readPos = 0;
+    _monitor.storedNb--;
+    return true;
+}
+
+
+// Reception task of the BUS MONITOR mode
+// The chars are assembled into frames : the frame ends with the length given by its routing field (or with
+// an EOP for an unknown frame format), a char received within KNXTPUART_MONITOR_ACK_WINDOW_US is its ACK char
+
+void KnxTpUart::MonitorRXTask(void) {
+#if defined(KNXTPUART_RX_ISR)
+    type_tpuart_rx_isr_byte rxByte;
+    while (_rxIsrBuffer.Pop(rxByte)) MonitorByte(rxByte.data, rxByte.timeMicrosec);
+    // the time is read after the bytes processing, a byte received meanwhile is processed at the next call
+    unsigned long nowTime = micros();
+    if (_rxIsrBuffer.IsEmpty()) MonitorCheckTimeouts(nowTime);
+#else
+    MonitorCheckTimeouts(micros());
+    if (_serial.available() > 0) {
+        byte incomingByte = (byte) (_serial.read());
+        MonitorByte(incomingByte, micros());
+    }
+#endif
+}
+
+
+// Process one char received at "rxTime" in BUS MONITOR mode
+
+void KnxTpUart::MonitorByte(byte data, unsigned long rxTime) {
+    MonitorCheckTimeouts(rxTime);
+    switch (_monitor.state) {
+        case MONITOR_WAITING_ACK: // the char follows the frame within the ACK window
+            if (_monitor.frame != NULL) {
+                _monitor.frame->ack = data;
+                _monitor.frame->status |= KNX_MONITOR_FRAME_ACK;
+            }
+            MonitorStoreFrame();
+            return;
+
+        case MONITOR_IDLE: // control field of a new frame
+            if (_monitor.storedNb < _monitor.framesNb) {
+                byte writePos = _monitor.readPos + _monitor.storedNb;
+                if (writePos >= _monitor.framesNb) writePos -= _monitor.framesNb;
+                _monitor.frame = &_monitor.frames[writePos];
+                _monitor.frame->timeMicrosec = rxTime;
+                _monitor.frame->status = 0;
+                _monitor.frame->ack = 0;
+            } else _monitor.frame = NULL; // ring full, the frame is lost
+            _monitor.charsNb = 0;
+            _monitor.expectedNb = 0;
+            _monitor.checksum = 0;
+            _monitor.state = MONITOR_RECEIVING;
+            break;
+
+        default: break;
+    }
+
+    // MONITOR_RECEIVING
+    if (_monitor.frame != NULL) {
+        if (_monitor.charsNb < KNX_TELEGRAM_MAX_SIZE) _monitor.frame->telegram.WriteRawByte(data, _monitor.charsNb);
+        else _monitor.frame->status |= KNX_MONITOR_FRAME_TRUNCATED;
+    }
+    if (_monitor.charsNb < 0xFFFF) _monitor.charsNb++;
+    _monitor.checksum ^= data;
+    _monitor.lastByteRxTimeMicrosec = rxTime;
+    // the routing field gives the length of the standard frames, the length field the one of the extended frames
+    if ((_monitor.frame != NULL) && (_monitor.charsNb == KNX_TELEGRAM_HEADER_SIZE + _monitor.frame->telegram.IsExtendedFrame())
+            && ((_monitor.frame->telegram.ReadRawByte(0) & KNX_CONTROL_FIELD_PATTERN_MASK) == KNX_CONTROL_FIELD_VALID_PATTERN)) {
+        if (_monitor.frame->telegram.IsExtendedFrame()) _monitor.expectedNb = data + KNX_TELEGRAM_LENGTH_OFFSET + 1;
+        else _monitor.expectedNb = (data & 0x0F) + KNX_TELEGRAM_LENGTH_OFFSET;
+    }
+    if (_monitor.charsNb == _monitor.expectedNb) _monitor.state = MONITOR_WAITING_ACK;
+}
+
+
+// Complete the frame being received once its EOP or its ACK window is reached at "nowTime"
+
+void KnxTpUart::MonitorCheckTimeouts(unsigned long nowTime) {
+    unsigned long elapsedTime = TimeDeltaMicros(nowTime, _monitor.lastByteRxTimeMicrosec);
+
+    if ((_monitor.state == MONITOR_RECEIVING) && (elapsedTime > 2000 /* 2 ms */)) { // EOP
+        if ((_monitor.expectedNb) && (_monitor.frame != NULL)) _monitor.frame->status |= KNX_MONITOR_FRAME_INCOMPLETE;
+        _monitor.state = MONITOR_WAITING_ACK;
+    }
+    if ((_monitor.state == MONITOR_WAITING_ACK) && (elapsedTime > KNXTPUART_MONITOR_ACK_WINDOW_US)) MonitorStoreFrame(); // no ACK
+}
+
+
+// Store the received frame into the ring (or account it as lost)
+
+void KnxTpUart::MonitorStoreFrame(void) {
+    type_tpuart_bus_load_slot& slot = CurrentBusLoadSlot();
+    slot.rxBits += KNX_BUS_TELEGRAM_BITS(_monitor.charsNb);
+    if (slot.rxTelegramsNb < 0xFF) slot.rxTelegramsNb++;
+
+    if (_monitor.frame != NULL) {
+        _monitor.frame->charsNb = _monitor.charsNb;
+        if (_monitor.checksum == 0xFF) _monitor.frame->status |= KNX_MONITOR_FRAME_CHECKSUM_OK;
+        if (_monitor.lost) _monitor.frame->status |= KNX_MONITOR_FRAMES_LOST;
+        _monitor.lost = false;
+        _monitor.storedNb++;
+    } else {
+        _monitor.lost = true;
+        if (_monitor.lostFramesNb < 0xFFFF) _monitor.lostFramesNb++;
+    }
+    _monitor.state = MONITOR_IDLE;
+}
+
+
+// Bus load statistics over the last "slotsNb" completed slots
+
+boolean KnxTpUart::GetBusLoad(byte slotsNb, type_tpuart_bus_load& busLoad) {
+    unsigned long rxBits = 0, txBits = 0, capacityBits;
+    byte slot;
+
+    CurrentBusLoadSlot();
+    if (slotsNb > _busLoad.completedSlotsNb) slotsNb = _busLoad.completedSlotsNb;
+    busLoad.periodMillis = slotsNb * (word) KNXTPUART_BUS_LOAD_SLOT_MS;
+    busLoad.rxTelegramsNb = busLoad.addressedNb = busLoad.txTelegramsNb = 0;
+    busLoad.utilizationPercent = busLoad.rxUtilizationPercent = 0;
+    if (!slotsNb) return false;
+
+    slot = _busLoad.currentSlot;
+    for (byte i = 0; i < slotsNb; i++) {
+        slot = slot ? slot - 1 : KNXTPUART_BUS_LOAD_SLOTS_NB - 1; // previous slot
+        rxBits += _busLoad.slots[slot].rxBits;
+        txBits += _busLoad.slots[slot].txBits;
+        busLoad.rxTelegramsNb += _busLoad.slots[slot].rxTelegramsNb;
+        busLoad.addressedNb += _busLoad.slots[slot].addressedNb;
+        busLoad.txTelegramsNb += _busLoad.slots[slot].txTelegramsNb;
+    }
+    capacityBits = (unsigned long) busLoad.periodMillis * KNX_BUS_BIT_RATE / 1000;
+    txBits = ((rxBits + txBits) * 100) / capacityBits; // all the telegrams
+    rxBits = (rxBits * 100) / capacityBits;
+    busLoad.utilizationPercent = (txBits < 100) ? txBits : 100; // the char times are nominal ones
+    busLoad.rxUtilizationPercent = (rxBits < 100) ? rxBits : 100;
+    return true;
+}
+
+
+// Start the new bus load slots up to now, and return the slot being filled
+
+type_tpuart_bus_load_slot& KnxTpUart::CurrentBusLoadSlot(void) {
+    unsigned long elapsedTime = millis() - _busLoad.slotStartMillis;
+
+    if (elapsedTime >= KNXTPUART_BUS_LOAD_SLOTS_NB * (unsigned long) KNXTPUART_BUS_LOAD_SLOT_MS) {
+        // no activity for the whole window, all the slots are empty
+        memset(_busLoad.slots, 0, sizeof(_busLoad.slots));
+        _busLoad.completedSlotsNb = KNXTPUART_BUS_LOAD_SLOTS_NB;
+        _busLoad.slotStartMillis += elapsedTime - (elapsedTime % KNXTPUART_BUS_LOAD_SLOT_MS);
+    } else {
+        while (elapsedTime >= KNXTPUART_BUS_LOAD_SLOT_MS) {
+            _busLoad.currentSlot = (_busLoad.currentSlot + 1) % KNXTPUART_BUS_LOAD_SLOTS_NB;
+            memset(&_busLoad.slots[_busLoad.currentSlot], 0, sizeof(type_tpuart_bus_load_slot));
+            if (_busLoad.completedSlotsNb < KNXTPUART_BUS_LOAD_SLOTS_NB) _busLoad.completedSlotsNb++;
+            _busLoad.slotStartMillis += KNXTPUART_BUS_LOAD_SLOT_MS;
+            elapsedTime -= KNXTPUART_BUS_LOAD_SLOT_MS;
+        }
+    }
+    return _busLoad.slots[_busLoad.currentSlot];
+}
+
+
+// Account a confirmed telegram of the device in the bus load
+
+void KnxTpUart::AccountTxTelegram(void) {
+    type_tpuart_bus_load_slot& slot = CurrentBusLoadSlot();
+    slot.txBits += KNX_BUS_TELEGRAM_BITS(_tx.sentTelegram->GetTelegramLength());
+    if (slot.txTelegramsNb < 0xFF) slot.txTelegramsNb++;
+}
+
+
+// Bus time (in msec, rounded up) of a sent telegram of "charsNb" chars, idle time before it included
+
+word KnxTpUart::TelegramBusMillis(word charsNb) {
+    return (word) (((unsigned long) (KNX_BUS_TELEGRAM_BITS(charsNb) + KNX_BUS_IDLE_BITS) * 1000 + KNX_BUS_BIT_RATE - 1)
+                   / KNX_BUS_BIT_RATE);
+}
+
+
+// ACK timeout of the sent telegram : bus time of the telegram and of its repetitions, plus the bus access delay
+// estimate (mean + KNXTPUART_CONFIRM_TIMEOUT_K mean deviations), doubled for each ACK timeout in a row.
+// A 9 chars telegram takes 20 ms on the bus, i.e. 80 ms with its 3 repetitions
+// The max timeout is extended by the bus time of the chars of an extended frame beyond the standard frame max size
+
+word KnxTpUart::ConfirmTimeout(void) const {
+    word charsNb = _tx.sentTelegram->GetTelegramLength();
+    unsigned long maxTimeout = KNXTPUART_CONFIRM_TIMEOUT_MAX_MS;
+    if (charsNb > KNX_TELEGRAM_STANDARD_MAX_SIZE) {
+        maxTimeout += (TelegramBusMillis(charsNb) - TelegramBusMillis(KNX_TELEGRAM_STANDARD_MAX_SIZE))
+                      * (unsigned long) (KNXTPUART_CONFIRM_REPETITIONS + 1);
+    }
+    if (!_confirmTiming.samplesNb) return maxTimeout; // no estimate yet
+    unsigned long timeout = (unsigned long) TelegramBusMillis(charsNb) * (KNXTPUART_CONFIRM_REPETITIONS + 1)
+                            + (((unsigned long) _confirmTiming.delayMeanX8
+                                + KNXTPUART_CONFIRM_TIMEOUT_K * (unsigned long) _confirmTiming.delayDeviationX8 + 7) >> 3);
+    timeout <<= _tx.timeoutBackoffNb;
+    if (timeout < KNXTPUART_CONFIRM_TIMEOUT_MIN_MS) return KNXTPUART_CONFIRM_TIMEOUT_MIN_MS;
+    return (timeout < maxTimeout) ? timeout : maxTimeout;
+}
+
+
+// Update the confirm latency estimate with the confirm latency of a telegram (TCP retransmission timeout smoothing) :
+// mean += (delay - mean) / 8, deviation += (|delay - mean| - deviation) / 4
+
+void KnxTpUart::UpdateConfirmTiming(word latencyMillis, word busMillis) {
+    word delay = (latencyMillis > busMillis) ? latencyMillis - busMillis : 0;
+    if (delay > 4000) delay = 4000; // the estimates in 1/8 msec fit in a word
+
+    if (!_confirmTiming.samplesNb) { // first confirm
+        _confirmTiming.delayMeanX8 = delay << 3;
+        _confirmTiming.delayDeviationX8 = delay << 2;
+    } else {
+        int error = (int) delay - (int) (_confirmTiming.delayMeanX8 >> 3);
+        _confirmTiming.delayMeanX8 += error;
+        if (error < 0) error = -error;
+        _confirmTiming.delayDeviationX8 += 2 * error - (_confirmTiming.delayDeviationX8 >> 2);
+    }
+    if (_confirmTiming.samplesNb != 0xFFFF) _confirmTiming.samplesNb++;
+}
+
+
+// Check a Data_Confirm against the telegram waiting for it, and update the confirm latency estimate
+// After an ACK timeout, the late confirm of the timed out telegram cannot be told from the one of the next telegram,
+// unless the next telegram is not waiting for its confirm yet or has not had the time to be sent on the bus (its
+// frame and ACK char, the idle time before it is not awaited on an idle bus)
+
+boolean KnxTpUart::AcceptTxConfirm(void) {
+    word nowTime = (word) millis();
+
+    if (_tx.lateConfirmExpected) {
+        _tx.lateConfirmExpected = false;
+        word minLatency = KNX_BUS_TELEGRAM_BITS(_tx.sentTelegram->GetTelegramLength()) * 1000UL / KNX_BUS_BIT_RATE - 1;
+        if ((_tx.state != TX_WAITING_ACK) || (TimeDeltaWord(nowTime, _tx.sentTimeMillisec) < minLatency)) {
+            // late confirm : the estimate learns the actual latency, so that the next timeouts are longer
+            UpdateConfirmTiming(TimeDeltaWord(nowTime, _tx.lateSentTimeMillisec), _tx.lateBusMillis);
+            _tx.timeoutBackoffNb = 0;
+            if (_confirmTiming.lateConfirmsNb != 0xFFFF) _confirmTiming.lateConfirmsNb++;
+            return false;
+        }
+    }
+    if (_tx.state != TX_WAITING_ACK) {
+        DebugError("Rx: unexpected TPUART_DATA_CONFIRM received!\n");
+        return false;
+    }
+    UpdateConfirmTiming(TimeDeltaWord(nowTime, _tx.sentTimeMillisec), TelegramBusMillis(_tx.sentTelegram->GetTelegramLength()));
+    _tx.timeoutBackoffNb = 0;
+    return true;
+}
+
+
 // Get Bus monitoring data (BUS MONITORING mode)
 // The function returns true if a new data has been retrieved (data pointer in argument), else false
 // It shall be called periodically (max period of 0,5ms) in order to allow correct data reception
 // Typical calling period is 400 usec.
 
 boolean KnxTpUart::GetMonitoringData(type_MonitorData& data) {
-    word nowTime;
+    unsigned long nowTime;
     static type_MonitorData currentData = {true, 0};
-    static word lastByteRxTimeMicrosec;
+    static unsigned long lastByteRxTimeMicrosec;
 
+#if defined(KNXTPUART_RX_ISR)
+    // STEP 1 : Get New RX Data, the EOP are detected from the reception time of the bytes
+    type_tpuart_rx_isr_byte rxByte;
+    if (_rxIsrBuffer.Peek(rxByte)) {
+        if ((!currentData.isEOP) && (TimeDeltaMicros(rxByte.timeMicrosec, lastByteRxTimeMicrosec) > 2000 /* 2 ms */)) { // EOP before this byte
+            currentData.isEOP = true;
+            currentData.dataByte = 0;
+            data = currentData;
+            return true;
+        }
+        _rxIsrBuffer.Pop(rxByte);
+        currentData.dataByte = rxByte.data;
+        currentData.isEOP = false;
+        data = currentData;
+        lastByteRxTimeMicrosec = rxByte.timeMicrosec;
+        return true;
+    }
+    // STEP 2 : Check EOP
+    if (!(currentData.isEOP)) {
+        nowTime = micros();
+        if ((TimeSinceMicros(nowTime, lastByteRxTimeMicrosec) > 2000 /* 2 ms */) && (_rxIsrBuffer.IsEmpty())) { // EOP detected
+            currentData.isEOP = true;
+            currentData.dataByte = 0;
+            data = currentData;
+            return true;
+        }
+    }
+#else
     // STEP 1 : Check EOP
     if (!(currentData.isEOP)) // check that we have not already detected an EOP
     {
-        nowTime = (word) micros(); // word cast because a 65ms counter is enough
-        if (TimeDeltaWord(nowTime, lastByteRxTimeMicrosec) > 2000 /* 2 ms */) { // EOP detected
+        nowTime = micros();
+        if (TimeDeltaMicros(nowTime, lastByteRxTimeMicrosec) > 2000 /* 2 ms */) { // EOP detected
             currentData.isEOP = true;
             currentData.dataByte = 0;
             data = currentData;
@@ -483,56 +1099,104 @@ boolean KnxTpUart::GetMonitoringData(type_MonitorData& data) {
         currentData.dataByte = (byte) (_serial.read());
         currentData.isEOP = false;
         data = currentData;
-        lastByteRxTimeMicrosec = (word) micros();
+        lastByteRxTimeMicrosec = micros();
         return true;
     }
+#endif
     return false; // No data received
 }
 
 
-// Check if the target address is an assigned com object one
+// Check if the target address is an active assigned com object one
 // if yes, then update index parameter with the index (in the list) of the targeted com object and return true
 // else return false
+// In case of several com objects with the address, the one with the lowest index is returned
 
 boolean KnxTpUart::IsAddressAssigned(word addr, byte &index) const {
-    byte divisionCounter = 0;
-    byte i, searchIndexStart, searchIndexStop, searchIndexRange;
-
-    if (!_assignedComObjectsNb) return false; // in case of empty list, we return immediately
-
-    // Define how many divisions by 2 shall be done in order to reduce the search list by 8 Addr max
-    // if _assignedComObjectsNb >= 16 => divisionCounter = 1
-    // if _assignedComObjectsNb >= 32 => divisionCounter = 2
-    // if _assignedComObjectsNb >= 64 => divisionCounter = 3
-    // if _assignedComObjectsNb >= 128 => divisionCounter = 4    
-    for (i = 4; _assignedComObjectsNb >> i; i++) divisionCounter++;
-
-    // the starting point is to search on the whole address range (0 -> _assignedComObjectsNb -1)
-    searchIndexStart = 0;
-    searchIndexStop = _assignedComObjectsNb - 1;
-    searchIndexRange = _assignedComObjectsNb;
-
-    // reduce the address range if needed
-    while (divisionCounter) {
-        searchIndexRange >>= 1; // Divide range width by 2
-        if (addr >= _comObjectsList[_orderedIndexTable[searchIndexStart + searchIndexRange]].GetAddr())
-            searchIndexStart += searchIndexRange;
-        else searchIndexStop -= searchIndexRange;
-        divisionCounter--;
-    }
-
-    // search the address value and index in the reduced range
-    for (i = searchIndexStart; ((_comObjectsList[_orderedIndexTable[i]].GetAddr() != addr) && (i <= searchIndexStop)); i++);
-    if (i > searchIndexStop) return false; // Address is NOT part of the assigned addresses
-    // Address is part of the assigned addresses
-    index = _orderedIndexTable[i];
-    if (_comObjectsList[index].isActive()) {
-        // CO is found AND is active
-        return true;
-    } else {
-        // CO is found but is NOT active
-        return false;
+    if (!_indexTableEntriesNb) return false; // in case of empty list, we return immediately
+    word pos = LowerBound(addr, 0);
+    return FindActiveComObject(addr, pos, index);
+}
+
+
+// Get the next active com object assigned to the address, after the com object "index"
+// if found, then update index parameter and return true, else return false
+
+boolean KnxTpUart::GetNextAssignedComObject(word addr, byte &index) const {
+    if ((!_indexTableEntriesNb) || (index == 0xFF)) return false;
+    word pos = LowerBound(addr, index + 1);
+    return FindActiveComObject(addr, pos, index);
+}
+
+
+// Check if a com object of lower index than "index" has the address as its own one and no valid value yet
+// The entries of the listening addresses are skipped, the com object own address is checked
+
+boolean KnxTpUart::HasLowerInvalidComObject(word addr, byte index) const {
+    for (word pos = LowerBound(addr, 0);
+         (pos < _indexTableEntriesNb) && (_orderedIndexTable[pos].addr == addr) && (_orderedIndexTable[pos].index < index); pos++) {
+        const KnxComObject& comObject = _comObjectsList[_orderedIndexTable[pos].index];
+        if ((comObject.GetAddr() == addr) && (!comObject.GetValidity())) return true;
+    }
+    return false;
+}
+
+
+// Iterate over all the active com objects targeted by the last received telegram, by increasing index
+// return false when there is no more com object
+
+boolean KnxTpUart::GetTargetedComObject(byte &cursor, byte &index) const {
+    word pos = _rx.addressedComObjectPos + cursor;
+
+    if (!FindActiveComObject(_rx.receivedTelegram.GetTargetAddress(), pos, index)) return false;
+    cursor = (byte) (pos - _rx.addressedComObjectPos + 1); // the next call starts after the com object found
+    return true;
+}
+
+
+// Look for the com object targeted by the telegram being received (_rx.pendingComObjectxxx update)
+
+boolean KnxTpUart::LookupPendingTelegram(void) {
+    word addr = _rx.pendingTelegram.GetTargetAddress();
+
+    if (!_indexTableEntriesNb) return false;
+    _rx.pendingComObjectPos = LowerBound(addr, 0);
+    return FindActiveComObject(addr, _rx.pendingComObjectPos, _rx.pendingComObjectIndex);
+}
+
+
+// Position in _orderedIndexTable of the first entry greater or equal to (addr, index) (binary search)
+// return _indexTableEntriesNb if there is no such entry
+
+word KnxTpUart::LowerBound(word addr, byte index) const {
+    type_tpuart_index_entry key;
+    word first = 0, count = _indexTableEntriesNb, step;
+
+    key.addr = addr;
+    key.index = index;
+    while (count) { // invariant : the searched entry is in [first, first + count]
+        step = count >> 1;
+        if (IndexEntryLess(_orderedIndexTable[first + step], key)) {
+            first += step + 1;
+            count -= step + 1;
+        } else count = step;
+    }
+    return first;
+}
+
+
+// Get the first active com object of _orderedIndexTable with the address, starting from position "pos"
+// pos is updated with the position of the com object found
+
+boolean KnxTpUart::FindActiveComObject(word addr, word &pos, byte &index) const {
+    for (; (pos < _indexTableEntriesNb) && (_orderedIndexTable[pos].addr == addr); pos++) {
+        if (_comObjectsList[_orderedIndexTable[pos].index].isActive()) {
+            // CO is found AND is active
+            index = _orderedIndexTable[pos].index;
+            return true;
+        }
     }
+    return false; // Address is NOT part of the assigned addresses, or all its COs are inactive
 }
 
 
@@ -24,13 +24,15 @@
 // Author : Franck Marini
 // Modified: Alexander Christian <info(at)root1.de>
 // Description : Communication with TPUART
-// Module dependencies : HardwareSerial, KnxTelegram, KnxComObject
+// Module dependencies : HardwareSerial, KnxTelegram, KnxComObject, ActionSpscRingBuffer
 
 // This library supports both TPUART version 1 and 2
 // The Siemens KNX TPUART version 1 datasheet is available at :
 // http://www.hqs.sbt.siemens.com/Lowvoltage/gamma_product_data/gamma-b2b/tpuart.pdf
 // The Siemens KNX TPUART version 2 datasheet is available at :
 // http://www.hqs.sbt.siemens.com/Lowvoltage/gamma_product_data/gamma-b2b/TPUART2_technical-data.pdf
+// The extended frames (see KNX_TELEGRAM_EXTENDED_MAX_LENGTH in KnxTelegram.h) longer than 64 bytes are sent
+// with the U_L_DataOffset service of the TPUART version 2
 
 #ifndef KNXTPUART_H
 #define KNXTPUART_H
@@ -39,11 +41,90 @@
 #include "HardwareSerial.h"
 #include "KnxTelegram.h"
 #include "KnxComObject.h"
+#include "ActionSpscRingBuffer.h"
 
 // !!!!!!!!!!!!!!! FLAG OPTIONS !!!!!!!!!!!!!!!!!
 // DEBUG :
 // #define KNXTPUART_DEBUG_INFO   // Uncomment to activate info traces
 // #define KNXTPUART_DEBUG_ERROR  // Uncomment to activate error traces
+// RX MODE :
+// #define KNXTPUART_RX_ISR       // Uncomment to get the TPUART bytes from the UART RX interrupt (see RxInterruptHandler())
+// ACK DECISION :
+// #define KNXTPUART_ACK_FILTER   // Uncomment to decide the ACK service with an address filter as soon as the target address is received
+// TX MODE :
+// #define KNXTPUART_TX_BURST     // Uncomment to hand a telegram to the TPUART as fast as the UART TX buffer allows (see TXTask())
+
+#if defined(KNX_NO_HEAP) && (defined(KNXTPUART_DEBUG_INFO) || defined(KNXTPUART_DEBUG_ERROR))
+#error "KNXTPUART debug traces use String (heap), they are not available with KNX_NO_HEAP"
+#endif
+
+#ifndef KNXTPUART_RX_ISR_BUFFER_SIZE
+#define KNXTPUART_RX_ISR_BUFFER_SIZE 32 // Nb of bytes buffered between the RX interrupt and RXTask(), power of 2 (32 bytes = 18ms of bus data, 5 bytes of RAM each)
+#endif
+
+#ifndef KNXTPUART_TX_BURST_MAX_BYTES
+// Max nb of bytes queued in the UART TX buffer in burst mode
+// An ACK service written when a reception starts waits for these bytes (0,57 ms each at 19200 baud), 12 bytes still
+// let it reach the TPUART before the 1,7 ms deadline counted from the routing field (6th char of the telegram)
+#define KNXTPUART_TX_BURST_MAX_BYTES 12
+#endif
+
+// BUS LOAD MONITORING :
+// The bus time of the received and sent telegrams is accounted in KNXTPUART_BUS_LOAD_SLOTS_NB slots of
+// KNXTPUART_BUS_LOAD_SLOT_MS, the statistics are given over the last completed slots (sliding window)
+#ifndef KNXTPUART_BUS_LOAD_SLOT_MS
+#define KNXTPUART_BUS_LOAD_SLOT_MS 1000
+#endif
+#ifndef KNXTPUART_BUS_LOAD_SLOTS_NB
+#define KNXTPUART_BUS_LOAD_SLOTS_NB 8
+#endif
+
+static_assert((KNXTPUART_BUS_LOAD_SLOT_MS >= 100) && (KNXTPUART_BUS_LOAD_SLOT_MS <= 4000),
+              "KNXTPUART_BUS_LOAD_SLOT_MS shall be in the 100 to 4000 range"); // a slot holds up to 255 telegrams
+static_assert((KNXTPUART_BUS_LOAD_SLOTS_NB >= 1) && (KNXTPUART_BUS_LOAD_SLOTS_NB * KNXTPUART_BUS_LOAD_SLOT_MS <= 60000),
+              "KNXTPUART_BUS_LOAD_SLOTS_NB shall be in the 1 to (60000 / KNXTPUART_BUS_LOAD_SLOT_MS) range");
+
+// BUS MONITOR FRAMES :
+// Max time (in usec) from the last char of a frame to the bus ACK char. The ACK char ends 26 bit times (2,7 ms)
+// after the frame, the next frame cannot start before 50 more bit times
+#ifndef KNXTPUART_MONITOR_ACK_WINDOW_US
+#define KNXTPUART_MONITOR_ACK_WINDOW_US 4000
+#endif
+
+static_assert((KNXTPUART_MONITOR_ACK_WINDOW_US > 2000) && (KNXTPUART_MONITOR_ACK_WINDOW_US < 6000),
+              "KNXTPUART_MONITOR_ACK_WINDOW_US shall be in the 2000 to 6000 range");
+
+// CONFIRM TIMEOUT :
+// The Data_Confirm of a sent telegram is awaited for the bus time of the telegram and of its
+// KNXTPUART_CONFIRM_REPETITIONS repetitions (3 by default in the TPUART, on NACK or BUSY), plus the measured bus
+// access delay : mean + KNXTPUART_CONFIRM_TIMEOUT_K mean deviations (see GetConfirmTiming()).
+// The timeout is kept in the KNXTPUART_CONFIRM_TIMEOUT_MIN_MS to KNXTPUART_CONFIRM_TIMEOUT_MAX_MS range, it is
+// KNXTPUART_CONFIRM_TIMEOUT_MAX_MS till the first confirm. It is doubled after each timeout till the next confirm
+// The max is extended by the bus time (repetitions included) of the chars of the extended frames beyond 23 chars
+#ifndef KNXTPUART_CONFIRM_REPETITIONS
+#define KNXTPUART_CONFIRM_REPETITIONS 3
+#endif
+#ifndef KNXTPUART_CONFIRM_TIMEOUT_K
+#define KNXTPUART_CONFIRM_TIMEOUT_K 4
+#endif
+#ifndef KNXTPUART_CONFIRM_TIMEOUT_MIN_MS
+#define KNXTPUART_CONFIRM_TIMEOUT_MIN_MS 40
+#endif
+#ifndef KNXTPUART_CONFIRM_TIMEOUT_MAX_MS
+#define KNXTPUART_CONFIRM_TIMEOUT_MAX_MS 500
+#endif
+
+static_assert(KNXTPUART_CONFIRM_REPETITIONS <= 7, "KNXTPUART_CONFIRM_REPETITIONS shall be in the 0 to 7 range");
+static_assert((KNXTPUART_CONFIRM_TIMEOUT_K >= 1) && (KNXTPUART_CONFIRM_TIMEOUT_K <= 8),
+              "KNXTPUART_CONFIRM_TIMEOUT_K shall be in the 1 to 8 range");
+static_assert((KNXTPUART_CONFIRM_TIMEOUT_MIN_MS > 0) && (KNXTPUART_CONFIRM_TIMEOUT_MIN_MS <= KNXTPUART_CONFIRM_TIMEOUT_MAX_MS)
+              && (KNXTPUART_CONFIRM_TIMEOUT_MAX_MS <= 4000), "Invalid confirm timeout values");
+
+#ifndef KNXTPUART_ACK_FILTER_SIZE
+// Nb of bytes of the ACK filter, power of 2 from 8 to 256
+// With about 2 bytes per com object address, less than 2% of the telegrams to other addresses get an ACK
+#define KNXTPUART_ACK_FILTER_SIZE 32
+#endif
 
 
 // Values returned by the KnxTpUart member functions :
@@ -54,6 +135,16 @@
 #define KNX_TPUART_ERROR_NULL_ACK_CALLBACK_FCT 252
 #define KNX_TPUART_ERROR_RESET                 251
 
+// Value returned by GetRxDeadline() and GetTxDeadline() when the task needs no call
+#define KNX_TPUART_NO_DEADLINE         0xFFFFFFFFUL
+
+// KNX TP1 bus time (in bit times, 9600 bit/s) of a telegram of "charsNb" chars : 11 bits per char and 2 bits pause
+// between the chars, then 15 bits pause and the 11 bits ACK char
+#define KNX_BUS_BIT_RATE               9600
+#define KNX_BUS_TELEGRAM_BITS(charsNb) (13 * (word) (charsNb) + 24)
+// Min bus idle time (in bit times) before a telegram is sent
+#define KNX_BUS_IDLE_BITS              50
+
 
 // Services to TPUART (hostcontroller -> TPUART) :
 #define TPUART_RESET_REQ                     0x01
@@ -61,6 +152,7 @@
 #define TPUART_SET_ADDR_REQ                  0x28
 #define TPUART_DATA_START_CONTINUE_REQ       0x80
 #define TPUART_DATA_END_REQ                  0x40
+#define TPUART_DATA_OFFSET_REQ               0x08 // TPUART version 2, index of the next data request / 64
 #define TPUART_ACTIVATEBUSMON_REQ            0x05
 #define TPUART_RX_ACK_SERVICE_ADDRESSED      0x11
 #define TPUART_RX_ACK_SERVICE_NOT_ADDRESSED  0x10
@@ -76,8 +168,13 @@
 #define TPUART_DATA_CONFIRM_FAILED            0x0B
 #define TPUART_STATE_INDICATION               0x07
 #define TPUART_STATE_INDICATION_MASK          0x07
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+#define KNX_CONTROL_FIELD_PATTERN_MASK   B01010011
+#define KNX_CONTROL_FIELD_VALID_PATTERN  B00010000 // Standard "10" and Extended "00" Frame Formats are handled
+#else
 #define KNX_CONTROL_FIELD_PATTERN_MASK   B11010011
 #define KNX_CONTROL_FIELD_VALID_PATTERN  B10010000 // Only Standard Frame Format "10" is handled
+#endif
 
 // Mask for STATE INDICATION service
 #define TPUART_STATE_INDICATION_SLAVE_COLLISION_MASK  0x80
@@ -120,8 +217,42 @@ typedef struct {
                                 // A TPUART_EVENT_RECEIVED_KNX_TELEGRAM event notifies each content change
   byte addressedComObjectIndex; // Where the index to the targeted com object is stored (the value is overwritten on each telegram reception)
                                 // A TPUART_EVENT_RECEIVED_KNX_TELEGRAM event notifies each content change
+  KnxTelegram pendingTelegram;  // Telegram being received
+  byte pendingComObjectIndex;   // Index of the com object targeted by the telegram being received
+  word addressedComObjectPos;   // Position in the ordered index table of the com object targeted by the received telegram
+  word pendingComObjectPos;     // Position in the ordered index table of the com object targeted by the telegram being received
+  word readBytesNb;             // Nb of bytes of the telegram being received
+#if defined(KNXTPUART_ACK_FILTER)
+  boolean pendingAccepted;      // Target address of the telegram being received accepted by the ACK filter
+#endif
+  word charsNb;                 // Nb of chars of the telegram being received, including the ignored ones
+  unsigned long lastByteRxTimeMicrosec; // Reception time of the last byte
 } type_tpuart_rx;
 
+#if defined(KNX_STATS)
+// Reception errors (see GetRxStats()), the counters saturate
+typedef struct {
+  word checksumErrorsNb;     // addressed telegrams with an incorrect checksum
+  word lengthInvalidNb;      // addressed telegrams longer than KNX_TELEGRAM_MAX_SIZE
+  word incompleteNb;         // telegrams ended before their routing field, or addressed ones shorter than their length
+  word ackDeadlineMissedNb;  // telegrams whose ACK service has not been sent in time
+} type_tpuart_rx_stats;
+#endif
+
+#if defined(KNXTPUART_RX_ISR)
+// Byte received under interrupt, with its reception time
+typedef struct {
+  byte data;
+  unsigned long timeMicrosec; // 32 bits, so that a late RXTask() call still finds the EOP between 2 bytes
+} type_tpuart_rx_isr_byte;
+#endif
+
+// Entry of the com objects table ordered by increasing (address, index)
+typedef struct {
+  word addr;  // Group address of the com object
+  byte index; // Index of the com object in the attached list
+} type_tpuart_index_entry;
+
 // --- Definitions for the TRANSMISSION  part ----
 // Transmission states
 enum e_TpUartTxState {
@@ -148,11 +279,104 @@ typedef struct tpuart_tx {
   e_TpUartTxState state;            // Current TPUART TX state
   KnxTelegram *sentTelegram;        // Telegram being sent
   type_AckCallbackFctPtr ackFctPtr; // Pointer to callback function for TX ack
-  byte nbRemainingBytes;            // Nb of bytes remaining to be transmitted
-  byte txByteIndex;                 // Index of the byte to be sent
+  word nbRemainingBytes;            // Nb of bytes remaining to be transmitted
+  word txByteIndex;                 // Index of the byte to be sent
+  word sentTimeMillisec;            // Time the last telegram piece has been written (ACK timeout start)
+  boolean lateConfirmExpected;      // the last ACK timeout elapsed, its confirm may still come
+  byte timeoutBackoffNb;            // nb of ACK timeouts in a row, each one doubles the next timeout (3 max)
+  word lateSentTimeMillisec;        // sentTimeMillisec of the timed out telegram
+  word lateBusMillis;               // bus time of the timed out telegram
+#if defined(KNXTPUART_TX_BURST)
+  int uartFreeNb;                   // availableForWrite() value of the empty UART TX buffer
+#endif
 } type_tpuart_tx;
 
 
+// Confirm latency estimate (see GetConfirmTiming())
+// The bus access delay of a telegram is its confirm latency (from the last piece written to the Data_Confirm) minus
+// its bus time, it covers the wait for a free bus and the repetitions. The mean and the mean deviation are smoothed
+// over the last 8 and 4 confirms (as TCP does for its retransmission timeout)
+typedef struct {
+  word samplesNb;         // nb of confirms measured (saturated)
+  word delayMeanX8;       // mean bus access delay (in 1/8 msec)
+  word delayDeviationX8;  // mean deviation of the bus access delay (in 1/8 msec)
+  word timeoutMillis;     // ACK timeout of the last sent telegram
+  word timeoutsNb;        // telegrams without confirm within their ACK timeout (saturated)
+  word lateConfirmsNb;    // confirms received after the ACK timeout of their telegram (saturated)
+} type_tpuart_confirm_timing;
+
+
+// --- Definitions for the BUS LOAD monitoring ----
+// Bus activity during a slot of KNXTPUART_BUS_LOAD_SLOT_MS
+typedef struct {
+  word rxBits;         // bus time of the received telegrams (bit times)
+  word txBits;         // bus time of the sent telegrams (bit times)
+  byte rxTelegramsNb;  // nb of received telegrams
+  byte addressedNb;    // nb of received telegrams addressed to the device
+  byte txTelegramsNb;  // nb of sent telegrams (positive or negative confirm)
+} type_tpuart_bus_load_slot;
+
+typedef struct {
+  type_tpuart_bus_load_slot slots[KNXTPUART_BUS_LOAD_SLOTS_NB];
+  byte currentSlot;              // slot being filled
+  byte completedSlotsNb;         // nb of completed slots, up to KNXTPUART_BUS_LOAD_SLOTS_NB
+  unsigned long slotStartMillis; // start time of the slot being filled
+} type_tpuart_bus_load_window;
+
+// Bus load statistics over a period (see GetBusLoad())
+typedef struct {
+  word periodMillis;            // observation period, 0 if no slot has been completed yet
+  byte utilizationPercent;      // bus time used by all the telegrams, in % of the period
+  byte rxUtilizationPercent;    // bus time used by the telegrams of the other devices, in % of the period
+  word rxTelegramsNb;           // nb of received telegrams
+  word addressedNb;             // nb of received telegrams addressed to the device
+  word txTelegramsNb;           // nb of sent telegrams
+} type_tpuart_bus_load;
+
+// --- Definitions for the BUS MONITOR frames capture ----
+// Status flags of a captured frame
+#define KNX_MONITOR_FRAME_CHECKSUM_OK 0x01 // the checksum of the received chars is correct
+#define KNX_MONITOR_FRAME_ACK         0x02 // a bus ACK char has been received (see ack)
+#define KNX_MONITOR_FRAME_INCOMPLETE  0x04 // end of packet before the length given by the routing field
+#define KNX_MONITOR_FRAME_TRUNCATED   0x08 // frame longer than KNX_TELEGRAM_MAX_SIZE, the extra chars are not stored
+#define KNX_MONITOR_FRAMES_LOST       0x10 // frames have been lost (ring full) before this one
+
+// Bus ACK char values
+#define KNX_BUS_ACK  0xCC
+#define KNX_BUS_NACK 0x0C
+#define KNX_BUS_BUSY 0xC0
+
+// Frame captured in BUS MONITOR mode
+typedef struct {
+  unsigned long timeMicrosec; // reception time (micros()) of the control field
+  word charsNb;               // nb of chars of the frame, ACK char excluded
+  byte status;                // KNX_MONITOR_FRAME_xxx flags
+  byte ack;                   // bus ACK char (KNX_BUS_ACK, KNX_BUS_NACK, KNX_BUS_BUSY...), valid with KNX_MONITOR_FRAME_ACK
+  KnxTelegram telegram;       // chars of the frame, up to KNX_TELEGRAM_MAX_SIZE
+} type_tpuart_monitor_frame;
+
+// Monitor states
+enum e_TpUartMonitorState {
+  MONITOR_IDLE = 0,    // waiting for a control field
+  MONITOR_RECEIVING,   // frame chars reception ongoing
+  MONITOR_WAITING_ACK  // frame received, waiting for the ACK char
+};
+
+typedef struct {
+  e_TpUartMonitorState state;
+  type_tpuart_monitor_frame *frames; // frames ring (provided by AttachMonitorBuffer() caller)
+  type_tpuart_monitor_frame *frame;  // frame being received, NULL when it is not stored (ring full)
+  byte framesNb;                     // size of the ring
+  byte readPos;                      // position of the oldest frame of the ring
+  byte storedNb;                     // nb of frames in the ring
+  word charsNb;                      // nb of chars of the frame being received
+  word expectedNb;                   // length of the frame being received given by its routing (or length) field, 0 if unknown
+  byte checksum;                     // XOR of the chars of the frame being received
+  boolean lost;                      // frames lost since the last stored one
+  word lostFramesNb;                 // nb of frames lost since the start
+  unsigned long lastByteRxTimeMicrosec; // reception time of the last char of the frame
+} type_tpuart_monitor;
+
 // --- Typdef for BUS MONITORING mode data ----
 typedef struct {
   boolean isEOP;  // True if the data is an End Of Packet
@@ -166,11 +390,31 @@ class KnxTpUart {
     const type_KnxTpUartMode _mode;           // TpUart working Mode (Normal/Bus Monitor)
     type_tpuart_rx _rx;                       // Reception structure
     type_tpuart_tx _tx;                       // Transmission structure
+    type_tpuart_confirm_timing _confirmTiming; // Confirm latency estimate, ACK timeout
     type_EventCallbackFctPtr _evtCallbackFct; // Pointer to the EVENTS callback function
     KnxComObject *_comObjectsList;            // Attached list of com objects
-    byte _assignedComObjectsNb;               // Nb of assigned com objects
-    byte *_orderedIndexTable;                 // Table containing the assigned com objects indexes ordered by increasing @
+    word _indexTableEntriesNb;                // Nb of (address, index) entries of the ordered index table
+    type_tpuart_index_entry *_orderedIndexTable; // Assigned com objects (address, index) ordered by increasing address, then index
+                                              // (provided by AttachComObjectsList() caller with KNX_NO_HEAP)
     byte _stateIndication;                    // Value of the last received state indication
+    type_tpuart_bus_load_window _busLoad;     // Bus activity accounted per time slot
+    type_tpuart_monitor _monitor;             // Frames assembly (BUS MONITOR mode)
+#if defined(KNX_STATS)
+    type_tpuart_rx_stats _rxStats;            // Reception errors
+#endif
+#if defined(KNXTPUART_RX_ISR)
+    // Bytes received under interrupt, not processed yet (the RX interrupt is the producer, RXTask the consumer)
+    ActionSpscRingBuffer<type_tpuart_rx_isr_byte, KNXTPUART_RX_ISR_BUFFER_SIZE> _rxIsrBuffer;
+    static KnxTpUart *_rxIsrInstance;         // Instance fed by RxInterruptHandler()
+#endif
+#if defined(KNXTPUART_ACK_FILTER)
+    // Bloom filter of the active com objects addresses (2 bits per address), built by AttachComObjectsList()
+    byte _ackFilter[KNXTPUART_ACK_FILTER_SIZE];
+    word _ackFilterFalsePositivesNb;          // Nb of telegrams accepted by the filter without active com object
+    static_assert((KNXTPUART_ACK_FILTER_SIZE >= 8) && (KNXTPUART_ACK_FILTER_SIZE <= 256)
+                  && !(KNXTPUART_ACK_FILTER_SIZE & (KNXTPUART_ACK_FILTER_SIZE - 1)),
+                  "KNXTPUART_ACK_FILTER_SIZE shall be a power of 2 from 8 to 256");
+#endif
 #if defined(KNXTPUART_DEBUG_INFO) || defined(KNXTPUART_DEBUG_ERROR)
     String *_debugStrPtr;
 #endif
@@ -202,6 +446,7 @@ static const char _debugErrorText[];
     // return KNX_TPUART_ERROR_NOT_INIT_STATE (254) if the TPUART is not in Init state
     // else return OK
     // The function must be called prior to Init() execution
+    // NB : the TX part is idle when the callback is called (except on TPUART reset), it may send the next telegram
     byte SetAckCallback(type_AckCallbackFctPtr);
 
     // Get the value of the last received State Indication
@@ -213,14 +458,27 @@ static const char _debugErrorText[];
     KnxTelegram& GetReceivedTelegram(void);
 
     // Get the index of the com object targeted by the last received telegram
+    // (the lowest index one in case of several com objects with the target address)
     byte GetTargetedComObjectIndex(void) const;
 
+    // Iterate over all the active com objects targeted by the last received telegram, by increasing index :
+    //   byte cursor = 0, index;
+    //   while (GetTargetedComObject(cursor, index)) { ... }
+    // The first com object got is the GetTargetedComObjectIndex() one
+    // return false when there is no more com object
+    boolean GetTargetedComObject(byte &cursor, byte &index) const;
+
+    // Get the working mode (NORMAL/BUS_MONITOR)
+    type_KnxTpUartMode GetMode(void) const;
+
     // returns true if there is an activity ongoing (RX/TX) on the TPUART
     // false when there's no activity or when the tpuart is not initialized
     boolean IsActive(void) const;
 
-    // Set the string used for debug traces
+#ifndef KNX_NO_HEAP
+    // Set the string used for debug traces (String uses the heap, not available with KNX_NO_HEAP)
     void SetDebugString(String *strPtr);
+#endif
 
   // Functions NOT INLINED
     // Reset the Arduino UART port and the TPUART device
@@ -229,10 +487,20 @@ static const char _debugErrorText[];
 
     // Attach a list of com objects
     // NB1 : only the objects with "communication" attribute are considered by the TPUART
-    // NB2 : In case of objects with identical address, the object with highest index only is considered
+    // NB2 : several objects may share the same address (see IsAddressAssigned())
+    // NB3 : the addresses are read once, the list shall be attached again after an address change
+    // NB4 : listeningAddresses gives additional (address, index) pairs, a com object listens to
+    //       its own address and to all the addresses of the pairs with its index
     // return KNX_TPUART_ERROR_NOT_INIT_STATE (254) if the TPUART is not in Init state
     // The function must be called prior to Init() execution
-    byte AttachComObjectsList(KnxComObject KnxComObjectsList[], byte listSize);
+#ifdef KNX_NO_HEAP
+    // With KNX_NO_HEAP, orderedIndexTable is the storage of the index table (listSize + listeningNb entries)
+    byte AttachComObjectsList(KnxComObject KnxComObjectsList[], byte listSize, type_tpuart_index_entry orderedIndexTable[],
+                              const type_tpuart_index_entry listeningAddresses[] = NULL, byte listeningNb = 0);
+#else
+    byte AttachComObjectsList(KnxComObject KnxComObjectsList[], byte listSize,
+                              const type_tpuart_index_entry listeningAddresses[] = NULL, byte listeningNb = 0);
+#endif
 
     // Init
     // returns ERROR (255) if the TP-UART is not in INIT state, else returns OK (0)
@@ -250,8 +518,45 @@ static const char _debugErrorText[];
     // is transmitted in 0,58ms.
     // In order not to miss any End Of Packets (i.e. a gap from 2 to 2,5ms), the function shall be called at a max period of 0,5ms.
     // Typical calling period is 400 usec.
+    // With KNXTPUART_RX_ISR, all the bytes received under interrupt are processed at each call, and the EOP are
+    // detected from the bytes reception time. The calling period only delays the ACK service and the events.
     void RXTask(void);
 
+#if defined(KNXTPUART_RX_ISR)
+    // UART RX interrupt entry point (KNXTPUART_RX_ISR mode)
+    // The "RX complete" interrupt handler of the UART connected to the TPUART shall call it with each received byte
+    // (on the host build, the emulated UART does it). The byte is timestamped and queued for RXTask().
+    // Bytes received before the end of Reset() are ignored
+    // The handler belongs to the serial driver of the core, the hook depends on the architecture :
+    // - AVR : the core HardwareSerial owns the USARTn_RX_vect vectors, a sketch cannot add its own. The mode needs
+    //   a core whose HardwareSerial::_rx_complete_irq() hands the char to RxInterruptHandler() (one line added
+    //   for the TPUART port, in a board package copy of the core), the default polling mode is to be used otherwise
+    //   (serialEvent() runs from loop(), not from the interrupt, it is no hook)
+    // - SAMD : the TPUART port is a Uart declared by the sketch on a free SERCOM. The sketch SERCOMn_Handler()
+    //   reads the received chars (sercom.availableDataUART()/readDataUART()), calls RxInterruptHandler() with each
+    //   one, then calls the Uart IrqHandler() for the transmission and the errors
+    // - ESP8266 : the core UART interrupt is not reachable, the mode is not available
+    // NB : the bytes are timestamped on 32 bits, RXTask() may be called late without merging 2 telegrams,
+    // as long as the ring does not overflow (KNXTPUART_RX_ISR_BUFFER_SIZE bytes, 18 ms of bus data by default)
+    static void RxInterruptHandler(byte data);
+
+    // Nb of bytes lost because RXTask() has not been called for too long (ring full)
+    word GetRxOverrunsNb(void) const;
+
+    // Max nb of bytes waiting for RXTask() since the start (KNXTPUART_RX_ISR_BUFFER_SIZE at most)
+    word GetRxIsrBufferMaxNb(void) const;
+#endif
+
+#if defined(KNX_STATS)
+    // Reception errors since the start or the last ClearRxStats()
+    const type_tpuart_rx_stats& GetRxStats(void) const;
+    void ClearRxStats(void);
+
+    // Reception time (micros()) of the last char of the received telegram, to be read on the
+    // TPUART_EVENT_RECEIVED_KNX_TELEGRAM event
+    unsigned long GetRxTelegramEndMicros(void) const;
+#endif
+
     // Transmission task
     // This function shall be called periodically in order to allow a correct transmission of the KNX bus data
     // Assuming the TP-Uart speed is configured to 19200 baud, a character (8 data + 1 start + 1 parity + 1 stop)
@@ -259,30 +564,145 @@ static const char _debugErrorText[];
     // Sending one byte of a telegram consists in transmitting 2 characters (1,16ms)
     // Let's wait around 800us between each telegram piece sending so that the 64byte TX buffer remains almost empty.
     // Typical calling period is 800 usec.
+    // With KNXTPUART_TX_BURST, each call tops the UART TX buffer up to KNXTPUART_TX_BURST_MAX_BYTES queued bytes
+    // (see availableForWrite()) instead of writing one piece
     void TXTask(void);
 
+    // Time (in usec) left before RXTask() needs to be called, counted from nowTime (micros() value)
+    // 0 when received bytes are waiting, else the EOP deadline of the telegram being received,
+    // KNX_TPUART_NO_DEADLINE when no reception is ongoing
+    // NB : without KNXTPUART_RX_ISR, the bytes arrival is not known in advance, RXTask() shall still be
+    // called periodically
+    unsigned long GetRxDeadline(unsigned long nowTime) const;
+
+    // Time (in usec) left before TXTask() needs to be called
+    // 0 while a telegram is being handed to the TPUART (TXTask() calling period applies),
+    // the remaining ACK timeout while the TPUART answer is awaited, KNX_TPUART_NO_DEADLINE when TX is idle
+    unsigned long GetTxDeadline(void) const;
+
     // Get Bus monitoring data (BUS MONITORING mode)
     // The function returns true if a new data has been retrieved (data pointer in argument), else false
     // It shall be called periodically (max period of 0,5ms) in order to allow correct data reception
     // Typical calling period is 400 usec.
+    // With KNXTPUART_RX_ISR, the EOP are detected from the bytes reception time, the function shall be
+    // called until it returns false.
+    // NB : not to be used with a monitor buffer attached, RXTask() gets the bytes then
     boolean GetMonitoringData(type_MonitorData&);
 
+    // Attach the frames ring of the BUS MONITOR mode (storage provided by the caller)
+    // RXTask() then assembles the received chars into complete frames, with their reception time, checksum
+    // status and bus ACK char. The ring keeps the frames till GetMonitorFrame(), the frames received meanwhile
+    // are lost when it is full (see KNX_MONITOR_FRAMES_LOST)
+    // return KNX_TPUART_ERROR_NOT_INIT_STATE (254) if the TPUART is not in Init state, KNX_TPUART_ERROR (255)
+    // if the ring is empty. The function must be called prior to Init() execution
+    byte AttachMonitorBuffer(type_tpuart_monitor_frame frames[], byte framesNb);
+
+    // Get the oldest captured frame out of the ring, return false if the ring is empty
+    boolean GetMonitorFrame(type_tpuart_monitor_frame& frame);
+
+    // Nb of frames lost because the ring was full
+    word GetMonitorLostFramesNb(void) const;
+
+    // Confirm latency estimate and ACK timeout statistics since the start
+    const type_tpuart_confirm_timing& GetConfirmTiming(void) const;
+
+    // Bus load statistics over the last "slotsNb" completed slots of KNXTPUART_BUS_LOAD_SLOT_MS (the slot being
+    // filled is not counted). slotsNb is limited to the nb of slots completed since the start and to KNXTPUART_BUS_LOAD_SLOTS_NB
+    // return false (and a null periodMillis) if no slot has been completed yet
+    // NB : the telegrams of the device itself are counted when they are confirmed, their repetitions are not counted
+    boolean GetBusLoad(byte slotsNb, type_tpuart_bus_load& busLoad);
+
+    // Check if the target address points to an active assigned com object (i.e. the target address equals a com object address)
+    // if yes, then update index parameter with the index (in the list) of the targeted com object and return true
+    // else return false
+    // In case of several com objects with the address, the one with the lowest index is returned
+    boolean IsAddressAssigned(word addr, byte &index) const;
+
+#if defined(KNXTPUART_ACK_FILTER)
+    // Check if the address passes the ACK filter (constant time)
+    // false : no active com object has the address
+    // true : an active com object probably has the address (the index lookup is done at the end of the telegram)
+    boolean IsAddressAccepted(word addr) const;
+
+    // Nb of telegrams acknowledged because of the filter while no active com object had their address
+    word GetAckFilterFalsePositivesNb(void) const;
+#endif
+
+    // Get the next active com object assigned to the address, after the com object "index"
+    // if found, then update index parameter and return true, else return false
+    // All the com objects targeted by an address are got with IsAddressAssigned() then GetNextAssignedComObject() calls
+    boolean GetNextAssignedComObject(word addr, byte &index) const;
+
+    // Check if a com object of lower index than "index" has the address as its own one and no valid value yet
+    // (binary search of the address then scan of its com objects)
+    boolean HasLowerInvalidComObject(word addr, byte index) const;
+
     // DEBUG purpose functions
     void DEBUG_SendResetCommand(void);
     void DEBUG_SendStateReqCommand(void);
 
   private:
 
+    // Position in _orderedIndexTable of the first entry greater or equal to (addr, index) (binary search)
+    // return _indexTableEntriesNb if there is no such entry
+    word LowerBound(word addr, byte index) const;
+
+    // Get the first active com object of _orderedIndexTable with the address, starting from position "pos"
+    // pos is updated with the position of the com object found
+    boolean FindActiveComObject(word addr, word &pos, byte &index) const;
+
+    // Look for the com object targeted by the telegram being received (_rx.pendingComObjectxxx update)
+    boolean LookupPendingTelegram(void);
+
+    // Process one byte of the TPUART RX stream received at "rxTime"
+    // "nowTime" is used to check the ACK service deadline
+    void RxByte(byte incomingByte, unsigned long rxTime, unsigned long nowTime);
+
+    // End Of Packet, complete the telegram reception
+    void RxEndOfPacket(void);
+
+    // Reception task of the BUS MONITOR mode (monitor buffer attached)
+    void MonitorRXTask(void);
+
+    // Process one char received at "rxTime" in BUS MONITOR mode
+    void MonitorByte(byte data, unsigned long rxTime);
+
+    // Complete the frame being received once its EOP or its ACK window is reached at "nowTime"
+    void MonitorCheckTimeouts(unsigned long nowTime);
+
+    // Store the received frame into the ring (or account it as lost)
+    void MonitorStoreFrame(void);
+
+    // Start the new bus load slots up to now, and return the slot being filled
+    type_tpuart_bus_load_slot& CurrentBusLoadSlot(void);
+
+    // Account a confirmed telegram of the device in the bus load
+    void AccountTxTelegram(void);
+
+    // Bus time (in msec, rounded up) of a sent telegram of "charsNb" chars, idle time before it included
+    static word TelegramBusMillis(word charsNb);
+
+    // ACK timeout of the sent telegram, from its bus time and the confirm latency estimate
+    word ConfirmTimeout(void) const;
+
+    // Update the confirm latency estimate with the confirm latency of a telegram
+    void UpdateConfirmTiming(word latencyMillis, word busMillis);
+
+    // Check a Data_Confirm against the telegram waiting for it, and update the confirm latency estimate
+    // return false for the late confirm of a timed out telegram, or for an unexpected one
+    boolean AcceptTxConfirm(void);
+
+#if defined(KNXTPUART_RX_ISR)
+    // Start/Stop routing the bytes received under interrupt to this instance
+    void StartRxInterrupt(void);
+    void StopRxInterrupt(void);
+#endif
+
   // Private INLINED functions (see definitions later in this file)
     void DebugInfo(const char[]) const;
 
     void DebugError(const char[]) const;
 
-  // Private NOT INLINED functions 
-    // Check if the target address points to an assigned com object (i.e. the target address equals a com object address)
-    // if yes, then update index parameter with the index (in the list) of the targeted com object and return true
-    // else return false
-    boolean IsAddressAssigned(word addr, byte &index) const;
 };
 
 
@@ -314,27 +734,78 @@ inline byte KnxTpUart::GetTargetedComObjectIndex(void) const
 { return _rx.addressedComObjectIndex; } // return the index of the adress addressed by the received KNX Telegram
 
 
+inline type_KnxTpUartMode KnxTpUart::GetMode(void) const { return _mode; }
+
+inline word KnxTpUart::GetMonitorLostFramesNb(void) const { return _monitor.lostFramesNb; }
+
+inline const type_tpuart_confirm_timing& KnxTpUart::GetConfirmTiming(void) const { return _confirmTiming; }
+
 inline boolean KnxTpUart::IsActive(void) const
 {
+  if (_monitor.state != MONITOR_IDLE) return true; // Monitor frame reception
   if ( _rx.state > RX_IDLE_WAITING_FOR_CTRL_FIELD) return true; // Rx activity
   if ( _tx.state > TX_IDLE) return true; // Tx activity
+#if defined(KNXTPUART_RX_ISR)
+  if (!_rxIsrBuffer.IsEmpty()) return true; // Rx bytes not processed yet
+#else
+  if (_serial.available() > 0) return true; // Rx bytes not read yet
+#endif
   return false;
 }
 
+#if defined(KNXTPUART_RX_ISR)
+inline word KnxTpUart::GetRxOverrunsNb(void) const { return _rxIsrBuffer.LostElementsNb(); }
+
+inline word KnxTpUart::GetRxIsrBufferMaxNb(void) const { return _rxIsrBuffer.ElementsMaxNb(); }
+#endif
+
+#if defined(KNX_STATS)
+inline const type_tpuart_rx_stats& KnxTpUart::GetRxStats(void) const { return _rxStats; }
+
+inline void KnxTpUart::ClearRxStats(void) { memset(&_rxStats, 0, sizeof(_rxStats)); }
+
+inline unsigned long KnxTpUart::GetRxTelegramEndMicros(void) const { return _rx.lastByteRxTimeMicrosec; }
+
+// Saturated increment of a statistics counter
+#define KNXTPUART_STATS_INC(counter) do { if ((counter) != 0xFFFF) (counter)++; } while (0)
+#else
+#define KNXTPUART_STATS_INC(counter) do { } while (0)
+#endif
+
+#if defined(KNXTPUART_ACK_FILTER)
+// Positions of the 2 filter bits of an address (multiplicative hashes, the upper bits are kept)
+#define KNXTPUART_ACK_FILTER_BIT1(addr) ((word) ((word) (addr) * 40503U) / (word) (0x10000UL / (KNXTPUART_ACK_FILTER_SIZE * 8U)))
+#define KNXTPUART_ACK_FILTER_BIT2(addr) ((word) ((word) (addr) * 27191U) / (word) (0x10000UL / (KNXTPUART_ACK_FILTER_SIZE * 8U)))
+
+inline boolean KnxTpUart::IsAddressAccepted(word addr) const
+{
+  word bit1 = KNXTPUART_ACK_FILTER_BIT1(addr), bit2 = KNXTPUART_ACK_FILTER_BIT2(addr);
+  return (_ackFilter[bit1 >> 3] & (1 << (bit1 & 7))) && (_ackFilter[bit2 >> 3] & (1 << (bit2 & 7)));
+}
+
+inline word KnxTpUart::GetAckFilterFalsePositivesNb(void) const { return _ackFilterFalsePositivesNb; }
+#endif
+
 
 
+#ifndef KNX_NO_HEAP
 inline void KnxTpUart::SetDebugString(String *strPtr)
 {
 #if defined(KNXTPUART_DEBUG_INFO) || defined(KNXTPUART_DEBUG_ERROR)
    _debugStrPtr = strPtr;
+#else
+   (void) strPtr;
 #endif
 }
+#endif
 
 
 inline void KnxTpUart::DebugInfo(const char comment[]) const
 {
 #if defined(KNXTPUART_DEBUG_INFO)
   if (_debugStrPtr != NULL) *_debugStrPtr += String(_debugInfoText) + String(comment);
+#else
+  (void) comment;
 #endif
 }
 
@@ -343,6 +814,8 @@ inline void KnxTpUart::DebugError(const char comment[]) const
 {
 #if defined(KNXTPUART_DEBUG_ERROR)
   if (_debugStrPtr != NULL) *_debugStrPtr += String(_debugErrorText) + String(comment);
+#else
+  (void) comment;
 #endif
 }
 
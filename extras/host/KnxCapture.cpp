@@ -0,0 +1,157 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ *
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : KnxCapture.cpp
+// Description : Binary capture file of the KNX bus traffic
+// Module dependencies : KnxTpUart (type_tpuart_monitor_frame)
+
+#include <string.h>
+#include "KnxCapture.h"
+
+
+KnxCaptureWriter::KnxCaptureWriter() : _file(NULL), _lastTimeMicros(0), _recordsNb(0) {}
+
+KnxCaptureWriter::~KnxCaptureWriter() { Close(); }
+
+
+bool KnxCaptureWriter::Open(const char *path, uint64_t startMicros)
+{
+  uint8_t header[KNX_CAPTURE_HEADER_SIZE];
+
+  Close();
+  _file = fopen(path, "wb");
+  if (!_file) return false;
+  memset(header, 0, sizeof(header));
+  memcpy(header, KNX_CAPTURE_MAGIC, 4);
+  header[4] = KNX_CAPTURE_VERSION;
+  for (int i = 0; i < 8; i++) header[8 + i] = (uint8_t) (startMicros >> (8 * i));
+  _lastTimeMicros = startMicros;
+  _recordsNb = 0;
+  if (fwrite(header, sizeof(header), 1, _file) != 1) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+
+bool KnxCaptureWriter::Write(const type_KnxCaptureRecord& record)
+{
+  uint8_t buffer[10 + 4 + 255];
+  uint64_t delta = (record.timeMicros > _lastTimeMicros) ? record.timeMicros - _lastTimeMicros : 0;
+  size_t length = 0;
+
+  if (!_file) return false;
+  do { // unsigned LEB128
+    buffer[length++] = (uint8_t) ((delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0));
+    delta >>= 7;
+  } while (delta);
+  buffer[length++] = record.status;
+  buffer[length++] = record.ack;
+  buffer[length++] = record.charsNb;
+  buffer[length++] = record.storedNb;
+  memcpy(&buffer[length], record.bytes, record.storedNb);
+  length += record.storedNb;
+  if (fwrite(buffer, length, 1, _file) != 1) return false;
+  if (record.timeMicros > _lastTimeMicros) _lastTimeMicros = record.timeMicros;
+  _recordsNb++;
+  return true;
+}
+
+
+bool KnxCaptureWriter::Write(const type_tpuart_monitor_frame& frame)
+{
+  type_KnxCaptureRecord record;
+
+  record.timeMicros = _lastTimeMicros + (uint32_t) ((uint32_t) frame.timeMicrosec - (uint32_t) _lastTimeMicros);
+  record.status = frame.status;
+  record.ack = frame.ack;
+  // the nb of chars of the extended frames longer than 255 chars is saturated, the extra chars are not stored
+  record.charsNb = (frame.charsNb < 0xFF) ? frame.charsNb : 0xFF;
+  record.storedNb = (record.charsNb < KNX_TELEGRAM_MAX_SIZE) ? record.charsNb : KNX_TELEGRAM_MAX_SIZE;
+  if (frame.charsNb > record.storedNb) record.status |= KNX_MONITOR_FRAME_TRUNCATED;
+  for (uint8_t i = 0; i < record.storedNb; i++) record.bytes[i] = frame.telegram.ReadRawByte(i);
+  return Write(record);
+}
+
+
+bool KnxCaptureWriter::Close(void)
+{
+  bool ok = true;
+  if (_file) ok = (fclose(_file) == 0);
+  _file = NULL;
+  return ok;
+}
+
+
+KnxCaptureReader::KnxCaptureReader() : _file(NULL), _startMicros(0), _lastTimeMicros(0) {}
+
+KnxCaptureReader::~KnxCaptureReader() { Close(); }
+
+
+bool KnxCaptureReader::Open(const char *path)
+{
+  uint8_t header[KNX_CAPTURE_HEADER_SIZE];
+
+  Close();
+  _file = fopen(path, "rb");
+  if (!_file) return false;
+  if ((fread(header, sizeof(header), 1, _file) != 1) || memcmp(header, KNX_CAPTURE_MAGIC, 4)
+      || (header[4] != KNX_CAPTURE_VERSION)) {
+    Close();
+    return false;
+  }
+  _startMicros = 0;
+  for (int i = 0; i < 8; i++) _startMicros |= (uint64_t) header[8 + i] << (8 * i);
+  _lastTimeMicros = _startMicros;
+  return true;
+}
+
+
+bool KnxCaptureReader::Read(type_KnxCaptureRecord& record)
+{
+  uint64_t delta = 0;
+  uint8_t fields[4];
+  int c, shift = 0;
+
+  if (!_file) return false;
+  do { // unsigned LEB128
+    if ((c = fgetc(_file)) == EOF) return false;
+    if (shift < 64) delta |= (uint64_t) (c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  if (fread(fields, sizeof(fields), 1, _file) != 1) return false;
+  record.status = fields[0];
+  record.ack = fields[1];
+  record.charsNb = fields[2];
+  record.storedNb = fields[3];
+  if ((record.storedNb) && (fread(record.bytes, record.storedNb, 1, _file) != 1)) return false;
+  _lastTimeMicros += delta;
+  record.timeMicros = _lastTimeMicros;
+  return true;
+}
+
+
+void KnxCaptureReader::Close(void)
+{
+  if (_file) fclose(_file);
+  _file = NULL;
+}
@@ -0,0 +1,99 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ *
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : KnxCapture.h
+// Description : Binary capture file of the KNX bus traffic, as captured in BUS_MONITOR mode
+//               (Knx.getMonitorFrame()), for archiving and offline analysis.
+//               File layout, all the integers are little endian :
+//               - header (16 bytes) : "KNXC", format version (1), flags (0), 2 reserved bytes,
+//                 capture start time (uint64, usec)
+//               - one record per frame :
+//                   time since the previous record (or the capture start) in usec, unsigned LEB128
+//                   (1 byte below 128 us, 3 bytes below 2 s)
+//                   status (KNX_MONITOR_FRAME_xxx flags), bus ACK char, nb of chars of the frame on
+//                   the bus (saturated at 255), nb of stored chars (1 byte each)
+//                   the stored chars (control field first)
+//               A group telegram with a 1 byte value takes about 16 bytes.
+// Module dependencies : KnxTpUart (type_tpuart_monitor_frame)
+
+#ifndef KNXCAPTURE_H
+#define KNXCAPTURE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "KnxTpUart.h"
+
+#define KNX_CAPTURE_MAGIC       "KNXC"
+#define KNX_CAPTURE_VERSION     1
+#define KNX_CAPTURE_HEADER_SIZE 16
+
+// Frame of a capture file
+typedef struct {
+  uint64_t timeMicros;  // capture time base : start time + sum of the deltas
+  uint8_t status;       // KNX_MONITOR_FRAME_xxx flags
+  uint8_t ack;          // bus ACK char, valid with KNX_MONITOR_FRAME_ACK
+  uint8_t charsNb;      // nb of chars of the frame on the bus
+  uint8_t storedNb;     // nb of chars in bytes[] (lower than charsNb for truncated frames)
+  uint8_t bytes[255];
+} type_KnxCaptureRecord;
+
+class KnxCaptureWriter {
+    FILE *_file;
+    uint64_t _lastTimeMicros;  // time of the last record
+    uint32_t _recordsNb;
+
+  public:
+    KnxCaptureWriter();
+    ~KnxCaptureWriter();
+
+    // Create the file, "startMicros" is the capture start time in the time base of the frames
+    // (e.g. micros() when the device has been started)
+    bool Open(const char *path, uint64_t startMicros);
+
+    // Append a frame. The 32 bit device time of a monitor frame is extended with the time of the
+    // previous record, the frames shall be less than 71 minutes apart
+    bool Write(const type_KnxCaptureRecord& record);
+    bool Write(const type_tpuart_monitor_frame& frame);
+
+    bool Close(void);
+    uint32_t RecordsNb(void) const { return _recordsNb; }
+};
+
+class KnxCaptureReader {
+    FILE *_file;
+    uint64_t _startMicros;
+    uint64_t _lastTimeMicros;
+
+  public:
+    KnxCaptureReader();
+    ~KnxCaptureReader();
+
+    // Open the file and check its header
+    bool Open(const char *path);
+
+    // Read the next record, return false at the end of the file or on a truncated record
+    bool Read(type_KnxCaptureRecord& record);
+
+    void Close(void);
+    uint64_t StartMicros(void) const { return _startMicros; }
+};
+
+#endif // KNXCAPTURE_H
@@ -0,0 +1,307 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : TpUartEmulator.cpp
+// Description : Byte-accurate emulation of a Siemens TPUART connected to a host UART
+// Module dependencies : HardwareSerial, HostClock
+
+#include <string.h>
+#include "TpUartEmulator.h"
+
+// Host -> TPUART services (see KnxTpUart.h)
+#define EMU_RESET_REQ              0x01
+#define EMU_STATE_REQ              0x02
+#define EMU_ACTIVATEBUSMON_REQ     0x05
+#define EMU_SET_ADDR_REQ           0x28
+#define EMU_DATA_OFFSET_REQ        0x08 // 0000 1xxx, TPUART2 U_L_DataOffset
+#define EMU_DATA_OFFSET_MASK       0xF8
+#define EMU_ACK_SERVICE            0x10 // 0001 0xxx
+#define EMU_ACK_SERVICE_MASK       0xF8
+#define EMU_ACK_SERVICE_ADDRESSED  0x01
+#define EMU_DATA_START_CONTINUE    0x80 // 10xx xxxx
+#define EMU_DATA_END               0x40 // 01xx xxxx
+#define EMU_DATA_MASK              0xC0
+#define EMU_DATA_INDEX_MASK        0x3F
+
+// TPUART -> host services
+#define EMU_RESET_INDICATION       0x03
+#define EMU_STATE_INDICATION       0x07
+#define EMU_DATA_CONFIRM_SUCCESS   0x8B
+#define EMU_DATA_CONFIRM_FAILED    0x0B
+
+#define CHAR_END_NS(i) (((uint64_t) (i) * HOST_KNX_CHAR_SPACING_BITS + HOST_KNX_CHAR_BITS) * HOST_KNX_BIT_NS)
+
+
+TpUartEmulator::TpUartEmulator(HardwareSerial& serial) : _serial(serial)
+{
+  _seq = 0;
+  _nextFrameId = 1;
+  _busFreeNs = 0;
+  _busMonitor = false;
+  _physicalAddr = 0;
+  _echoHostFrames = true;
+  _ackFrameId = 0;
+  _cmd = 0;
+  _cmdPendingBytes = 0;
+  _txOffset = 0;
+  _txStartNs = 0;
+  _txOngoing = false;
+  _nackNextNb = 0;
+  _dropConfirmNextNb = 0;
+  _frameCallback = NULL;
+  _frameCallbackContext = NULL;
+  ClearStats();
+  _serial.AttachPeer(this);
+  HostClock::Attach(this);
+}
+
+
+TpUartEmulator::~TpUartEmulator()
+{
+  _serial.AttachPeer(NULL);
+  HostClock::Detach(this);
+}
+
+
+void TpUartEmulator::ClearStats(void) { memset(&_stats, 0, sizeof(_stats)); }
+
+
+uint64_t TpUartEmulator::FrameAirtimeNs(uint16_t length)
+{
+  if (!length) return 0;
+  return CHAR_END_NS(length - 1) + (HOST_KNX_ACK_PAUSE_BITS + HOST_KNX_CHAR_BITS) * HOST_KNX_BIT_NS;
+}
+
+
+uint32_t TpUartEmulator::InjectFrame(const uint8_t bytes[], uint16_t length, uint64_t atNs, uint8_t busAck)
+{
+  _stats.injectedFramesNb++;
+  return PlaceFrame(bytes, length, atNs, false, busAck);
+}
+
+
+void TpUartEmulator::Schedule(uint64_t ns, e_EventType type, uint32_t frameId, uint16_t data)
+{
+  Event evt;
+  evt.ns = ns;
+  evt.seq = _seq++;
+  evt.type = type;
+  evt.frameId = frameId;
+  evt.data = data;
+  _events.push(evt);
+}
+
+
+void TpUartEmulator::SendToHost(uint8_t data, uint64_t delayNs)
+{
+  Schedule(HostClock::NowNs() + delayNs, EVT_TO_HOST, 0, data);
+}
+
+
+// Put a frame on the line, after the frames already scheduled
+uint32_t TpUartEmulator::PlaceFrame(const uint8_t bytes[], uint16_t length, uint64_t atNs, bool fromHost, uint8_t busAck)
+{
+  Frame frame;
+  if (length > HOST_TPUART_FRAME_MAX_SIZE) length = HOST_TPUART_FRAME_MAX_SIZE;
+  memset(&frame, 0, sizeof(frame));
+  frame.id = _nextFrameId++;
+  frame.fromHost = fromHost;
+  frame.busAck = busAck;
+  frame.length = length;
+  memcpy(frame.bytes, bytes, length);
+  if (atNs < HostClock::NowNs()) atNs = HostClock::NowNs();
+  frame.startNs = (atNs > _busFreeNs) ? atNs : _busFreeNs;
+  frame.endNs = frame.startNs + FrameAirtimeNs(length);
+  _busFreeNs = frame.endNs + HOST_KNX_INTERFRAME_BITS * HOST_KNX_BIT_NS;
+  _stats.busBusyNs += frame.endNs - frame.startNs;
+  _frames.push_back(frame);
+
+  for (uint16_t i = 0; i < length; i++) Schedule(frame.startNs + CHAR_END_NS(i), EVT_FRAME_CHAR, frame.id, i);
+  Schedule(frame.endNs, EVT_FRAME_END, frame.id, 0);
+  return frame.id;
+}
+
+
+TpUartEmulator::Frame *TpUartEmulator::FindFrame(uint32_t frameId)
+{
+  for (size_t i = 0; i < _frames.size(); i++) if (_frames[i].id == frameId) return &_frames[i];
+  return NULL;
+}
+
+
+uint64_t TpUartEmulator::NextEventNs(void) const
+{
+  if (_events.empty()) return HOST_CLOCK_NEVER;
+  return _events.top().ns;
+}
+
+
+void TpUartEmulator::RunEvents(uint64_t nowNs)
+{
+  while ((!_events.empty()) && (_events.top().ns <= nowNs)) {
+    Event evt = _events.top();
+    _events.pop();
+    switch (evt.type) {
+      case EVT_TO_HOST:
+        _serial.PeerWrite((uint8_t) evt.data);
+        break;
+
+      case EVT_FRAME_CHAR:
+      {
+        Frame *frame = FindFrame(evt.frameId);
+        if (!frame) break;
+        if ((frame->fromHost) && (!_echoHostFrames) && (!_busMonitor)) break;
+        _serial.PeerWrite(frame->bytes[evt.data]);
+        if (evt.data == 4) { // target address complete, the ACK service is accepted from now on
+          if ((!_busMonitor) && (!frame->fromHost)) _ackFrameId = frame->id;
+        } else if (evt.data == 5) { // routing field, the host shall now send the ACK service
+          frame->routingAtHostNs = nowNs + _serial.CharTimeNs();
+        }
+        break;
+      }
+
+      case EVT_FRAME_END:
+        EndFrame(evt.frameId);
+        break;
+    }
+  }
+}
+
+
+void TpUartEmulator::EndFrame(uint32_t frameId)
+{
+  Frame *frame = FindFrame(frameId);
+  if (!frame) return;
+
+  if (_ackFrameId == frameId) { // no ACK service received for this frame
+    _ackFrameId = 0;
+    _stats.acksMissingNb++;
+  }
+
+  if (_busMonitor) _serial.PeerWrite(frame->busAck);
+
+  if (frame->fromHost) { // Data_Confirm
+    if (_dropConfirmNextNb) {
+      _dropConfirmNextNb--;
+      _stats.confirmsDroppedNb++;
+    } else if ((_nackNextNb) || (frame->busAck != HOST_KNX_BUS_ACK)) {
+      if (_nackNextNb) _nackNextNb--;
+      _stats.confirmsNackNb++;
+      _serial.PeerWrite(EMU_DATA_CONFIRM_FAILED);
+    } else {
+      _stats.confirmsOkNb++;
+      _serial.PeerWrite(EMU_DATA_CONFIRM_SUCCESS);
+    }
+  }
+
+  if (_frameCallback) {
+    type_EmuFrameReport report;
+    report.frameId = frame->id;
+    report.fromHost = frame->fromHost;
+    report.length = frame->length;
+    report.bytes = frame->bytes;
+    report.startNs = frame->startNs;
+    report.endNs = frame->endNs;
+    report.routingAtHostNs = frame->routingAtHostNs;
+    report.ackServiceNs = frame->ackServiceNs;
+    report.ackService = frame->ackService;
+    report.txHandoffNs = frame->txHandoffNs;
+    _frameCallback(_frameCallbackContext, report);
+  }
+
+  for (size_t i = 0; i < _frames.size(); i++) {
+    if (_frames[i].id == frameId) {
+      _frames.erase(_frames.begin() + i);
+      break;
+    }
+  }
+}
+
+
+// A char sent by the host has been received
+void TpUartEmulator::OnHostByte(uint8_t data)
+{
+  if (_cmdPendingBytes) { // argument of a multi-bytes service
+    _cmdArg[(_cmd == EMU_SET_ADDR_REQ) ? 2 - _cmdPendingBytes : 0] = data;
+    if (--_cmdPendingBytes == 0) HostCommand(_cmd, _cmdArg);
+    return;
+  }
+
+  _cmd = data;
+  if (data == EMU_SET_ADDR_REQ) _cmdPendingBytes = 2;
+  else if ((data & EMU_DATA_MASK) == EMU_DATA_START_CONTINUE) _cmdPendingBytes = 1;
+  else if ((data & EMU_DATA_MASK) == EMU_DATA_END) _cmdPendingBytes = 1;
+  else HostCommand(data, NULL);
+}
+
+
+void TpUartEmulator::HostCommand(uint8_t cmd, const uint8_t args[])
+{
+  uint64_t nowNs = HostClock::NowNs();
+
+  if (cmd == EMU_RESET_REQ) {
+    _busMonitor = false;
+    _txOngoing = false;
+    _txOffset = 0;
+    _ackFrameId = 0;
+    SendToHost(EMU_RESET_INDICATION, HOST_TPUART_SERVICE_DELAY_NS);
+  } else if (cmd == EMU_STATE_REQ) {
+    SendToHost(EMU_STATE_INDICATION, HOST_TPUART_SERVICE_DELAY_NS);
+  } else if (cmd == EMU_ACTIVATEBUSMON_REQ) {
+    _busMonitor = true;
+  } else if (cmd == EMU_SET_ADDR_REQ) {
+    _physicalAddr = (uint16_t) ((args[0] << 8) + args[1]);
+  } else if ((cmd & EMU_DATA_OFFSET_MASK) == EMU_DATA_OFFSET_REQ) {
+    _txOffset = (uint16_t) ((cmd & 0x07) << 6);
+  } else if ((cmd & EMU_ACK_SERVICE_MASK) == EMU_ACK_SERVICE) {
+    Frame *frame = _ackFrameId ? FindFrame(_ackFrameId) : NULL;
+    if (frame) {
+      // an ACK service sent before the routing field reached the host has a null latency
+      uint64_t latency = ((frame->routingAtHostNs) && (nowNs > frame->routingAtHostNs)) ? nowNs - frame->routingAtHostNs : 0;
+      frame->ackServiceNs = nowNs;
+      frame->ackService = cmd;
+      _ackFrameId = 0;
+      if (latency > HOST_TPUART_ACK_DEADLINE_NS) _stats.acksLateNb++;
+      else if (cmd & EMU_ACK_SERVICE_ADDRESSED) _stats.acksAddressedNb++;
+      else _stats.acksNotAddressedNb++;
+      _stats.ackLatencySumNs += latency;
+      if (latency > _stats.ackLatencyMaxNs) _stats.ackLatencyMaxNs = latency;
+    }
+  } else if (((cmd & EMU_DATA_MASK) == EMU_DATA_START_CONTINUE) || ((cmd & EMU_DATA_MASK) == EMU_DATA_END)) {
+    uint16_t index = _txOffset + (cmd & EMU_DATA_INDEX_MASK); // the offset applies till the end of the frame
+    if (!_txOngoing) {
+      _txOngoing = true;
+      _txStartNs = nowNs;
+    }
+    if (index < HOST_TPUART_FRAME_MAX_SIZE) _txFrame[index] = args[0];
+    if ((cmd & EMU_DATA_MASK) == EMU_DATA_END) { // last char received, the frame is sent
+      _txOngoing = false;
+      _txOffset = 0;
+      _stats.hostFramesNb++;
+      uint64_t handoff = nowNs - _txStartNs;
+      _stats.txHandoffSumNs += handoff;
+      if (handoff > _stats.txHandoffMaxNs) _stats.txHandoffMaxNs = handoff;
+      uint32_t id = PlaceFrame(_txFrame, index + 1, nowNs, true, HOST_KNX_BUS_ACK);
+      FindFrame(id)->txHandoffNs = handoff;
+    }
+  }
+  // other values are ignored as the real device does
+}
@@ -0,0 +1,200 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : TpUartEmulator.h
+// Description : Byte-accurate emulation of a Siemens TPUART connected to a host UART
+//               The emulator answers the host services (reset, state, physical address,
+//               bus monitor, data requests, ACK services) and models a KNX TP1 line at
+//               9600 bit/s on the virtual clock :
+//               - a bus char is 11 bits + 2 bits pause (1,35 ms), each received char is forwarded
+//                 to the host as soon as it has been received from the bus
+//               - after the last char of a frame : 15 bits pause, 11 bits ACK char, then 50 bits
+//                 of line idle before the next frame may start
+//               - frames sent by the host are confirmed (Data_Confirm) once the ACK slot is over
+//               Every frame is reported with its timings, in particular the delay between the
+//               routing field being available to the host and the reception of the ACK service
+//               (the TPUART requires it within 1,7 ms).
+// Module dependencies : HardwareSerial, HostClock
+
+#ifndef TPUARTEMULATOR_H
+#define TPUARTEMULATOR_H
+
+#include <stdint.h>
+#include <queue>
+#include <vector>
+#include "HardwareSerial.h"
+#include "HostClock.h"
+
+// KNX TP1 line timings
+#define HOST_KNX_BIT_NS              104167ULL  // 1 bit at 9600 bit/s
+#define HOST_KNX_CHAR_BITS           11         // start + 8 data + parity + stop
+#define HOST_KNX_CHAR_SPACING_BITS   13         // char + 2 bits pause between 2 chars of a frame
+#define HOST_KNX_ACK_PAUSE_BITS      15         // pause between the last char and the ACK char
+#define HOST_KNX_INTERFRAME_BITS     50         // line idle time before the next frame
+
+// Deadline for the ACK service, counted from the routing field (6th char) availability
+#define HOST_TPUART_ACK_DEADLINE_NS  1700000ULL
+
+// TPUART answer delay to the host services
+#define HOST_TPUART_SERVICE_DELAY_NS 50000ULL
+
+#define HOST_TPUART_FRAME_MAX_SIZE   272 // largest extended frame
+
+// Bus acknowledge chars (visible in bus monitor mode)
+#define HOST_KNX_BUS_ACK  0xCC
+#define HOST_KNX_BUS_NACK 0x0C
+#define HOST_KNX_BUS_BUSY 0xC0
+
+// Report of a frame once it has completed on the bus
+typedef struct {
+  uint32_t frameId;
+  bool fromHost;              // frame sent by the host (through data requests)
+  uint16_t length;            // nb of chars of the frame
+  const uint8_t *bytes;
+  uint64_t startNs;           // first bit on the bus
+  uint64_t endNs;             // end of the ACK slot
+  uint64_t routingAtHostNs;   // routing field available in the host RX buffer (0 if not forwarded)
+  uint64_t ackServiceNs;      // ACK service received from the host (0 if none)
+  uint8_t ackService;         // TPUART_RX_ACK_SERVICE_xxx value received from the host
+  uint64_t txHandoffNs;       // host frames : time from the 1st data request to the last one
+} type_EmuFrameReport;
+
+typedef void (*type_EmuFrameCallback)(void *context, const type_EmuFrameReport& report);
+
+typedef struct {
+  uint32_t injectedFramesNb;    // frames put on the bus by other devices
+  uint32_t hostFramesNb;        // frames put on the bus by the host
+  uint32_t acksAddressedNb;     // ACK services "addressed" received in time
+  uint32_t acksNotAddressedNb;  // ACK services "not addressed" received in time
+  uint32_t acksLateNb;          // ACK services received after the deadline
+  uint32_t acksMissingNb;       // frames ended without any ACK service
+  uint64_t ackLatencySumNs;
+  uint64_t ackLatencyMaxNs;
+  uint32_t confirmsOkNb;
+  uint32_t confirmsNackNb;
+  uint32_t confirmsDroppedNb;
+  uint64_t txHandoffSumNs;
+  uint64_t txHandoffMaxNs;
+  uint64_t busBusyNs;           // time the line was used by frames (including ACK slots)
+} type_EmuStats;
+
+class TpUartEmulator : public HostSerialPeer, public HostTicker {
+
+    enum e_EventType { EVT_TO_HOST, EVT_FRAME_CHAR, EVT_FRAME_END };
+
+    struct Event {
+      uint64_t ns;
+      uint32_t seq;      // keeps the insertion order of simultaneous events
+      e_EventType type;
+      uint32_t frameId;
+      uint16_t data;     // char value (EVT_TO_HOST) or char index (EVT_FRAME_CHAR)
+      bool operator<(const Event& other) const
+      { return (ns != other.ns) ? (ns > other.ns) : (seq > other.seq); }
+    };
+
+    struct Frame {
+      uint32_t id;
+      bool fromHost;
+      uint8_t busAck;
+      uint16_t length;
+      uint8_t bytes[HOST_TPUART_FRAME_MAX_SIZE];
+      uint64_t startNs;
+      uint64_t endNs;
+      uint64_t routingAtHostNs;
+      uint64_t ackServiceNs;
+      uint8_t ackService;
+      uint64_t txHandoffNs;
+    };
+
+    HardwareSerial& _serial;
+    std::priority_queue<Event> _events;
+    std::vector<Frame> _frames;      // frames scheduled or ongoing on the bus
+    uint32_t _seq;
+    uint32_t _nextFrameId;
+    uint64_t _busFreeNs;             // time from which a new frame may start
+
+    // TPUART state
+    bool _busMonitor;
+    uint16_t _physicalAddr;
+    bool _echoHostFrames;            // forward the host frames back to the host
+    uint32_t _ackFrameId;            // frame waiting for the ACK service (0 if none)
+
+    // Host services parsing
+    uint8_t _cmd;
+    uint8_t _cmdPendingBytes;
+    uint8_t _cmdArg[2];
+    uint8_t _txFrame[HOST_TPUART_FRAME_MAX_SIZE];
+    uint16_t _txOffset;              // U_L_DataOffset extension of the data request index
+    uint64_t _txStartNs;
+    bool _txOngoing;
+
+    // Failure injection
+    uint16_t _nackNextNb;
+    uint16_t _dropConfirmNextNb;
+
+    type_EmuStats _stats;
+    type_EmuFrameCallback _frameCallback;
+    void *_frameCallbackContext;
+
+  public:
+    TpUartEmulator(HardwareSerial& serial);
+    virtual ~TpUartEmulator();
+
+    // A frame sent by another device on the line, starting not before "atNs"
+    // The frame bytes are provided as is (control field up to checksum)
+    // Returns the frame id
+    uint32_t InjectFrame(const uint8_t bytes[], uint16_t length, uint64_t atNs, uint8_t busAck = HOST_KNX_BUS_ACK);
+
+    // Behaviour configuration
+    void SetEchoHostFrames(bool echo) { _echoHostFrames = echo; }
+    void NackNextFrames(uint16_t nb) { _nackNextNb = nb; }          // Data_Confirm negative
+    void DropNextConfirms(uint16_t nb) { _dropConfirmNextNb = nb; } // no Data_Confirm at all
+    void SetFrameCallback(type_EmuFrameCallback callback, void *context)
+    { _frameCallback = callback; _frameCallbackContext = context; }
+
+    // State & statistics
+    bool IsBusMonitor(void) const { return _busMonitor; }
+    uint16_t GetPhysicalAddr(void) const { return _physicalAddr; }
+    uint64_t BusFreeNs(void) const { return _busFreeNs; }
+    bool IsBusIdle(void) const { return _frames.empty(); }
+    const type_EmuStats& Stats(void) const { return _stats; }
+    void ClearStats(void);
+
+    // Duration of a frame on the bus, ACK slot included
+    static uint64_t FrameAirtimeNs(uint16_t length);
+
+    // HostSerialPeer
+    virtual void OnHostByte(uint8_t data);
+
+    // HostTicker
+    virtual uint64_t NextEventNs(void) const;
+    virtual void RunEvents(uint64_t nowNs);
+
+  private:
+    void Schedule(uint64_t ns, e_EventType type, uint32_t frameId, uint16_t data);
+    void SendToHost(uint8_t data, uint64_t delayNs);
+    uint32_t PlaceFrame(const uint8_t bytes[], uint16_t length, uint64_t atNs, bool fromHost, uint8_t busAck);
+    Frame *FindFrame(uint32_t frameId);
+    void EndFrame(uint32_t frameId);
+    void HostCommand(uint8_t cmd, const uint8_t args[]);
+};
+
+#endif // TPUARTEMULATOR_H
@@ -0,0 +1,58 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : EEPROM.h
+// Description : Host stand-in for the Arduino EEPROM library
+//               The content starts erased (0xFF) as on a new AVR device
+// Module dependencies : none
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <stdint.h>
+
+#define E2END 0x3FF
+
+class EEPROMClass {
+    uint8_t _data[E2END + 1];
+    uint16_t _writesNb; // nb of effective cell writes, useful to check wear on the host
+
+  public:
+    EEPROMClass();
+
+    uint8_t read(int idx) const { return _data[idx]; }
+    void write(int idx, uint8_t val) { _data[idx] = val; _writesNb++; }
+    void update(int idx, uint8_t val) { if (_data[idx] != val) write(idx, val); }
+    uint8_t& operator[](int idx) { return _data[idx]; }
+    uint16_t length(void) const { return E2END + 1; }
+
+    // ESP8266 flavour
+    void begin(int size) { (void) size; }
+    bool commit(void) { return true; }
+
+    // Host only : erase the whole content and reset the write counter
+    void clear(void);
+    uint16_t writesNb(void) const { return _writesNb; }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // EEPROM_H
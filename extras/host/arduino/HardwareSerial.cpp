@@ -0,0 +1,182 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : HardwareSerial.cpp
+// Description : Host stand-in for the Arduino HardwareSerial class
+// Module dependencies : Stream, HostClock
+
+#include "HardwareSerial.h"
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+
+HardwareSerial::HardwareSerial()
+{
+  _open = false;
+  _charNs = 0;
+  _txHead = _txCount = 0;
+  _txHeadDoneNs = HOST_CLOCK_NEVER;
+  _rxLineHead = _rxLineCount = 0;
+  _rxLineHeadDoneNs = HOST_CLOCK_NEVER;
+  _rxHead = _rxCount = 0;
+  _peer = NULL;
+  _rxHook = NULL;
+  _rxHookContext = NULL;
+  _rxCharsNb = 0;
+  _rxOverrunsNb = 0;
+  _txBlockedNs = 0;
+}
+
+
+void HardwareSerial::begin(unsigned long baud, uint8_t config)
+{
+  // start bit + data bits + parity bit + stop bit(s)
+  uint8_t bits = 1 + (((config >> 1) & 0x03) + 5) + ((config & 0x30) ? 1 : 0) + ((config & 0x08) ? 2 : 1);
+  _charNs = (uint32_t) ((1000000000ULL * bits + baud / 2) / baud);
+  _txHead = _txCount = 0;
+  _txHeadDoneNs = HOST_CLOCK_NEVER;
+  _rxLineHead = _rxLineCount = 0;
+  _rxLineHeadDoneNs = HOST_CLOCK_NEVER;
+  _rxHead = _rxCount = 0;
+  _open = true;
+  HostClock::Attach(this);
+}
+
+
+void HardwareSerial::end(void)
+{
+  flush();
+  _open = false;
+  _rxHead = _rxCount = 0;
+  _rxLineHead = _rxLineCount = 0;
+  _rxLineHeadDoneNs = HOST_CLOCK_NEVER;
+  HostClock::Detach(this);
+}
+
+
+int HardwareSerial::available(void) { return _rxCount; }
+
+
+int HardwareSerial::peek(void)
+{
+  if (!_rxCount) return -1;
+  return _rxBuffer[_rxHead];
+}
+
+
+int HardwareSerial::read(void)
+{
+  if (!_rxCount) return -1;
+  uint8_t data = _rxBuffer[_rxHead];
+  _rxHead = (_rxHead + 1) % SERIAL_RX_BUFFER_SIZE;
+  _rxCount--;
+  return data;
+}
+
+
+int HardwareSerial::availableForWrite(void)
+{
+  // the char on the line is in the shift register, not in the buffer
+  uint8_t used = _txCount ? _txCount - 1 : 0;
+  return (SERIAL_TX_BUFFER_SIZE - 1) - used;
+}
+
+
+void HardwareSerial::flush(void)
+{
+  while (_txCount) HostClock::AdvanceTo(_txHeadDoneNs);
+}
+
+
+size_t HardwareSerial::write(uint8_t data)
+{
+  if (!_open) return 0;
+  if (_txCount == SERIAL_TX_BUFFER_SIZE) { // buffer full, wait as the AVR core does
+    uint64_t startNs = HostClock::NowNs();
+    while (_txCount == SERIAL_TX_BUFFER_SIZE) HostClock::AdvanceTo(_txHeadDoneNs);
+    _txBlockedNs += HostClock::NowNs() - startNs;
+  }
+  if (!_txCount) _txHeadDoneNs = HostClock::NowNs() + _charNs; // line idle, start immediately
+  _txBuffer[(_txHead + _txCount) % SERIAL_TX_BUFFER_SIZE] = data;
+  _txCount++;
+  return 1;
+}
+
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+
+void HardwareSerial::PeerWrite(uint8_t data)
+{
+  if ((!_open) || (_rxLineCount == HOST_SERIAL_LINE_SIZE)) return;
+  if (!_rxLineCount) _rxLineHeadDoneNs = HostClock::NowNs() + _charNs;
+  _rxLine[(_rxLineHead + _rxLineCount) % HOST_SERIAL_LINE_SIZE] = data;
+  _rxLineCount++;
+}
+
+
+uint64_t HardwareSerial::NextEventNs(void) const
+{
+  uint64_t next = HOST_CLOCK_NEVER;
+  if (_txCount) next = _txHeadDoneNs;
+  if ((_rxLineCount) && (_rxLineHeadDoneNs < next)) next = _rxLineHeadDoneNs;
+  return next;
+}
+
+
+void HardwareSerial::RunEvents(uint64_t nowNs)
+{
+  if ((_txCount) && (_txHeadDoneNs <= nowNs)) { // a host char has reached the peer
+    uint8_t data = _txBuffer[_txHead];
+    _txHead = (_txHead + 1) % SERIAL_TX_BUFFER_SIZE;
+    _txCount--;
+    _txHeadDoneNs = _txCount ? _txHeadDoneNs + _charNs : HOST_CLOCK_NEVER;
+    if (_peer) _peer->OnHostByte(data);
+    HostClock::Wake(); // "data register empty" interrupt
+  }
+  if ((_rxLineCount) && (_rxLineHeadDoneNs <= nowNs)) { // a peer char has reached the host
+    uint8_t data = _rxLine[_rxLineHead];
+    _rxLineHead = (_rxLineHead + 1) % HOST_SERIAL_LINE_SIZE;
+    _rxLineCount--;
+    _rxLineHeadDoneNs = _rxLineCount ? _rxLineHeadDoneNs + _charNs : HOST_CLOCK_NEVER;
+    _rxCharsNb++;
+    HostClock::Wake(); // "RX complete" interrupt
+    if (_rxHook) _rxHook(_rxHookContext, data);
+    else StoreRxByte(data);
+  }
+}
+
+
+void HardwareSerial::StoreRxByte(uint8_t data)
+{
+  if (_rxCount == SERIAL_RX_BUFFER_SIZE) { // the AVR core drops the new char
+    _rxOverrunsNb++;
+    return;
+  }
+  _rxBuffer[(_rxHead + _rxCount) % SERIAL_RX_BUFFER_SIZE] = data;
+  _rxCount++;
+}
@@ -0,0 +1,129 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : HardwareSerial.h
+// Description : Host stand-in for the Arduino HardwareSerial class
+//               The UART is modeled character by character on the virtual clock :
+//               - a char written by the host leaves the 64 byte TX buffer one char time later,
+//                 write() blocks (i.e. the clock moves) when the buffer is full as on AVR
+//               - a char sent by the peer (the TPUART emulator) lands in the 64 byte RX buffer
+//                 one char time after the peer started sending it, overruns are counted
+//               At 19200 baud with 8E1 framing, a char time is 11 bits = 572,9 us
+// Module dependencies : Stream, HostClock
+
+#ifndef HARDWARESERIAL_H
+#define HARDWARESERIAL_H
+
+#include <stdint.h>
+#include "Stream.h"
+#include "HostClock.h"
+
+#define SERIAL_RX_BUFFER_SIZE 64
+#define SERIAL_TX_BUFFER_SIZE 64
+#define HOST_SERIAL_LINE_SIZE 256 // chars in flight from the peer
+
+// Frame formats (same encoding as the AVR core)
+#define SERIAL_8N1 0x06
+#define SERIAL_8N2 0x0E
+#define SERIAL_8E1 0x26
+#define SERIAL_8E2 0x2E
+
+// The device connected to the other end of the UART
+class HostSerialPeer {
+  public:
+    virtual ~HostSerialPeer() {}
+    // A char sent by the host has been completely received by the peer
+    virtual void OnHostByte(uint8_t data) = 0;
+};
+
+// Emulated "RX complete" interrupt handler, called when a char has been completely received
+// When set, the char is handed to the handler instead of being stored in the RX buffer
+typedef void (*type_HostRxHook)(void *context, uint8_t data);
+
+class HardwareSerial : public Stream, public HostTicker {
+    bool _open;
+    uint32_t _charNs;                          // duration of one char on the line
+
+    uint8_t _txBuffer[SERIAL_TX_BUFFER_SIZE];  // chars written by the host, head is on the line
+    uint8_t _txHead;
+    uint8_t _txCount;
+    uint64_t _txHeadDoneNs;                    // end of transmission of the head char
+
+    uint8_t _rxLine[HOST_SERIAL_LINE_SIZE];    // chars sent by the peer, head is on the line
+    uint16_t _rxLineHead;
+    uint16_t _rxLineCount;
+    uint64_t _rxLineHeadDoneNs;                // end of reception of the head char
+
+    uint8_t _rxBuffer[SERIAL_RX_BUFFER_SIZE];  // received chars, not read yet
+    uint8_t _rxHead;
+    uint8_t _rxCount;
+
+    HostSerialPeer *_peer;
+    type_HostRxHook _rxHook;
+    void *_rxHookContext;
+
+    // Statistics
+    uint32_t _rxCharsNb;                       // chars received, i.e. "RX complete" interrupts
+    uint32_t _rxOverrunsNb;                    // chars lost because the RX buffer was full
+    uint64_t _txBlockedNs;                     // time spent by the host blocked in write()
+
+  public:
+    HardwareSerial();
+
+    void begin(unsigned long baud, uint8_t config = SERIAL_8N1);
+    void end(void);
+    operator bool() const { return true; }
+
+    virtual int available(void);
+    virtual int peek(void);
+    virtual int read(void);
+    int availableForWrite(void);
+    void flush(void);
+    virtual size_t write(uint8_t data);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+
+  // Host side API
+    void AttachPeer(HostSerialPeer *peer) { _peer = peer; }
+    void SetRxHook(type_HostRxHook hook, void *context) { _rxHook = hook; _rxHookContext = context; }
+
+    // The peer starts sending a char. It is received one char time after the previous one
+    void PeerWrite(uint8_t data);
+
+    bool IsOpen(void) const { return _open; }
+    uint32_t CharTimeNs(void) const { return _charNs; }
+    uint32_t RxCharsNb(void) const { return _rxCharsNb; }
+    uint32_t RxOverrunsNb(void) const { return _rxOverrunsNb; }
+    uint64_t TxBlockedNs(void) const { return _txBlockedNs; }
+    bool TxIdle(void) const { return _txCount == 0; }
+
+    // HostTicker
+    virtual uint64_t NextEventNs(void) const;
+    virtual void RunEvents(uint64_t nowNs);
+
+  private:
+    void StoreRxByte(uint8_t data);
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif // HARDWARESERIAL_H
@@ -0,0 +1,62 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : HostArduino.cpp
+// Description : Host stand-in for the Arduino core functions (time, pins, watchdog)
+// Module dependencies : HostClock
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "Arduino.h"
+#include "HostClock.h"
+#include "avr/wdt.h"
+
+unsigned long millis(void)
+{
+  HostClock::Read();
+  return HostClock::Millis();
+}
+
+unsigned long micros(void)
+{
+  HostClock::Read();
+  return HostClock::Micros();
+}
+
+void delay(unsigned long ms) { HostClock::Advance((uint64_t) ms * 1000000); }
+
+void delayMicroseconds(unsigned int us) { HostClock::Advance((uint64_t) us * 1000); }
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t, uint8_t) {}
+
+int digitalRead(uint8_t) { return LOW; }
+
+void attachInterrupt(uint8_t, void (*)(void), int) {}
+
+void detachInterrupt(uint8_t) {}
+
+void wdt_enable(unsigned char)
+{
+  fprintf(stderr, "HostArduino: watchdog reboot requested at t=%lu ms, exiting\n", (unsigned long) HostClock::Millis());
+  exit(2);
+}
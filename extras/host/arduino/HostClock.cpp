@@ -0,0 +1,122 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : HostClock.cpp
+// Description : Virtual clock of the host build
+// Module dependencies : none
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "HostClock.h"
+
+uint64_t HostClock::_nowNs = 0;
+uint32_t HostClock::_readCostNs = 1000;
+bool HostClock::_runningEvents = false;
+HostTicker *HostClock::_tickers[HOST_CLOCK_MAX_TICKERS];
+uint8_t HostClock::_tickersNb = 0;
+bool HostClock::_wakeUp = false;
+uint64_t HostClock::_sleptNs = 0;
+uint32_t HostClock::_sleepsNb = 0;
+
+
+void HostClock::AdvanceTo(uint64_t targetNs)
+{
+  if (_runningEvents) {
+    // Waiting from an event handler would reorder the events, this is a harness bug
+    fprintf(stderr, "HostClock: time cannot be advanced from an event handler\n");
+    abort();
+  }
+  while (RunNextEvent(targetNs));
+  if (targetNs > _nowNs) _nowNs = targetNs;
+}
+
+
+void HostClock::Sleep(void)
+{
+  Sleep(HOST_CLOCK_NEVER);
+}
+
+
+void HostClock::Sleep(uint64_t wakeUpNs)
+{
+  uint64_t startNs = _nowNs;
+  uint64_t timerNs = (_nowNs / HOST_CLOCK_TIMER0_PERIOD_NS + 1) * HOST_CLOCK_TIMER0_PERIOD_NS;
+  if ((wakeUpNs > _nowNs) && (wakeUpNs < timerNs)) timerNs = wakeUpNs;
+
+  if (_runningEvents) {
+    fprintf(stderr, "HostClock: the CPU cannot sleep from an event handler\n");
+    abort();
+  }
+  _wakeUp = false;
+  while (!_wakeUp && RunNextEvent(timerNs));
+  if (!_wakeUp) _nowNs = timerNs; // woken up by the timer 0 overflow
+  _sleptNs += _nowNs - startNs;
+  _sleepsNb++;
+}
+
+
+// Run the earliest ticker event if it is due at "targetNs" at the latest
+// Return false if there is no such event
+
+bool HostClock::RunNextEvent(uint64_t targetNs)
+{
+  HostTicker *next = NULL;
+  uint64_t nextNs = HOST_CLOCK_NEVER;
+  for (uint8_t i = 0; i < _tickersNb; i++) {
+    uint64_t ns = _tickers[i]->NextEventNs();
+    if (ns < nextNs) { nextNs = ns; next = _tickers[i]; }
+  }
+  if ((next == NULL) || (nextNs > targetNs)) return false;
+  if (nextNs > _nowNs) _nowNs = nextNs;
+  _runningEvents = true;
+  next->RunEvents(_nowNs);
+  _runningEvents = false;
+  return true;
+}
+
+
+void HostClock::Read(void)
+{
+  // Reads from an event handler (emulated ISR) are free
+  if (!_runningEvents) Advance(_readCostNs);
+}
+
+
+void HostClock::Attach(HostTicker *ticker)
+{
+  for (uint8_t i = 0; i < _tickersNb; i++) if (_tickers[i] == ticker) return;
+  if (_tickersNb == HOST_CLOCK_MAX_TICKERS) {
+    fprintf(stderr, "HostClock: too many tickers\n");
+    abort();
+  }
+  _tickers[_tickersNb++] = ticker;
+}
+
+
+void HostClock::Detach(HostTicker *ticker)
+{
+  for (uint8_t i = 0; i < _tickersNb; i++) {
+    if (_tickers[i] == ticker) {
+      _tickers[i] = _tickers[--_tickersNb];
+      return;
+    }
+  }
+}
@@ -0,0 +1,102 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : HostClock.h
+// Description : Virtual clock of the host build
+//               The clock only moves when told to (Advance/AdvanceTo) or when the code
+//               under test reads it (millis()/micros() consume a configurable read cost).
+//               Peripheral models (UARTs, TPUART emulator...) register as tickers and get
+//               their events executed in time order while the clock moves forward,
+//               which makes every run byte- and microsecond-exact and reproducible.
+// Module dependencies : none
+
+#ifndef HOSTCLOCK_H
+#define HOSTCLOCK_H
+
+#include <stdint.h>
+
+#define HOST_CLOCK_NEVER 0xFFFFFFFFFFFFFFFFULL
+#define HOST_CLOCK_MAX_TICKERS 8
+#define HOST_CLOCK_TIMER0_PERIOD_NS 1024000ULL // AVR timer 0 overflow (millis() interrupt) at 16 MHz
+
+// Interface of the peripheral models driven by the virtual clock
+class HostTicker {
+  public:
+    virtual ~HostTicker() {}
+
+    // Time (in ns) of the next pending event, HOST_CLOCK_NEVER if none
+    virtual uint64_t NextEventNs(void) const = 0;
+
+    // Execute the events due at "nowNs" (i.e. NextEventNs() <= nowNs)
+    virtual void RunEvents(uint64_t nowNs) = 0;
+};
+
+class HostClock {
+    static uint64_t _nowNs;
+    static uint32_t _readCostNs;
+    static bool _runningEvents;
+    static HostTicker *_tickers[HOST_CLOCK_MAX_TICKERS];
+    static uint8_t _tickersNb;
+    static bool _wakeUp;
+    static uint64_t _sleptNs;
+    static uint32_t _sleepsNb;
+
+    static bool RunNextEvent(uint64_t targetNs);
+
+  public:
+    // Current virtual time
+    static uint64_t NowNs(void) { return _nowNs; }
+    static uint32_t Micros(void) { return (uint32_t) (_nowNs / 1000); }
+    static uint32_t Millis(void) { return (uint32_t) (_nowNs / 1000000); }
+
+    // Move the time forward, running all the tickers events met on the way
+    static void Advance(uint64_t durationNs) { AdvanceTo(_nowNs + durationNs); }
+    static void AdvanceTo(uint64_t targetNs);
+
+    // Time consumed by each millis()/micros() call of the code under test (default 1 us)
+    // It models the CPU time of the polling loops, which would never end otherwise
+    static void SetReadCost(uint32_t ns) { _readCostNs = ns; }
+    static void Read(void); // Called by millis()/micros()
+
+    // True while ticker events are executed (i.e. "interrupt context")
+    static bool InEvent(void) { return _runningEvents; }
+
+    // CPU sleep (sleep_cpu() of avr/sleep.h) : the time moves event by event till an interrupt is raised
+    // (see Wake()) or till the next timer 0 overflow, the slept time is accounted
+    static void Sleep(void);
+    // Same with a timer compare match interrupt programmed at "wakeUpNs" (the sketch wakes up at the
+    // deadline returned by Knx.task())
+    static void Sleep(uint64_t wakeUpNs);
+    // Called by the peripheral models when they raise an interrupt
+    static void Wake(void) { _wakeUp = true; }
+    static uint64_t SleptNs(void) { return _sleptNs; }
+    static uint32_t SleepsNb(void) { return _sleepsNb; }
+    static void ClearSleepStats(void) { _sleptNs = 0; _sleepsNb = 0; }
+
+    // Tickers registration
+    static void Attach(HostTicker *ticker);
+    static void Detach(HostTicker *ticker);
+
+    // Restart from time 0 (the attached tickers are kept)
+    static void Reset(void) { _nowNs = 0; }
+};
+
+#endif // HOSTCLOCK_H
@@ -0,0 +1,69 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : Print.h
+// Description : Host stand-in for the Arduino Print class
+// Module dependencies : WString
+
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "WString.h"
+
+class Print {
+  public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+      size_t n = 0;
+      while (size--) n += write(*buffer++);
+      return n;
+    }
+    size_t write(const char *str) { return str ? write((const uint8_t *) str, strlen(str)) : 0; }
+
+    size_t print(const __FlashStringHelper *fstr) { return write(reinterpret_cast<const char *>(fstr)); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t print(const char str[]) { return write(str); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(unsigned char value, int base = 10) { return print(String(value, base)); }
+    size_t print(int value, int base = 10) { return print(String(value, base)); }
+    size_t print(unsigned int value, int base = 10) { return print(String(value, base)); }
+    size_t print(long value, int base = 10) { return print(String(value, base)); }
+    size_t print(unsigned long value, int base = 10) { return print(String(value, base)); }
+    size_t print(double value, int digits = 2)
+    {
+      char buf[48];
+      snprintf(buf, sizeof(buf), "%.*f", digits, value);
+      return write(buf);
+    }
+
+    size_t println(void) { return write("\r\n"); }
+    template <typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(const T& value, int base) { size_t n = print(value, base); return n + println(); }
+};
+
+#endif // PRINT_H
@@ -0,0 +1,56 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : SoftwareSerial.h
+// Description : Host stand-in for the Arduino SoftwareSerial library
+//               The library uses it for debug traces only, the output is discarded
+//               unless HOST_SOFTWARESERIAL_STDERR is defined
+// Module dependencies : Stream
+
+#ifndef SOFTWARESERIAL_H
+#define SOFTWARESERIAL_H
+
+#include <stdio.h>
+#include "Arduino.h"
+
+class SoftwareSerial : public Stream {
+  public:
+    SoftwareSerial(uint8_t receivePin, uint8_t transmitPin) { (void) receivePin; (void) transmitPin; }
+    void begin(long speed) { (void) speed; }
+    void end(void) {}
+
+    virtual size_t write(uint8_t data)
+    {
+#ifdef HOST_SOFTWARESERIAL_STDERR
+      fputc(data, stderr);
+#else
+      (void) data;
+#endif
+      return 1;
+    }
+    using Print::write;
+
+    virtual int available(void) { return 0; }
+    virtual int read(void) { return -1; }
+    virtual int peek(void) { return -1; }
+};
+
+#endif // SOFTWARESERIAL_H
@@ -0,0 +1,49 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : WString.cpp
+// Description : Host stand-in for the Arduino String class
+// Module dependencies : none
+
+#include <stdint.h>
+#include "WString.h"
+
+std::string String::Format(unsigned long long value, unsigned char base)
+{
+  if (base < 2) base = 10;
+  char buf[8 * sizeof(value) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+  do {
+    char c = (char) (value % base);
+    value /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (value);
+  return std::string(str);
+}
+
+std::string String::Format(long long value, unsigned char base)
+{
+  // As on Arduino, only base 10 prints a sign, other bases print the 32 bit pattern
+  if (base == 10 && value < 0) return "-" + Format((unsigned long long) -value, base);
+  if (value < 0) return Format((unsigned long long) (uint32_t) value, base);
+  return Format((unsigned long long) value, base);
+}
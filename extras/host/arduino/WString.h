@@ -0,0 +1,69 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : WString.h
+// Description : Host stand-in for the Arduino String class
+//               Only the subset used by the library debug functions is provided
+// Module dependencies : none
+
+#ifndef WSTRING_H
+#define WSTRING_H
+
+#include <string>
+
+class __FlashStringHelper;
+
+class String {
+    std::string _str;
+
+  public:
+    String(const char *cstr = "") : _str(cstr ? cstr : "") {}
+    String(const std::string& str) : _str(str) {}
+    String(const __FlashStringHelper *fstr) : _str(reinterpret_cast<const char *>(fstr)) {}
+    explicit String(char c) : _str(1, c) {}
+    String(unsigned char value, unsigned char base = 10) : _str(Format((unsigned long long) value, base)) {}
+    String(int value, unsigned char base = 10) : _str(Format((long long) value, base)) {}
+    String(unsigned int value, unsigned char base = 10) : _str(Format((unsigned long long) value, base)) {}
+    String(long value, unsigned char base = 10) : _str(Format((long long) value, base)) {}
+    String(unsigned long value, unsigned char base = 10) : _str(Format((unsigned long long) value, base)) {}
+    String(unsigned short value, unsigned char base = 10) : _str(Format((unsigned long long) value, base)) {}
+
+    unsigned int length(void) const { return (unsigned int) _str.length(); }
+    const char *c_str(void) const { return _str.c_str(); }
+
+    String& operator+=(const String& rhs) { _str += rhs._str; return *this; }
+    String& operator+=(const char *cstr) { _str += cstr; return *this; }
+    String& operator+=(char c) { _str += c; return *this; }
+
+    friend String operator+(const String& lhs, const String& rhs) { return String(lhs._str + rhs._str); }
+    friend String operator+(const String& lhs, const char *rhs) { return String(lhs._str + rhs); }
+    friend String operator+(const char *lhs, const String& rhs) { return String(lhs + rhs._str); }
+    friend String operator+(const String& lhs, char rhs) { return String(lhs._str + rhs); }
+
+    bool operator==(const String& rhs) const { return _str == rhs._str; }
+    bool operator!=(const String& rhs) const { return _str != rhs._str; }
+
+  private:
+    static std::string Format(unsigned long long value, unsigned char base);
+    static std::string Format(long long value, unsigned char base);
+};
+
+#endif // WSTRING_H
@@ -0,0 +1,41 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : sleep.h
+// Description : Host stand-in for avr/sleep.h
+//               sleep_cpu() lets the virtual clock run till the next interrupt (received or
+//               sent char, timer 0 overflow) and accounts the slept time (see HostClock::Sleep())
+// Module dependencies : HostClock
+
+#ifndef SLEEP_H
+#define SLEEP_H
+
+#include "HostClock.h"
+
+#define SLEEP_MODE_IDLE        0
+#define SLEEP_MODE_PWR_DOWN    2
+
+inline void set_sleep_mode(unsigned char mode) { (void) mode; }
+inline void sleep_enable(void) {}
+inline void sleep_disable(void) {}
+inline void sleep_cpu(void) { HostClock::Sleep(); }
+
+#endif // SLEEP_H
@@ -0,0 +1,39 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : wdt.h
+// Description : Host stand-in for avr/wdt.h
+//               Arming the watchdog is how the library reboots the device, the host
+//               build reports it and terminates the process instead
+// Module dependencies : none
+
+#ifndef WDT_H
+#define WDT_H
+
+#define WDTO_15MS   0
+#define WDTO_500MS  5
+#define WDTO_1S     6
+
+void wdt_enable(unsigned char timeout);
+inline void wdt_reset(void) {}
+inline void wdt_disable(void) {}
+
+#endif // WDT_H
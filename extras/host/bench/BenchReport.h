@@ -0,0 +1,103 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : BenchReport.h
+// Description : Helpers shared by the host benchmarks : wall clock measurement of a
+//               function and machine readable (JSON or CSV) result output.
+//               Results of different releases can be compared line by line, the
+//               key of a result is "name" + "param".
+// Module dependencies : none
+
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from optimizing away a computed value
+template <typename T> inline void BenchSink(const T& value) { asm volatile("" : : "g"(&value) : "memory"); }
+
+class BenchReport {
+    struct Result {
+      std::string name;
+      std::string param;
+      unsigned long long iterations;
+      double nsPerOp;
+      std::string note;  // free text, not part of the key (e.g. counters observed during the run)
+    };
+    std::vector<Result> _results;
+    bool _csv;
+
+  public:
+    // "--csv" on the command line selects CSV output, JSON otherwise
+    BenchReport(int argc, char *argv[]) : _csv(false)
+    {
+      for (int i = 1; i < argc; i++) if (!strcmp(argv[i], "--csv")) _csv = true;
+    }
+
+    // Run "op" in batches until at least "minNs" of wall time has elapsed
+    // and record the time per call
+    template <typename Op> void Measure(const char *name, const std::string& param, Op op, unsigned long long minNs = 50000000ULL)
+    {
+      typedef std::chrono::steady_clock Clock;
+      for (int i = 0; i < 1000; i++) op(); // warm-up
+      unsigned long long iterations = 0, batch = 1000, elapsedNs = 0;
+      Clock::time_point start = Clock::now();
+      while (elapsedNs < minNs) {
+        for (unsigned long long i = 0; i < batch; i++) op();
+        iterations += batch;
+        batch *= 2;
+        elapsedNs = (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+      }
+      Add(name, param, iterations, (double) elapsedNs / iterations);
+    }
+
+    void Add(const char *name, const std::string& param, unsigned long long iterations, double nsPerOp, const std::string& note = "")
+    {
+      Result result = { name, param, iterations, nsPerOp, note };
+      _results.push_back(result);
+    }
+
+    // Attach a note to the last recorded result
+    void Note(const std::string& note)
+    {
+      if (!_results.empty()) _results.back().note = note;
+    }
+
+    void Print(FILE *out = stdout) const
+    {
+      if (_csv) fprintf(out, "name,param,iterations,ns_per_op,ops_per_s,note\n");
+      else fprintf(out, "[\n");
+      for (size_t i = 0; i < _results.size(); i++) {
+        const Result& r = _results[i];
+        double opsPerSec = r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0;
+        if (_csv) fprintf(out, "%s,%s,%llu,%.2f,%.0f,%s\n", r.name.c_str(), r.param.c_str(), r.iterations, r.nsPerOp, opsPerSec, r.note.c_str());
+        else fprintf(out, "  {\"name\": \"%s\", \"param\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"ops_per_s\": %.0f, \"note\": \"%s\"}%s\n",
+                     r.name.c_str(), r.param.c_str(), r.iterations, r.nsPerOp, opsPerSec, r.note.c_str(), (i + 1 < _results.size()) ? "," : "");
+      }
+      if (!_csv) fprintf(out, "]\n");
+    }
+};
+
+#endif // BENCHREPORT_H
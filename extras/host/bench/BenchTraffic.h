@@ -0,0 +1,58 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : BenchTraffic.h
+// Description : Bus traffic helpers shared by the host benchmarks : reproducible
+//               pseudo random sequence and group write frames of other devices.
+// Module dependencies : KnxDevice
+
+#ifndef BENCHTRAFFIC_H
+#define BENCHTRAFFIC_H
+
+#include <stdint.h>
+#include "KnxDevice.h"
+
+// Linear congruential generator : the same seed gives the same traffic on every host
+static uint32_t lcgState = 12345;
+
+static inline void RandomSeed(uint32_t seed) { lcgState = seed; }
+
+// Pseudo random value in [0, range[
+static inline uint32_t Random(uint32_t range)
+{
+  lcgState = lcgState * 1103515245 + 12345;
+  return (lcgState >> 8) % range;
+}
+
+// Frame of a 1 bit group write sent by the device 1.1.50, returns the frame length
+static inline uint16_t BuildGroupWrite(byte frame[], word target, byte value)
+{
+  KnxTelegram telegram;
+  telegram.SetSourceAddress(P_ADDR(1, 1, 50));
+  telegram.SetTargetAddress(target);
+  telegram.SetCommand(KNX_COMMAND_VALUE_WRITE);
+  telegram.SetFirstPayloadByte(value & 0x01);
+  telegram.UpdateChecksum();
+  for (byte i = 0; i < telegram.GetTelegramLength(); i++) frame[i] = telegram.ReadRawByte(i);
+  return telegram.GetTelegramLength();
+}
+
+#endif // BENCHTRAFFIC_H
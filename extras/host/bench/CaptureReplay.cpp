@@ -0,0 +1,291 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ *
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : CaptureReplay.cpp
+// Description : Replay of capture files (see KnxCapture.h) through a device in NORMAL mode. The 32 most
+//               used group addresses of the capture are assigned to the com objects, the frames are put
+//               on the emulated bus at their captured time divided by the speed factor (1 : real time),
+//               or back to back with "max". Long bus idle periods are skipped, so that a day of traffic
+//               is replayed in a few seconds of wall clock time whatever the speed.
+//               Measured : wall clock time spent in Knx.task() per frame, ACK service latency,
+//               missing ACK services (frames whose end of packet has been missed, i.e. merged with the
+//               next one or lost), UART and RX interrupt ring overruns, frames delayed by the bus
+//               occupancy (compressed gaps), and addressed telegrams not delivered to the com objects.
+//               The sketch sleeps for the time returned by Knx.task() and wakes up on each received
+//               char, or with -l stalls for a fixed time after each Knx.task() call.
+//               One JSON object is printed per capture file.
+// Usage : capture_replay [-s speed|max] [-l stall_us] capture.knxc ...
+// Module dependencies : KnxDevice, TpUartEmulator, KnxCapture, HostClock
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+#include "KnxDevice.h"
+#include "TpUartEmulator.h"
+#include "KnxCapture.h"
+
+// Device definition, as done by the sketches : the group addresses are assigned from the capture content
+#define REPLAY_COM_OBJECTS_NB 32
+KnxComObject KnxDevice::_comObjectsList[] = {
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN), KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject);
+#ifdef KNX_NO_HEAP
+KNX_DEVICE_STATIC_STORAGE(REPLAY_COM_OBJECTS_NB * KnxLongValuesSize(KNX_DPT_1_001));
+#endif
+
+byte KnxTools::_paramSizeList[] = { PARAM_UINT8 };
+const byte KnxTools::_numberOfParams = sizeof (_paramSizeList);
+
+static unsigned long eventsNb = 0;
+void knxEvents(byte index) { (void) index; eventsNb++; }
+
+#define TASK_COST_NS        20000ULL   // CPU time of one Knx.task() call
+#define INJECT_AHEAD_NS     2000000ULL // frames are handed to the emulator 2 ms before their start
+#define IDLE_SKIP_NS        10000000ULL // bus idle periods longer than 10 ms are skipped
+
+// Frames scheduled on the bus, to measure the delay caused by the bus occupancy
+static std::map<uint32_t, uint64_t> scheduledFrames;
+static unsigned long delayedNb = 0;
+static uint64_t delaySumNs = 0, delayMaxNs = 0;
+
+static void OnFrame(void *context, const type_EmuFrameReport& report)
+{
+  (void) context;
+  std::map<uint32_t, uint64_t>::iterator it = scheduledFrames.find(report.frameId);
+  if (it == scheduledFrames.end()) return;
+  if (report.startNs > it->second) {
+    uint64_t delayNs = report.startNs - it->second;
+    delayedNb++;
+    delaySumNs += delayNs;
+    if (delayNs > delayMaxNs) delayMaxNs = delayNs;
+  }
+  scheduledFrames.erase(it);
+}
+
+// Group telegram with a standard frame, complete and with a valid checksum
+static bool IsGroupTelegram(const type_KnxCaptureRecord& record)
+{
+  if ((record.storedNb < KNX_TELEGRAM_MIN_SIZE) || (record.storedNb != record.charsNb)) return false;
+  if ((record.status & KNX_MONITOR_FRAME_CHECKSUM_OK) == 0) return false;
+  return ((record.bytes[0] & 0x80) != 0) && ((record.bytes[5] & 0x80) != 0);
+}
+
+static word TargetAddress(const type_KnxCaptureRecord& record)
+{
+  return (word) ((record.bytes[3] << 8) | record.bytes[4]);
+}
+
+static bool Replay(TpUartEmulator& emulator, const char *path, double speed, bool followDeadline, unsigned long stallUs)
+{
+  KnxCaptureReader reader;
+  type_KnxCaptureRecord record;
+
+  // 1st pass : the most used group addresses
+  std::map<word, unsigned long> groupsUse;
+  if (!reader.Open(path)) return false;
+  while (reader.Read(record)) {
+    if (IsGroupTelegram(record)) groupsUse[TargetAddress(record)]++;
+  }
+  reader.Close();
+  std::vector<std::pair<unsigned long, word> > groups;
+  for (std::map<word, unsigned long>::iterator it = groupsUse.begin(); it != groupsUse.end(); ++it)
+    groups.push_back(std::make_pair(it->second, it->first));
+  std::sort(groups.rbegin(), groups.rend());
+  if (groups.size() > REPLAY_COM_OBJECTS_NB) groups.resize(REPLAY_COM_OBJECTS_NB);
+  std::vector<word> addresses;
+  for (byte i = 0; i < REPLAY_COM_OBJECTS_NB; i++) {
+    // unused com objects get an address not seen in the capture
+    word addr = (i < groups.size()) ? groups[i].second : (word) (G_ADDR(31, 7, 255) - i);
+    Knx.setComObjectAddress(i, addr, true);
+    addresses.push_back(addr);
+  }
+  std::sort(addresses.begin(), addresses.end());
+
+  if (Knx.begin(Serial, P_ADDR(15, 15, 250)) != KNX_DEVICE_OK) {
+    fprintf(stderr, "begin() failed\n");
+    exit(1);
+  }
+  // let the init reads of the com objects end (no answer on the emulated bus)
+  while (Knx.isActive() || !emulator.IsBusIdle()) {
+    Knx.task();
+    HostClock::Advance(TASK_COST_NS);
+  }
+  emulator.ClearStats();
+#if defined(KNX_STATS)
+  Knx.clearStatistics();
+#endif
+  emulator.SetFrameCallback(OnFrame, NULL);
+  scheduledFrames.clear();
+  delayedNb = 0; delaySumNs = 0; delayMaxNs = 0;
+  eventsNb = 0;
+  uint32_t overrunsAtStart = Serial.RxOverrunsNb();
+
+  // 2nd pass : replay
+  if (!reader.Open(path)) return false;
+  bool pending = reader.Read(record);
+  uint64_t captureStartMicros = pending ? record.timeMicros : 0, captureEndMicros = captureStartMicros;
+  uint64_t startNs = HostClock::NowNs() + 10000000ULL, nextInjectNs = startNs;
+  unsigned long framesNb = 0, expectedEventsNb = 0, taskCallsNb = 0;
+  uint64_t taskWallSumNs = 0, taskWallMaxNs = 0;
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+
+  while (pending || !emulator.IsBusIdle() || Knx.isActive()) {
+    uint64_t nowNs = HostClock::NowNs();
+    // Traffic : the frames are handed over a bit ahead of their start time, and not before the bus gets
+    // free (the frames beyond the bus capacity are delayed)
+    while (pending) {
+      uint64_t busFreeNs = (emulator.BusFreeNs() > startNs) ? emulator.BusFreeNs() : startNs;
+      if (speed > 0) nextInjectNs = startNs + (uint64_t) ((record.timeMicros - captureStartMicros) * 1000.0 / speed);
+      else nextInjectNs = busFreeNs;
+      if (nowNs + INJECT_AHEAD_NS < ((nextInjectNs > busFreeNs) ? nextInjectNs : busFreeNs)) break;
+      if (record.storedNb) {
+        uint32_t frameId = emulator.InjectFrame(record.bytes, record.storedNb, nextInjectNs,
+                                                (record.status & KNX_MONITOR_FRAME_ACK) ? record.ack : HOST_KNX_BUS_ACK);
+        scheduledFrames[frameId] = nextInjectNs;
+        framesNb++;
+        if (IsGroupTelegram(record) && std::binary_search(addresses.begin(), addresses.end(), TargetAddress(record)))
+          expectedEventsNb++;
+      }
+      captureEndMicros = record.timeMicros;
+      pending = reader.Read(record);
+    }
+
+    std::chrono::steady_clock::time_point taskStart = std::chrono::steady_clock::now();
+    uint64_t deadlineNs = Knx.task() * 1000ULL;
+    uint64_t taskWallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - taskStart).count();
+    taskWallSumNs += taskWallNs;
+    if (taskWallNs > taskWallMaxNs) taskWallMaxNs = taskWallNs;
+    taskCallsNb++;
+    HostClock::Advance(TASK_COST_NS);
+
+    // Long idle periods of the capture are skipped
+    uint64_t injectAtNs = pending ? ((nextInjectNs > emulator.BusFreeNs()) ? nextInjectNs : emulator.BusFreeNs()) - INJECT_AHEAD_NS
+                                  : HostClock::NowNs();
+    if (emulator.IsBusIdle() && !Knx.isActive() && (injectAtNs > HostClock::NowNs() + IDLE_SKIP_NS)) {
+      HostClock::AdvanceTo(injectAtNs);
+      continue;
+    }
+    if (!followDeadline) {
+      HostClock::Advance(stallUs * 1000ULL);
+      continue;
+    }
+    // Sleep till the deadline (counted from the task() call), the next frame or the next received char
+    uint32_t rxCharsNb = Serial.RxCharsNb();
+    uint64_t wakeUpNs = HostClock::NowNs() - TASK_COST_NS + deadlineNs;
+    if (pending && (injectAtNs < wakeUpNs)) wakeUpNs = injectAtNs;
+    while ((HostClock::NowNs() < wakeUpNs) && (Serial.RxCharsNb() == rxCharsNb)
+           && (pending || !emulator.IsBusIdle())) HostClock::Sleep(wakeUpNs);
+  }
+  reader.Close();
+  double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  const type_EmuStats& stats = emulator.Stats();
+  uint32_t acked = stats.acksAddressedNb + stats.acksNotAddressedNb + stats.acksLateNb;
+  double captureS = (captureEndMicros - captureStartMicros) / 1e6;
+  printf("{\"file\": \"%s\", \"speed\": ", path);
+  if (speed > 0) printf("%g", speed); else printf("\"max\"");
+  printf(", \"loop\": \"%s\", \"stall_us\": %lu, \"frames\": %lu, \"group_addresses\": %lu, \"capture_s\": %.1f, "
+         "\"replay_s\": %.1f, \"wall_s\": %.3f, \"speedup\": %.0f, \"task_calls\": %lu, \"task_ns_per_frame\": %.0f, "
+         "\"task_ns_max\": %llu, \"ack_latency_avg_us\": %.1f, \"ack_latency_max_us\": %.1f, \"acks_late\": %lu, "
+         "\"missed_eops\": %lu, \"uart_overruns\": %lu, \"rx_ring_overruns\": %lu, \"frames_delayed\": %lu, "
+         "\"delay_avg_ms\": %.1f, \"delay_max_ms\": %.1f, \"addressed\": %lu, \"events\": %lu",
+         followDeadline ? "deadline" : "fixed", followDeadline ? 0 : stallUs, framesNb, (unsigned long) groupsUse.size(),
+         captureS, (HostClock::NowNs() - startNs) / 1e9, wallS, wallS > 0 ? captureS / wallS : 0.0, taskCallsNb,
+         framesNb ? (double) taskWallSumNs / framesNb : 0.0, (unsigned long long) taskWallMaxNs,
+         acked ? stats.ackLatencySumNs / 1000.0 / acked : 0.0, stats.ackLatencyMaxNs / 1000.0,
+         (unsigned long) stats.acksLateNb, (unsigned long) stats.acksMissingNb,
+         (unsigned long) (Serial.RxOverrunsNb() - overrunsAtStart),
+#if defined(KNXTPUART_RX_ISR)
+         (unsigned long) Knx.getRxOverrunsNb(),
+#else
+         0UL,
+#endif
+         delayedNb, delayedNb ? delaySumNs / 1e6 / delayedNb : 0.0, delayMaxNs / 1e6, expectedEventsNb, eventsNb);
+#if defined(KNX_STATS)
+  // Library statistics : EOP to knxEvents() latency, reception errors, telegrams per com object
+  const type_knx_device_stats& knxStats = Knx.getStatistics();
+  type_knx_com_object_stats comObjectStats;
+  unsigned long comObjectsRxNb = 0;
+  for (byte i = 0; i < REPLAY_COM_OBJECTS_NB; i++) {
+    Knx.getComObjectStatistics(i, comObjectStats);
+    comObjectsRxNb += comObjectStats.rxNb;
+  }
+  printf(", \"event_us_p50\": %lu, \"event_us_p99\": %lu, \"event_us_max\": %lu, \"checksum_errors\": %u, "
+         "\"length_invalid\": %u, \"incomplete\": %u, \"ack_deadlines_missed\": %u, \"com_objects_rx\": %lu",
+         knxStats.rxEventMicros.Percentile(50), knxStats.rxEventMicros.Percentile(99), knxStats.rxEventMicros.Max(),
+         knxStats.rxErrors.checksumErrorsNb, knxStats.rxErrors.lengthInvalidNb, knxStats.rxErrors.incompleteNb,
+         knxStats.rxErrors.ackDeadlineMissedNb, comObjectsRxNb);
+#endif
+  printf("}\n");
+  emulator.SetFrameCallback(NULL, NULL);
+  Knx.end();
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  double speed = 1.0;
+  bool followDeadline = true;
+  unsigned long stallUs = 0;
+  int filesNb = 0;
+  TpUartEmulator emulator(Serial);
+
+  for (int i = 1; i < argc; i++) {
+    if ((!strcmp(argv[i], "-s")) && (i + 1 < argc)) {
+      i++;
+      speed = strcmp(argv[i], "max") ? atof(argv[i]) : 0.0;
+    } else if ((!strcmp(argv[i], "-l")) && (i + 1 < argc)) {
+      followDeadline = false;
+      stallUs = strtoul(argv[++i], NULL, 10);
+    } else {
+      filesNb++;
+      if (!Replay(emulator, argv[i], speed, followDeadline, stallUs)) {
+        fprintf(stderr, "cannot read %s\n", argv[i]);
+        return 1;
+      }
+    }
+  }
+  if (!filesNb) {
+    fprintf(stderr, "usage : capture_replay [-s speed|max] [-l stall_us] capture.knxc ...\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : IdleTime.cpp
+// Description : Host harness measuring the time the CPU can spend asleep (Knx.sleep(), IDLE sleep
+//               mode woken up by the UART interrupts and the timer 0 overflow) under bus traffic.
+//               Group write telegrams from the other devices are injected at a given rate, 1 out
+//               of 8 addressed to the device, the device sends a value every second.
+//               Each rate is run with a busy loop and with a sleeping loop, the late/missing ACKs
+//               and the received/sent telegrams show that nothing is lost while sleeping.
+//               One JSON object is printed per (rate, loop).
+// Usage : idle_time [telegrams_per_second ...]
+// Module dependencies : KnxDevice, TpUartEmulator, HostClock, BenchTraffic
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "KnxDevice.h"
+#include "TpUartEmulator.h"
+#include "BenchTraffic.h"
+
+// Device definition, as done by the sketches
+KnxComObject KnxDevice::_comObjectsList[] = {
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_9_001, COM_OBJ_SENSOR),
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject);
+#ifdef KNX_NO_HEAP
+KNX_DEVICE_STATIC_STORAGE(KnxLongValuesSize(KNX_DPT_1_001, KNX_DPT_9_001));
+#endif
+
+byte KnxTools::_paramSizeList[] = { PARAM_UINT8 };
+const byte KnxTools::_numberOfParams = sizeof (_paramSizeList);
+
+static unsigned long eventsNb = 0;
+void knxEvents(byte index) { (void) index; eventsNb++; }
+
+#define RUN_DURATION_NS     30000000000ULL // 30 s per run
+#define SEND_PERIOD_NS      1000000000ULL  // one telegram sent by the device every second
+#define TASK_COST_NS        20000ULL       // CPU time of one Knx.task() call
+
+static void Run(TpUartEmulator& emulator, unsigned long ratePerSecond, bool sleeping)
+{
+  Knx.setComObjectAddress(0, G_ADDR(1, 0, 1), true);
+  Knx.setComObjectAddress(1, G_ADDR(1, 0, 2), true);
+  if (Knx.begin(Serial, P_ADDR(1, 1, 1)) != KNX_DEVICE_OK) {
+    fprintf(stderr, "begin() failed\n");
+    exit(1);
+  }
+  emulator.ClearStats();
+  HostClock::ClearSleepStats();
+  eventsNb = 0;
+  RandomSeed(12345); // same traffic for both loops
+
+  // Traffic : random gaps around the mean period, each frame is injected just before its start time
+  byte frame[HOST_TPUART_FRAME_MAX_SIZE];
+  uint64_t periodNs = 1000000000ULL / ratePerSecond;
+  uint64_t startNs = HostClock::NowNs() + 10000000ULL, injectNs = startNs, nextSendNs = startNs;
+  uint64_t endNs = startNs + RUN_DURATION_NS;
+  unsigned long addressedNb = 0, taskCallsNb = 0;
+  float value = 20.0;
+  while (!emulator.IsBusIdle() || (HostClock::NowNs() < endNs)) {
+    if ((HostClock::NowNs() >= injectNs) && (injectNs < endNs)) {
+      bool addressed = (Random(8) == 0);
+      if (addressed) addressedNb++;
+      uint16_t length = BuildGroupWrite(frame, addressed ? G_ADDR(1, 0, 1) : G_ADDR(2, 0, 1 + Random(200)), (byte) Random(2));
+      emulator.InjectFrame(frame, length, injectNs);
+      injectNs += periodNs / 2 + Random((uint32_t) (periodNs / 1000)) * 1000ULL;
+    }
+    if ((HostClock::NowNs() >= nextSendNs) && (nextSendNs < endNs)) {
+      value += 0.5;
+      Knx.write(1, value);
+      nextSendNs += SEND_PERIOD_NS;
+    }
+    Knx.task();
+    taskCallsNb++;
+    HostClock::Advance(TASK_COST_NS);
+    if (sleeping) Knx.sleep();
+  }
+
+  const type_EmuStats& stats = emulator.Stats();
+  uint64_t durationNs = HostClock::NowNs() - (startNs - 10000000ULL);
+  printf("{\"rate_per_s\": %lu, \"loop\": \"%s\", \"bus_load_pct\": %.1f, \"idle_pct\": %.1f, \"wakeups\": %lu, "
+         "\"task_calls\": %lu, \"addressed\": %lu, \"events\": %lu, \"sent\": %lu, \"acks_late\": %lu, \"acks_missing\": %lu, "
+         "\"monitor_load_pct\": %u, \"monitor_rate_per_s\": %.1f, \"monitor_addressed_pct\": %u}\n",
+         ratePerSecond, sleeping ? "sleep" : "busy", 100.0 * stats.busBusyNs / durationNs,
+         100.0 * HostClock::SleptNs() / durationNs, (unsigned long) HostClock::SleepsNb(), taskCallsNb,
+         addressedNb, eventsNb, (unsigned long) stats.confirmsOkNb,
+         (unsigned long) stats.acksLateNb, (unsigned long) stats.acksMissingNb,
+         Knx.getBusLoad(), Knx.getBusTelegramsRate(), Knx.getBusAddressedRatio());
+  Knx.end();
+}
+
+int main(int argc, char *argv[])
+{
+  static const unsigned long defaultRates[] = { 1, 10, 30 };
+  TpUartEmulator emulator(Serial);
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      Run(emulator, strtoul(argv[i], NULL, 10), false);
+      Run(emulator, strtoul(argv[i], NULL, 10), true);
+    }
+  } else {
+    for (size_t i = 0; i < sizeof(defaultRates) / sizeof(defaultRates[0]); i++) {
+      Run(emulator, defaultRates[i], false);
+      Run(emulator, defaultRates[i], true);
+    }
+  }
+  return 0;
+}
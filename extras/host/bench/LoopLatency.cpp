@@ -0,0 +1,130 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : LoopLatency.cpp
+// Description : Host harness measuring how the loop() latency budget of a sketch affects
+//               the reception path : ACK service latency (1,7 ms deadline), missing/late ACKs,
+//               lost telegrams and UART overruns.
+//               A stream of group write telegrams is injected on the emulated bus while the
+//               "sketch" calls Knx.task() and then works for a fixed time (the stall).
+//               With "deadline", the sketch sleeps for the time returned by Knx.task() instead,
+//               and is woken up by any received char (as the UART RX interrupt does on AVR).
+//               One JSON object is printed per stall value, with the nb of Knx.task() calls.
+// Usage : loop_latency [stall_us|deadline ...]
+// Module dependencies : KnxDevice, TpUartEmulator, HostClock, BenchTraffic
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "KnxDevice.h"
+#include "TpUartEmulator.h"
+#include "BenchTraffic.h"
+
+// Device definition, as done by the sketches
+KnxComObject KnxDevice::_comObjectsList[] = {
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+    KnxComObject(KNX_DPT_9_001, COM_OBJ_SENSOR),
+    KnxComObject(KNX_DPT_5_001, COM_OBJ_LOGIC_IN),
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject);
+#ifdef KNX_NO_HEAP
+KNX_DEVICE_STATIC_STORAGE(KnxLongValuesSize(KNX_DPT_1_001, KNX_DPT_9_001, KNX_DPT_5_001));
+#endif
+
+byte KnxTools::_paramSizeList[] = { PARAM_UINT8 };
+const byte KnxTools::_numberOfParams = sizeof (_paramSizeList);
+
+static unsigned long eventsNb = 0;
+void knxEvents(byte index) { (void) index; eventsNb++; }
+
+#define TELEGRAMS_PER_RUN   2000
+#define TASK_COST_NS        20000ULL // CPU time of one Knx.task() call
+#define SLEEP_STEP_NS       10000ULL // wake-up check period of the sleeping sketch (deadline mode)
+
+static void Run(TpUartEmulator& emulator, unsigned long stallUs, bool followDeadline)
+{
+  Knx.setComObjectAddress(0, G_ADDR(1, 0, 1), true);
+  Knx.setComObjectAddress(1, G_ADDR(1, 0, 2), true);
+  Knx.setComObjectAddress(2, G_ADDR(1, 0, 3), true);
+  if (Knx.begin(Serial, P_ADDR(1, 1, 1)) != KNX_DEVICE_OK) {
+    fprintf(stderr, "begin() failed\n");
+    exit(1);
+  }
+  emulator.ClearStats();
+  eventsNb = 0;
+  uint32_t overrunsAtStart = Serial.RxOverrunsNb();
+
+  // Traffic : one telegram every 20 to 60 ms, 1 out of 4 addressed to us
+  byte frame[HOST_TPUART_FRAME_MAX_SIZE];
+  uint64_t atNs = HostClock::NowNs() + 10000000ULL;
+  unsigned long addressedNb = 0;
+  for (int i = 0; i < TELEGRAMS_PER_RUN; i++) {
+    bool addressed = (Random(4) == 0);
+    if (addressed) addressedNb++;
+    uint16_t length = BuildGroupWrite(frame, addressed ? G_ADDR(1, 0, 1) : G_ADDR(2, 0, 1 + Random(200)), (byte) i);
+    emulator.InjectFrame(frame, length, atNs);
+    atNs += 20000000ULL + Random(40000) * 1000ULL;
+  }
+
+  unsigned long taskCallsNb = 0;
+  while (!emulator.IsBusIdle() || (HostClock::NowNs() < atNs)) {
+    uint64_t deadlineNs = Knx.task() * 1000ULL;
+    taskCallsNb++;
+    HostClock::Advance(TASK_COST_NS);
+    if (!followDeadline) {
+      HostClock::Advance(stallUs * 1000ULL);
+      continue;
+    }
+    // Sleep till the deadline (counted from the task() call) or the next received char
+    uint32_t rxCharsNb = Serial.RxCharsNb();
+    uint64_t wakeUpNs = HostClock::NowNs() - TASK_COST_NS + deadlineNs;
+    while ((HostClock::NowNs() < wakeUpNs) && (Serial.RxCharsNb() == rxCharsNb)
+           && (!emulator.IsBusIdle() || (HostClock::NowNs() < atNs))) HostClock::Advance(SLEEP_STEP_NS);
+  }
+
+  const type_EmuStats& stats = emulator.Stats();
+  uint32_t acked = stats.acksAddressedNb + stats.acksNotAddressedNb + stats.acksLateNb;
+  printf("{\"loop\": \"%s\", \"stall_us\": %lu, \"task_calls\": %lu, \"telegrams\": %lu, \"addressed\": %lu, \"events\": %lu, "
+         "\"ack_latency_avg_us\": %.1f, \"ack_latency_max_us\": %.1f, \"acks_late\": %lu, \"acks_missing\": %lu, "
+         "\"uart_overruns\": %lu}\n",
+         followDeadline ? "deadline" : "fixed", stallUs, taskCallsNb, (unsigned long) stats.injectedFramesNb, addressedNb, eventsNb,
+         acked ? stats.ackLatencySumNs / 1000.0 / acked : 0.0, stats.ackLatencyMaxNs / 1000.0,
+         (unsigned long) stats.acksLateNb, (unsigned long) stats.acksMissingNb,
+         (unsigned long) (Serial.RxOverrunsNb() - overrunsAtStart));
+  Knx.end();
+}
+
+int main(int argc, char *argv[])
+{
+  static const unsigned long defaultStalls[] = { 0, 200, 400, 1000, 2000, 5000, 20000 };
+  TpUartEmulator emulator(Serial);
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      if (!strcmp(argv[i], "deadline")) Run(emulator, 0, true);
+      else Run(emulator, strtoul(argv[i], NULL, 10), false);
+    }
+  } else {
+    for (size_t i = 0; i < sizeof(defaultStalls) / sizeof(defaultStalls[0]); i++) Run(emulator, defaultStalls[i], false);
+    Run(emulator, 0, true);
+  }
+  return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ *
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : MonitorCapture.cpp
+// Description : Host harness of the BUS_MONITOR mode frames capture. Frames of random length, with
+//               1 out of 16 checksums corrupted and 1 out of 8 NACK/BUSY bus acknowledges, are
+//               injected at a given rate, or back to back (rate 0, saturated bus). The sketch loop
+//               empties the 8 frames ring every 50 ms only, and writes the frames to a capture file.
+//               Each captured frame is checked against the injected one (chars, checksum status,
+//               ACK char), the capture file is read back and checked as well.
+//               With KNX_TELEGRAM_EXTENDED_MAX_LENGTH, 1 out of 32 frames is an extended frame whose length
+//               field (200) exceeds the telegram storage : it ends before its length (incomplete) with more
+//               chars than stored (truncated), the stored chars only are checked.
+//               One JSON object is printed per rate.
+// Usage : monitor_capture [-o capture_prefix] [telegrams_per_second ...]
+//         the capture of each rate is left in <capture_prefix>_<rate>.knxc (default prefix "monitor_capture")
+// Module dependencies : KnxDevice, TpUartEmulator, KnxCapture, HostClock, BenchTraffic
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "KnxDevice.h"
+#include "TpUartEmulator.h"
+#include "KnxCapture.h"
+#include "BenchTraffic.h"
+
+// Device definition, as done by the sketches (the com objects are not used in BUS_MONITOR mode)
+KnxComObject KnxDevice::_comObjectsList[] = {
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject);
+#ifdef KNX_NO_HEAP
+KNX_DEVICE_STATIC_STORAGE(KnxLongValuesSize(KNX_DPT_1_001));
+#endif
+
+byte KnxTools::_paramSizeList[] = { PARAM_UINT8 };
+const byte KnxTools::_numberOfParams = sizeof (_paramSizeList);
+
+void knxEvents(byte index) { (void) index; }
+
+#define RUN_DURATION_NS     20000000000ULL // 20 s per run
+#define DRAIN_PERIOD_NS     50000000ULL    // the ring is emptied every 50 ms
+#define TASK_COST_NS        20000ULL       // CPU time of one Knx.task() call
+#define MONITOR_FRAMES_NB   8
+
+static type_tpuart_monitor_frame monitorFrames[MONITOR_FRAMES_NB];
+
+// Frame put on the bus, as expected in the capture
+struct ExpectedFrame {
+  std::vector<uint8_t> bytes;
+  uint8_t busAck;
+  bool checksumOk;
+  bool oversized;
+};
+
+// Nb of chars of a frame stored by the library
+static word StoredNb(size_t charsNb) { return (charsNb < KNX_TELEGRAM_MAX_SIZE) ? (word) charsNb : KNX_TELEGRAM_MAX_SIZE; }
+
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+#define OVERSIZED_LENGTH_FIELD  200
+#define OVERSIZED_CHARS_NB      (KNX_TELEGRAM_MAX_SIZE + 4)
+
+// Extended frame announcing OVERSIZED_LENGTH_FIELD payload bytes, OVERSIZED_CHARS_NB chars long
+static ExpectedFrame BuildOversizedFrame(void)
+{
+  ExpectedFrame expected;
+  KnxTelegram telegram;
+  uint8_t xorSum = 0;
+
+  telegram.SetSourceAddress(P_ADDR(1, 1, 1 + Random(250)));
+  telegram.SetTargetAddress((word) Random(0x10000));
+  telegram.SetPayloadLength(KNX_TELEGRAM_STANDARD_MAX_LENGTH + 1); // extended frame
+  telegram.SetCommand(KNX_COMMAND_VALUE_WRITE);
+  telegram.WriteRawByte(OVERSIZED_LENGTH_FIELD, KNX_TELEGRAM_HEADER_SIZE);
+  for (word i = 0; i < OVERSIZED_CHARS_NB - 1; i++) {
+    uint8_t data = (i < KNX_TELEGRAM_HEADER_SIZE + 3) ? telegram.ReadRawByte(i) : (uint8_t) Random(256);
+    expected.bytes.push_back(data);
+    xorSum ^= data;
+  }
+  expected.bytes.push_back(~xorSum);
+  expected.checksumOk = true;
+  expected.busAck = HOST_KNX_BUS_ACK;
+  expected.oversized = true;
+  return expected;
+}
+#endif
+
+static ExpectedFrame BuildFrame(void)
+{
+  ExpectedFrame expected;
+  KnxTelegram telegram;
+#if KNX_TELEGRAM_EXTENDED_MAX_LENGTH
+  if (Random(32) == 0) return BuildOversizedFrame();
+#endif
+  byte payloadLength = 1 + Random(15);
+
+  telegram.SetSourceAddress(P_ADDR(1, 1, 1 + Random(250)));
+  telegram.SetTargetAddress((word) Random(0x10000));
+  telegram.SetMulticast(Random(4) != 0);
+  telegram.SetPayloadLength(payloadLength);
+  telegram.SetCommand(KNX_COMMAND_VALUE_WRITE);
+  for (byte i = 0; i < payloadLength; i++) telegram.WriteRawByte((byte) Random(256), KNX_TELEGRAM_HEADER_SIZE + 1 + i);
+  telegram.UpdateChecksum();
+  for (byte i = 0; i < telegram.GetTelegramLength(); i++) expected.bytes.push_back(telegram.ReadRawByte(i));
+  expected.checksumOk = (Random(16) != 0);
+  if (!expected.checksumOk) expected.bytes.back() ^= 0x55;
+  switch (Random(16)) {
+    case 0: expected.busAck = HOST_KNX_BUS_NACK; break;
+    case 1: expected.busAck = HOST_KNX_BUS_BUSY; break;
+    default: expected.busAck = HOST_KNX_BUS_ACK; break;
+  }
+  expected.oversized = false;
+  return expected;
+}
+
+static void Run(TpUartEmulator& emulator, unsigned long ratePerSecond, const char *capturePrefix)
+{
+  char path[256];
+  snprintf(path, sizeof(path), "%s_%lu.knxc", capturePrefix, ratePerSecond);
+
+  Knx.setMonitorBuffer(monitorFrames, MONITOR_FRAMES_NB);
+  if (Knx.begin(Serial, P_ADDR(1, 1, 255), BUS_MONITOR) != KNX_DEVICE_OK) {
+    fprintf(stderr, "begin() failed\n");
+    exit(1);
+  }
+  KnxCaptureWriter writer;
+  if (!writer.Open(path, micros())) {
+    fprintf(stderr, "cannot create %s\n", path);
+    exit(1);
+  }
+  emulator.ClearStats();
+  RandomSeed(12345);
+
+  std::deque<ExpectedFrame> expectedFrames;
+  std::vector<ExpectedFrame> capturedFrames; // injected frames in capture order, for the file check
+  unsigned long injectedNb = 0, capturedNb = 0, mismatchesNb = 0, checksumErrorsNb = 0, ackErrorsNb = 0;
+  unsigned long incompleteNb = 0, oversizedNb = 0, maxDelayUs = 0;
+  uint64_t startNs = HostClock::NowNs() + 10000000ULL, injectNs = startNs, nextDrainNs = startNs;
+  uint64_t endNs = startNs + RUN_DURATION_NS;
+  type_tpuart_monitor_frame frame;
+
+  // The sketch empties the ring and checks each frame against the injected one
+  auto drain = [&]() {
+    while (Knx.getMonitorFrame(frame)) {
+      capturedNb++;
+      writer.Write(frame);
+      unsigned long delayUs = micros() - frame.timeMicrosec;
+      if (delayUs > maxDelayUs) maxDelayUs = delayUs;
+      if (expectedFrames.empty()) { mismatchesNb++; continue; }
+      ExpectedFrame expected = expectedFrames.front();
+      expectedFrames.pop_front();
+      capturedFrames.push_back(expected);
+      bool same = (frame.charsNb == expected.bytes.size());
+      for (word i = 0; same && (i < StoredNb(frame.charsNb)); i++) same = (frame.telegram.ReadRawByte(i) == expected.bytes[i]);
+      if (expected.oversized) { // incomplete and truncated by design
+        oversizedNb++;
+        same = same && (frame.status & KNX_MONITOR_FRAME_INCOMPLETE) && (frame.status & KNX_MONITOR_FRAME_TRUNCATED);
+      } else if (frame.status & KNX_MONITOR_FRAME_INCOMPLETE) incompleteNb++;
+      if (!same) mismatchesNb++;
+      if (((frame.status & KNX_MONITOR_FRAME_CHECKSUM_OK) != 0) != expected.checksumOk) checksumErrorsNb++;
+      if ((!(frame.status & KNX_MONITOR_FRAME_ACK)) || (frame.ack != expected.busAck)) ackErrorsNb++;
+    }
+  };
+
+  while (!emulator.IsBusIdle() || (HostClock::NowNs() < endNs) || Knx.isActive()) {
+    uint64_t nowNs = HostClock::NowNs();
+    // Traffic : random gaps around the mean period, or a bus kept busy
+    if ((nowNs >= injectNs) && (injectNs < endNs)) {
+      ExpectedFrame expected = BuildFrame();
+      emulator.InjectFrame(&expected.bytes[0], (uint16_t) expected.bytes.size(), injectNs, expected.busAck);
+      expectedFrames.push_back(expected);
+      injectedNb++;
+      if (ratePerSecond) {
+        uint64_t periodNs = 1000000000ULL / ratePerSecond;
+        injectNs += periodNs / 2 + Random((uint32_t) (periodNs / 1000)) * 1000ULL;
+      } else injectNs = emulator.BusFreeNs() - 10000000ULL; // 10 ms before the bus gets free
+    }
+    Knx.task();
+    HostClock::Advance(TASK_COST_NS);
+    if (nowNs >= nextDrainNs) {
+      drain();
+      nextDrainNs += DRAIN_PERIOD_NS;
+    }
+  }
+  drain();
+  uint64_t durationNs = HostClock::NowNs() - startNs;
+  writer.Close();
+
+  // Read back of the capture file
+  KnxCaptureReader reader;
+  type_KnxCaptureRecord record;
+  unsigned long readNb = 0, readErrorsNb = 0;
+  uint64_t lastTimeMicros = 0;
+  long fileSize = 0;
+  if (reader.Open(path)) {
+    while (reader.Read(record)) {
+      if ((readNb >= capturedFrames.size()) || (record.storedNb != StoredNb(capturedFrames[readNb].bytes.size()))
+          || memcmp(record.bytes, &capturedFrames[readNb].bytes[0], record.storedNb)
+          || (record.ack != capturedFrames[readNb].busAck) || (record.timeMicros < lastTimeMicros)) readErrorsNb++;
+      lastTimeMicros = record.timeMicros;
+      readNb++;
+    }
+    reader.Close();
+    FILE *file = fopen(path, "rb");
+    if (file) {
+      fseek(file, 0, SEEK_END);
+      fileSize = ftell(file);
+      fclose(file);
+    }
+  } else readErrorsNb++;
+
+  const type_EmuStats& stats = emulator.Stats();
+  printf("{\"rate_per_s\": %lu, \"bus_load_pct\": %.1f, \"injected\": %lu, \"captured\": %lu, \"lost\": %u, "
+         "\"mismatches\": %lu, \"checksum_errors\": %lu, \"ack_errors\": %lu, \"incomplete\": %lu, \"oversized\": %lu, "
+         "\"max_delay_ms\": %.1f, \"file_records\": %lu, \"file_errors\": %lu, \"file_bytes_per_frame\": %.1f}\n",
+         ratePerSecond, 100.0 * stats.busBusyNs / durationNs, injectedNb, capturedNb, Knx.getMonitorLostFramesNb(),
+         mismatchesNb, checksumErrorsNb, ackErrorsNb, incompleteNb, oversizedNb, maxDelayUs / 1000.0, readNb, readErrorsNb,
+         readNb ? (double) (fileSize - KNX_CAPTURE_HEADER_SIZE) / readNb : 0.0);
+  Knx.end();
+}
+
+int main(int argc, char *argv[])
+{
+  static const unsigned long defaultRates[] = { 10, 30, 0 };
+  std::vector<unsigned long> rates;
+  const char *capturePrefix = "monitor_capture";
+  TpUartEmulator emulator(Serial);
+
+  for (int i = 1; i < argc; i++) {
+    if ((!strcmp(argv[i], "-o")) && (i + 1 < argc)) capturePrefix = argv[++i];
+    else rates.push_back(strtoul(argv[i], NULL, 10));
+  }
+  if (rates.empty()) rates.assign(defaultRates, defaultRates + sizeof(defaultRates) / sizeof(defaultRates[0]));
+  for (size_t i = 0; i < rates.size(); i++) Run(emulator, rates[i], capturePrefix);
+  return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ *
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// File : Programming.cpp
+// Description : Host harness of the KONNEKTING programming protocol (KnxTools). A Suite model programs a
+//               device of 100 parameters and 50 com objects over the emulated bus, one message at a time :
+//               each message is sent once the answer (ACK) of the previous one has been received.
+//               The session is run with the one parameter / one com object messages ("single") and with
+//               the block messages ("block"), then the tables are read back with the block messages.
+//               Measured : programming time, messages, bus frames, read back time and mismatches
+//               against the EEPROM content expected.
+//               One JSON object is printed per mode.
+// Usage : programming
+// Module dependencies : KnxDevice, KnxTools, TpUartEmulator, HostClock
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "KnxDevice.h"
+#include "KnxTools.h"
+#include "TpUartEmulator.h"
+
+// Message types and layouts of the protocol (see KnxTools.cpp)
+#define MSG_ACK                         0
+#define MSG_WRITE_PROGRAMMING_MODE      10
+#define MSG_WRITE_PARAMETER             30
+#define MSG_WRITE_PARAMETER_BLOCK       33
+#define MSG_READ_PARAMETER_BLOCK        34
+#define MSG_ANSWER_PARAMETER_BLOCK      35
+#define MSG_WRITE_COM_OBJECT            40
+#define MSG_WRITE_COM_OBJECT_BLOCK      46
+#define MSG_READ_COM_OBJECT_BLOCK       47
+#define MSG_ANSWER_COM_OBJECT_BLOCK     48
+#define PARAMETER_BLOCK_MAX_SIZE        9
+#define COM_OBJECT_BLOCK_MAX_NB         3
+
+#define COM_OBJECTS_NB          50
+#define PARAMS_NB               100
+#define EEPROM_COMOBJECTTABLE   10
+#define EEPROM_PARAMTABLE       (EEPROM_COMOBJECTTABLE + (COM_OBJECTS_NB + 1) * 3)
+#define DEVICE_ADDR             P_ADDR(1, 1, 254) // factory setting
+#define SUITE_ADDR              P_ADDR(1, 1, 200)
+#define PROG_ADDR               G_ADDR(15, 7, 255)
+#define SUITE_TURNAROUND_NS     2000000ULL    // Suite delay between an answer and the next message
+#define ANSWER_TIMEOUT_NS       1000000000ULL
+#define TASK_COST_NS            20000ULL      // CPU time of one Knx.task() call
+
+// Device definition, as done by the sketches : programming com object, 50 1 bit com objects, 100 parameters
+#define CO KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN)
+#define CO10 CO, CO, CO, CO, CO, CO, CO, CO, CO, CO
+KnxComObject KnxDevice::_comObjectsList[] = {
+    Tools.createProgComObject(),
+    CO10, CO10, CO10, CO10, CO10
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject);
+#ifdef KNX_NO_HEAP
+KNX_DEVICE_STATIC_STORAGE(KnxLongValuesSize(KNX_DPT_60000_000));
+#endif
+
+#define P10 PARAM_UINT8, PARAM_UINT16, PARAM_UINT8, PARAM_UINT8, PARAM_INT32, \
+            PARAM_UINT8, PARAM_INT16, PARAM_UINT8, PARAM_UINT16, PARAM_UINT8
+byte KnxTools::_paramSizeList[] = { P10, P10, P10, P10, P10, P10, P10, P10, P10, P10 };
+const byte KnxTools::_numberOfParams = sizeof (_paramSizeList);
+
+void knxEvents(byte index) { (void) index; }
+
+static uint32_t lcgState = 12345;
+static byte RandomByte(void)
+{
+  lcgState = lcgState * 1103515245 + 12345;
+  return (byte) (lcgState >> 16);
+}
+
+// Suite side of the session
+struct Session {
+  TpUartEmulator *emulator;
+  bool answered;
+  byte answer[14];
+  unsigned long messagesNb;
+  unsigned long timeoutsNb;
+};
+static Session session;
+
+static void OnFrame(void *context, const type_EmuFrameReport& report)
+{
+  (void) context;
+  // programming messages of the device : 14 bytes payload following the APCI
+  if (!report.fromHost || (report.length != 23) || (((report.bytes[3] << 8) | report.bytes[4]) != PROG_ADDR)) return;
+  memcpy(session.answer, &report.bytes[8], 14);
+  session.answered = true;
+}
+
+static void RunDevice(uint64_t untilNs)
+{
+  while (HostClock::NowNs() < untilNs) {
+    uint64_t deadlineNs = Knx.task() * 1000ULL;
+    HostClock::Advance(TASK_COST_NS);
+    if (deadlineNs > TASK_COST_NS) {
+      uint64_t wakeUpNs = HostClock::NowNs() - TASK_COST_NS + deadlineNs;
+      if (wakeUpNs > untilNs) wakeUpNs = untilNs;
+      if (wakeUpNs > HostClock::NowNs()) HostClock::AdvanceTo(wakeUpNs);
+    }
+  }
+}
+
+// Sends a message on the programming group address and runs the device till its answer
+static bool Exchange(const byte msg[14])
+{
+  KnxTelegram telegram;
+  byte frame[HOST_TPUART_FRAME_MAX_SIZE];
+  telegram.SetSourceAddress(SUITE_ADDR);
+  telegram.SetTargetAddress(PROG_ADDR);
+  telegram.ChangePriority(KNX_PRIORITY_SYSTEM_VALUE);
+  telegram.SetPayloadLength(15);
+  telegram.SetCommand(KNX_COMMAND_VALUE_WRITE);
+  telegram.SetLongPayload(msg, 14);
+  telegram.UpdateChecksum();
+  for (word i = 0; i < telegram.GetTelegramLength(); i++) frame[i] = telegram.ReadRawByte(i);
+
+  session.answered = false;
+  session.messagesNb++;
+  uint64_t sendNs = HostClock::NowNs() + SUITE_TURNAROUND_NS;
+  session.emulator->InjectFrame(frame, telegram.GetTelegramLength(), sendNs);
+  uint64_t timeoutNs = sendNs + ANSWER_TIMEOUT_NS;
+  while (!session.answered && (HostClock::NowNs() < timeoutNs)) RunDevice(HostClock::NowNs() + TASK_COST_NS);
+  if (!session.answered) session.timeoutsNb++;
+  return session.answered;
+}
+
+static bool ExchangeAck(const byte msg[14])
+{
+  return Exchange(msg) && (session.answer[1] == MSG_ACK) && (session.answer[2] == 0x00);
+}
+
+static void NewMessage(byte msg[14], byte type)
+{
+  memset(msg, 0, 14);
+  msg[1] = type;
+}
+
+static void SetProgrammingMode(bool on)
+{
+  byte msg[14];
+  NewMessage(msg, MSG_WRITE_PROGRAMMING_MODE);
+  msg[2] = DEVICE_ADDR >> 8;
+  msg[3] = DEVICE_ADDR & 0xFF;
+  msg[4] = on ? 0x01 : 0x00;
+  ExchangeAck(msg);
+}
+
+// Expected tables content
+static byte comObjectTable[COM_OBJECTS_NB * 3];
+static byte paramTable[PARAMS_NB * 4];
+static word paramTableSize;
+
+static unsigned long ProgramSingle(void)
+{
+  byte msg[14];
+  unsigned long errorsNb = 0;
+  for (word p = 0, offset = 0; p < PARAMS_NB; offset += KnxTools::Tools.getParamSize(p++)) {
+    NewMessage(msg, MSG_WRITE_PARAMETER);
+    msg[2] = p;
+    memcpy(&msg[3], &paramTable[offset], KnxTools::Tools.getParamSize(p));
+    if (!ExchangeAck(msg)) errorsNb++;
+  }
+  for (byte c = 0; c < COM_OBJECTS_NB; c++) {
+    NewMessage(msg, MSG_WRITE_COM_OBJECT);
+    msg[2] = c;
+    memcpy(&msg[3], &comObjectTable[c * 3], 3);
+    if (!ExchangeAck(msg)) errorsNb++;
+  }
+  return errorsNb;
+}
+
+static unsigned long ProgramBlock(void)
+{
+  byte msg[14];
+  unsigned long errorsNb = 0;
+  for (word offset = 0; offset < paramTableSize; offset += PARAMETER_BLOCK_MAX_SIZE) {
+    byte nb = (paramTableSize - offset < PARAMETER_BLOCK_MAX_SIZE) ? paramTableSize - offset : PARAMETER_BLOCK_MAX_SIZE;
+    NewMessage(msg, MSG_WRITE_PARAMETER_BLOCK);
+    msg[2] = offset >> 8;
+    msg[3] = offset & 0xFF;
+    msg[4] = nb;
+    memcpy(&msg[5], &paramTable[offset], nb);
+    if (!ExchangeAck(msg)) errorsNb++;
+  }
+  for (byte c = 0; c < COM_OBJECTS_NB; c += COM_OBJECT_BLOCK_MAX_NB) {
+    byte nb = (COM_OBJECTS_NB - c < COM_OBJECT_BLOCK_MAX_NB) ? COM_OBJECTS_NB - c : COM_OBJECT_BLOCK_MAX_NB;
+    NewMessage(msg, MSG_WRITE_COM_OBJECT_BLOCK);
+    msg[2] = c;
+    msg[3] = nb;
+    memcpy(&msg[4], &comObjectTable[c * 3], nb * 3);
+    if (!ExchangeAck(msg)) errorsNb++;
+  }
+  return errorsNb;
+}
+
+// Reads the tables back with the block messages, returns the nb of bytes differing from the expected content
+static unsigned long ReadBack(void)
+{
+  byte msg[14];
+  unsigned long mismatchesNb = 0;
+  for (word offset = 0; offset < paramTableSize; offset += PARAMETER_BLOCK_MAX_SIZE) {
+    byte nb = (paramTableSize - offset < PARAMETER_BLOCK_MAX_SIZE) ? paramTableSize - offset : PARAMETER_BLOCK_MAX_SIZE;
+    NewMessage(msg, MSG_READ_PARAMETER_BLOCK);
+    msg[2] = offset >> 8;
+    msg[3] = offset & 0xFF;
+    msg[4] = nb;
+    if (!Exchange(msg) || (session.answer[1] != MSG_ANSWER_PARAMETER_BLOCK) || (session.answer[4] != nb)) {
+      mismatchesNb += nb;
+      continue;
+    }
+    for (byte i = 0; i < nb; i++) if (session.answer[5 + i] != paramTable[offset + i]) mismatchesNb++;
+  }
+  for (byte c = 0; c < COM_OBJECTS_NB; c += COM_OBJECT_BLOCK_MAX_NB) {
+    byte nb = (COM_OBJECTS_NB - c < COM_OBJECT_BLOCK_MAX_NB) ? COM_OBJECTS_NB - c : COM_OBJECT_BLOCK_MAX_NB;
+    NewMessage(msg, MSG_READ_COM_OBJECT_BLOCK);
+    msg[2] = c;
+    msg[3] = nb;
+    if (!Exchange(msg) || (session.answer[1] != MSG_ANSWER_COM_OBJECT_BLOCK) || (session.answer[3] != nb)) {
+      mismatchesNb += nb * 3;
+      continue;
+    }
+    for (byte i = 0; i < nb * 3; i++) if (session.answer[4 + i] != comObjectTable[c * 3 + i]) mismatchesNb++;
+  }
+  return mismatchesNb;
+}
+
+// Nb of bytes of the EEPROM tables differing from the expected content
+static unsigned long CheckEeprom(void)
+{
+  unsigned long mismatchesNb = 0;
+  for (word i = 0; i < COM_OBJECTS_NB * 3; i++)
+    if (EEPROM.read(EEPROM_COMOBJECTTABLE + i) != comObjectTable[i]) mismatchesNb++;
+  for (word i = 0; i < paramTableSize; i++)
+    if (EEPROM.read(EEPROM_PARAMTABLE + i) != paramTable[i]) mismatchesNb++;
+  return mismatchesNb;
+}
+
+static void Run(TpUartEmulator& emulator, bool block)
+{
+  EEPROM.clear();
+  Tools.init(Serial, 3, 8, 0xDEAD, 0xFF, 0x00);
+  RunDevice(HostClock::NowNs() + 100000000ULL); // TPUART reset and first Knx.task() calls
+  memset(&session, 0, sizeof(session));
+  session.emulator = &emulator;
+  emulator.ClearStats();
+  emulator.SetFrameCallback(&OnFrame, NULL);
+
+  uint64_t startNs = HostClock::NowNs();
+  SetProgrammingMode(true);
+  unsigned long errorsNb = block ? ProgramBlock() : ProgramSingle();
+  SetProgrammingMode(false);
+  uint64_t programmingNs = HostClock::NowNs() - startNs;
+  unsigned long programmingMessagesNb = session.messagesNb;
+  unsigned long eepromMismatchesNb = CheckEeprom();
+
+  startNs = HostClock::NowNs();
+  session.messagesNb = 0;
+  unsigned long readMismatchesNb = ReadBack();
+  uint64_t readNs = HostClock::NowNs() - startNs;
+  emulator.SetFrameCallback(NULL, NULL);
+
+  const type_EmuStats& emuStats = emulator.Stats();
+  printf("{\"mode\": \"%s\", \"params\": %u, \"param_bytes\": %u, \"com_objects\": %u, \"programming_ms\": %.1f, "
+         "\"messages\": %lu, \"errors\": %lu, \"timeouts\": %lu, \"eeprom_mismatches\": %lu, \"read_back_ms\": %.1f, "
+         "\"read_back_messages\": %lu, \"read_back_mismatches\": %lu, \"bus_frames\": %lu}\n",
+         block ? "block" : "single", PARAMS_NB, paramTableSize, COM_OBJECTS_NB, programmingNs / 1e6,
+         programmingMessagesNb, errorsNb, session.timeoutsNb, eepromMismatchesNb, readNs / 1e6, session.messagesNb,
+         readMismatchesNb, (unsigned long) (emuStats.injectedFramesNb + emuStats.hostFramesNb));
+  Knx.end();
+}
+
+int main(void)
+{
+  TpUartEmulator emulator(Serial);
+
+  paramTableSize = 0;
+  for (byte p = 0; p < PARAMS_NB; p++) paramTableSize += KnxTools::Tools.getParamSize(p);
+  for (word i = 0; i < paramTableSize; i++) paramTable[i] = RandomByte();
+  for (byte c = 0; c < COM_OBJECTS_NB; c++) {
+    comObjectTable[c * 3 + 0] = 0x10 + (c >> 4);  // GA hi
+    comObjectTable[c * 3 + 1] = RandomByte();     // GA lo
+    comObjectTable[c * 3 + 2] = (c & 1) ? 0x80 : 0x00; // settings, active flag
+  }
+
+  Run(emulator, false);
+  Run(emulator, true);
+  return 0;
+}
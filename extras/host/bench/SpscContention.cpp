@@ -0,0 +1,149 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : SpscContention.cpp
+// Description : Producer/consumer contention benchmark of the action ring buffers on the host
+//               One producer thread appends sequence numbers, one consumer thread pops them :
+//               - ActionSpscRingBuffer, lock free
+//               - ActionRingBuffer protected by a mutex (what sharing it between two contexts requires)
+//               "lossless" runs wait for a free slot before appending, "drop" runs append at full
+//               speed and report the lost elements. The consumer checks the order of the elements.
+//               A waiting side yields its time slice, so that the results stay meaningful on a single core host.
+// Usage : spsc_contention [--csv]
+// Module dependencies : ActionSpscRingBuffer, ActionRingBuffer, BenchReport
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "ActionRingBuffer.h"
+#include "ActionSpscRingBuffer.h"
+#include "BenchReport.h"
+
+#define ELEMENTS_NB 1000000UL
+
+typedef std::chrono::steady_clock Clock;
+
+static std::string Param(const char *fmt, unsigned long value)
+{
+  char buf[64];
+  snprintf(buf, sizeof(buf), fmt, value);
+  return buf;
+}
+
+static void CheckOrder(uint32_t value, uint32_t& expected, bool lossless)
+{
+  if ((value < expected) || (lossless && (value != expected))) {
+    fprintf(stderr, "order error : got %u, expected %u\n", (unsigned) value, (unsigned) expected);
+    exit(1);
+  }
+  expected = value + 1;
+}
+
+template <uint16_t SIZE> static void SpscRun(BenchReport& report, bool lossless)
+{
+  static ActionSpscRingBuffer<uint32_t, SIZE> buffer; // static : 32768 * 4 bytes do not fit well on the stack
+  buffer = ActionSpscRingBuffer<uint32_t, SIZE>();
+  std::atomic<bool> producerDone(false);
+  unsigned long received = 0;
+
+  Clock::time_point start = Clock::now();
+  std::thread consumer([&]() {
+    uint32_t value, expected = 0;
+    for (;;) {
+      if (buffer.Pop(value)) {
+        CheckOrder(value, expected, lossless);
+        received++;
+      } else if (producerDone.load() && buffer.IsEmpty()) break;
+      else std::this_thread::yield();
+    }
+  });
+  for (uint32_t i = 0; i < ELEMENTS_NB; i++) {
+    if (lossless) while (buffer.ElementsNb() >= buffer.Capacity()) std::this_thread::yield(); // single producer : a free slot stays free
+    buffer.Append(i);
+  }
+  producerDone = true;
+  consumer.join();
+  double elapsedNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+  std::string note = Param("max_elements=%lu", buffer.ElementsMaxNb()) + Param(" received=%lu", received) + Param(" lost=%lu", buffer.LostElementsNb());
+  unsigned long lost = buffer.LostElementsNb();
+  if ((lost < 0xFFFF) ? (received + lost != ELEMENTS_NB) : (received + lost > ELEMENTS_NB)) { // the lost counter saturates
+    fprintf(stderr, "ActionSpscRingBuffer : %lu received + %lu lost != %lu\n", received, lost, ELEMENTS_NB);
+    exit(1);
+  }
+  report.Add(lossless ? "ActionSpscRingBuffer lossless" : "ActionSpscRingBuffer drop", Param("size=%lu", SIZE),
+             ELEMENTS_NB, elapsedNs / ELEMENTS_NB, note);
+}
+
+template <uint16_t SIZE> static void MutexRun(BenchReport& report)
+{
+  static ActionRingBuffer<uint32_t, SIZE> buffer;
+  buffer = ActionRingBuffer<uint32_t, SIZE>();
+  std::mutex lock;
+  std::atomic<bool> producerDone(false);
+
+  Clock::time_point start = Clock::now();
+  std::thread consumer([&]() {
+    uint32_t value, expected = 0;
+    for (;;) {
+      bool popped;
+      { std::lock_guard<std::mutex> guard(lock); popped = buffer.Pop(value); }
+      if (popped) CheckOrder(value, expected, true);
+      else if (producerDone.load()) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!buffer.ElementsNb()) break;
+      } else std::this_thread::yield();
+    }
+  });
+  for (uint32_t i = 0; i < ELEMENTS_NB; ) {
+    bool full;
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      full = (buffer.ElementsNb() >= SIZE); // ActionRingBuffer overwrites when full, wait instead
+      if (!full) buffer.Append(i++);
+    }
+    if (full) std::this_thread::yield();
+  }
+  producerDone = true;
+  consumer.join();
+  double elapsedNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+  report.Add("ActionRingBuffer+mutex lossless", Param("size=%lu", SIZE), ELEMENTS_NB, elapsedNs / ELEMENTS_NB);
+}
+
+int main(int argc, char *argv[])
+{
+  BenchReport report(argc, argv);
+
+  MutexRun<16>(report);
+  MutexRun<255>(report); // ActionRingBuffer indexes are bytes
+  SpscRun<16>(report, true);
+  SpscRun<256>(report, true);
+  SpscRun<4096>(report, true);
+  SpscRun<32768>(report, true);
+  SpscRun<16>(report, false);
+  SpscRun<256>(report, false);
+  SpscRun<4096>(report, false);
+  report.Print();
+  return 0;
+}
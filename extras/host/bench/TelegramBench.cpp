@@ -0,0 +1,240 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : TelegramBench.cpp
+// Description : Micro-benchmarks of the per-telegram hot path on the host :
+//               KnxTelegram checksum/validity/copy, com object update from a telegram,
+//               group address lookup for 1 to 255 com objects and DPT conversions.
+//               ops_per_s of the telegram functions reads as telegrams/s.
+// Usage : telegram_bench [--csv]
+// Module dependencies : KnxDevice, KnxTpUart, TpUartEmulator, BenchReport, BenchTraffic
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "KnxDevice.h"
+#include "TpUartEmulator.h"
+#include "BenchReport.h"
+#include "BenchTraffic.h"
+
+// Device definition, as done by the sketches (not used by the benchmarks)
+KnxComObject KnxDevice::_comObjectsList[] = {
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject);
+#ifdef KNX_NO_HEAP
+// the long values of the com objects of ComObjectBenchmarks() are counted as well
+KNX_DEVICE_STATIC_STORAGE(KnxLongValuesSize(KNX_DPT_1_001, KNX_DPT_9_001, KNX_DPT_12_001, KNX_DPT_10_001, KNX_DPT_14_000));
+#endif
+
+byte KnxTools::_paramSizeList[] = { PARAM_UINT8 };
+const byte KnxTools::_numberOfParams = sizeof (_paramSizeList);
+
+void knxEvents(byte index) { (void) index; }
+
+static std::string Param(const char *fmt, long value)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), fmt, value);
+  return buf;
+}
+
+static void BuildTelegram(KnxTelegram& telegram, byte payloadLength)
+{
+  telegram.ClearTelegram();
+  telegram.SetSourceAddress(P_ADDR(1, 1, 50));
+  telegram.SetTargetAddress(G_ADDR(1, 2, 3));
+  telegram.SetPayloadLength(payloadLength);
+  telegram.SetCommand(KNX_COMMAND_VALUE_WRITE);
+  for (byte i = 0; i < payloadLength - 1; i++) telegram.WriteRawByte(i * 7 + 1, KNX_TELEGRAM_HEADER_SIZE + 2 + i);
+  telegram.UpdateChecksum();
+}
+
+static void TelegramBenchmarks(BenchReport& report)
+{
+  static const byte payloadLengths[] = { 1, 2, 3, 5, 15 };
+  for (size_t p = 0; p < sizeof(payloadLengths); p++) {
+    KnxTelegram telegram, dest;
+    BuildTelegram(telegram, payloadLengths[p]);
+    std::string param = Param("payload=%ld", payloadLengths[p]);
+    report.Measure("KnxTelegram::CalculateChecksum", param, [&]() { BenchSink(telegram.CalculateChecksum()); });
+    report.Measure("KnxTelegram::GetValidity", param, [&]() { BenchSink(telegram.GetValidity()); });
+    report.Measure("KnxTelegram::Copy", param, [&]() { telegram.Copy(dest); BenchSink(dest); });
+  }
+}
+
+static void ComObjectBenchmarks(BenchReport& report)
+{
+  static const struct { e_KnxDPT_ID dpt; const char *name; } dpts[] = {
+    { KNX_DPT_1_001, "DPT1.001" }, { KNX_DPT_5_001, "DPT5.001" }, { KNX_DPT_9_001, "DPT9.001" },
+    { KNX_DPT_12_001, "DPT12.001" }, { KNX_DPT_10_001, "DPT10.001" }, { KNX_DPT_14_000, "DPT14.000" } };
+  for (size_t d = 0; d < sizeof(dpts) / sizeof(dpts[0]); d++) {
+    KnxComObject comObject(dpts[d].dpt, COM_OBJ_LOGIC_IN);
+    KnxTelegram telegram;
+    BuildTelegram(telegram, comObject.GetLength());
+    report.Measure("KnxComObject::UpdateValue(KnxTelegram)", dpts[d].name, [&]() { BenchSink(comObject.UpdateValue(telegram)); });
+  }
+}
+
+// Com objects of "targets" found by IsAddressAssigned() + GetNextAssignedComObject(), compared to a linear search
+static void CheckAddressLookup(const KnxTpUart& tpuart, std::vector<KnxComObject>& list,
+                               const std::vector<type_tpuart_index_entry>& listening, word addr, std::vector<byte>& targets)
+{
+  byte index;
+  targets.clear();
+  for (boolean found = tpuart.IsAddressAssigned(addr, index); found; found = tpuart.GetNextAssignedComObject(addr, index))
+    targets.push_back(index);
+  std::vector<byte> expected;
+  for (size_t i = 0; i < list.size(); i++) {
+    if (!list[i].isActive()) continue;
+    boolean listens = (list[i].GetAddr() == addr);
+    for (size_t l = 0; l < listening.size(); l++) if ((listening[l].index == i) && (listening[l].addr == addr)) listens = true;
+    if (listens) expected.push_back((byte) i);
+  }
+  if (targets != expected) {
+    fprintf(stderr, "Address lookup mismatch for address %04X\n", addr);
+    exit(1);
+  }
+}
+
+static void AddressLookupBenchmark(BenchReport& report, int nb, int sharing, int listeningNb)
+{
+  std::vector<KnxComObject> list;
+  list.reserve(nb);
+  std::vector<word> addresses;
+  for (int i = 0; i < nb; i++) {
+    list.emplace_back(KNX_DPT_1_001, COM_OBJ_LOGIC_IN);
+    // "sharing" com objects per address, one com object of 8 is inactive
+    word addr = (i % sharing) ? addresses[i - 1] : G_ADDR(Random(32), Random(8), Random(256));
+    list[i].SetAddr(addr);
+    list[i].setActive(Random(8) != 0);
+    addresses.push_back(addr);
+  }
+  // additional listening addresses, half of them already used by other com objects
+  std::vector<type_tpuart_index_entry> listening(listeningNb);
+  for (int l = 0; l < listeningNb; l++) {
+    listening[l].index = (byte) Random(nb);
+    listening[l].addr = Random(2) ? addresses[Random(nb)] : G_ADDR(Random(32), Random(8), Random(256));
+  }
+  for (int l = 0; l < listeningNb; l++) addresses.push_back(listening[l].addr);
+  const type_tpuart_index_entry *listeningPtr = listeningNb ? &listening[0] : NULL;
+  KnxTpUart tpuart(Serial, P_ADDR(1, 1, 1), NORMAL);
+  if (tpuart.Reset() != KNX_TPUART_OK) {
+    fprintf(stderr, "TPUART reset failed\n");
+    exit(1);
+  }
+#ifdef KNX_NO_HEAP
+  std::vector<type_tpuart_index_entry> indexTable(nb + listeningNb);
+  auto attach = [&]() { BenchSink(tpuart.AttachComObjectsList(&list[0], (byte) nb, &indexTable[0], listeningPtr, (byte) listeningNb)); };
+#else
+  auto attach = [&]() { BenchSink(tpuart.AttachComObjectsList(&list[0], (byte) nb, listeningPtr, (byte) listeningNb)); };
+#endif
+  std::string param = Param("objects=%ld", nb) + ((sharing > 1) ? Param(" shared=%ld", sharing) : "")
+                    + (listeningNb ? Param(" listening=%ld", listeningNb) : "");
+  report.Measure("KnxTpUart::AttachComObjectsList", param, attach);
+  attach();
+
+  // half of the lookups hit an assigned address, the other half miss
+  std::vector<word> lookups;
+  std::vector<byte> targets;
+  for (int i = 0; i < 1024; i++) {
+    lookups.push_back((i & 1) ? addresses[Random(addresses.size())] : (word) Random(0x10000));
+    CheckAddressLookup(tpuart, list, listening, lookups[i], targets);
+  }
+  size_t next = 0;
+  report.Measure("KnxTpUart::IsAddressAssigned", param, [&]() {
+    byte index;
+    BenchSink(tpuart.IsAddressAssigned(lookups[next], index));
+    next = (next + 1) & 1023;
+  });
+#if defined(KNXTPUART_ACK_FILTER)
+  report.Measure("KnxTpUart::IsAddressAccepted", param, [&]() {
+    BenchSink(tpuart.IsAddressAccepted(lookups[next]));
+    next = (next + 1) & 1023;
+  });
+  // accepted addresses without active com object, over the whole address range
+  unsigned long falsePositivesNb = 0, rejectedNb = 0;
+  for (unsigned long addr = 0; addr < 0x10000; addr++) {
+    byte index;
+    if (tpuart.IsAddressAssigned((word) addr, index)) {
+      if (!tpuart.IsAddressAccepted((word) addr)) {
+        fprintf(stderr, "Address %04lX of an active com object rejected by the ACK filter\n", addr);
+        exit(1);
+      }
+    } else {
+      rejectedNb++;
+      if (tpuart.IsAddressAccepted((word) addr)) falsePositivesNb++;
+    }
+  }
+  report.Note(Param("false_positives=%ld/10000", (long) (falsePositivesNb * 10000 / rejectedNb)));
+#endif
+  // all the com objects targeted by the address
+  report.Measure("KnxTpUart::GetNextAssignedComObject (all targets)", param, [&]() {
+    byte index;
+    for (boolean found = tpuart.IsAddressAssigned(lookups[next], index); found; found = tpuart.GetNextAssignedComObject(lookups[next], index))
+      BenchSink(index);
+    next = (next + 1) & 1023;
+  });
+}
+
+static void AddressLookupBenchmarks(BenchReport& report)
+{
+  static const int sizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 192, 255 };
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) AddressLookupBenchmark(report, sizes[s], 1, 0);
+  for (size_t s = 4; s < sizeof(sizes) / sizeof(sizes[0]); s++) AddressLookupBenchmark(report, sizes[s], 4, 0);
+  // 255 additional listening addresses spread over the com objects
+  for (size_t s = 4; s < sizeof(sizes) / sizeof(sizes[0]); s++) AddressLookupBenchmark(report, sizes[s], 1, 255);
+}
+
+template <typename T> static void DptBenchmark(BenchReport& report, const char *typeName, byte format, const char *formatName, T value)
+{
+  byte dpt[4];
+  T result;
+  std::string param = std::string(formatName) + "/" + typeName;
+  report.Measure("ConvertToDpt", param, [&]() { BenchSink(ConvertToDpt(value, dpt, format)); BenchSink(dpt); });
+  ConvertToDpt(value, dpt, format);
+  report.Measure("ConvertFromDpt", param, [&]() { BenchSink(ConvertFromDpt(dpt, result, format)); BenchSink(result); });
+}
+
+static void DptBenchmarks(BenchReport& report)
+{
+  DptBenchmark<unsigned int>(report, "unsigned int", KNX_DPT_FORMAT_U16, "U16", 51234);
+  DptBenchmark<int>(report, "int", KNX_DPT_FORMAT_V16, "V16", -1234);
+  DptBenchmark<unsigned long>(report, "unsigned long", KNX_DPT_FORMAT_U32, "U32", 3000000000UL);
+  DptBenchmark<long>(report, "long", KNX_DPT_FORMAT_V32, "V32", -123456789L);
+  DptBenchmark<float>(report, "float", KNX_DPT_FORMAT_F16, "F16", 21.37f);
+  DptBenchmark<float>(report, "float", KNX_DPT_FORMAT_F16, "F16 (large)", -6712.5f);
+  DptBenchmark<double>(report, "double", KNX_DPT_FORMAT_F16, "F16", 21.37);
+}
+
+int main(int argc, char *argv[])
+{
+  BenchReport report(argc, argv);
+  RandomSeed(4242);
+  TpUartEmulator emulator(Serial); // answers the TPUART reset requests
+
+  TelegramBenchmarks(report);
+  ComObjectBenchmarks(report);
+  AddressLookupBenchmarks(report);
+  DptBenchmarks(report);
+  report.Print();
+  return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// File : TxHandoff.cpp
+// Description : Host harness measuring the time needed to hand a telegram over to the TPUART
+//               (first to last data request received by the TPUART), per telegram size, as a
+//               function of the time loop() spends outside Knx.task().
+//               Group write telegrams from the other devices keep flowing on the emulated bus
+//               meanwhile, the late and missing ACKs show the impact of the TX on the reception.
+//               Build with and without -DKNXTPUART_TX_BURST to compare both TX modes.
+//               One JSON object is printed per (stall, telegram size).
+// Usage : tx_handoff [stall_us ...]
+// Module dependencies : KnxDevice, TpUartEmulator, HostClock, BenchTraffic
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "KnxDevice.h"
+#include "TpUartEmulator.h"
+#include "BenchTraffic.h"
+
+// Device definition, as done by the sketches : one com object per telegram size
+KnxComObject KnxDevice::_comObjectsList[] = {
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_SENSOR),      // 9 bytes telegram
+    KnxComObject(KNX_DPT_5_001, COM_OBJ_SENSOR),      // 10 bytes
+    KnxComObject(KNX_DPT_9_001, COM_OBJ_SENSOR),      // 11 bytes
+    KnxComObject(KNX_DPT_10_001, COM_OBJ_SENSOR),     // 12 bytes
+    KnxComObject(KNX_DPT_14_000, COM_OBJ_SENSOR),     // 13 bytes
+    KnxComObject(KNX_DPT_60000_000, COM_OBJ_SENSOR),  // 23 bytes
+    KnxComObject(KNX_DPT_1_001, COM_OBJ_LOGIC_IN),    // receives part of the bus traffic
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject);
+#ifdef KNX_NO_HEAP
+KNX_DEVICE_STATIC_STORAGE(KnxLongValuesSize(KNX_DPT_1_001, KNX_DPT_5_001, KNX_DPT_9_001, KNX_DPT_10_001,
+                                            KNX_DPT_14_000, KNX_DPT_60000_000, KNX_DPT_1_001));
+#endif
+
+byte KnxTools::_paramSizeList[] = { PARAM_UINT8 };
+const byte KnxTools::_numberOfParams = sizeof (_paramSizeList);
+
+void knxEvents(byte index) { (void) index; }
+
+#define TELEGRAMS_PER_SIZE  50
+#define SEND_PERIOD_NS      100000000ULL // one telegram sent by the device every 100 ms
+#define TASK_COST_NS        20000ULL     // CPU time of one Knx.task() call
+#define RX_INDEX            6            // com object receiving part of the bus traffic
+
+// Handoff statistics of the frames sent by the host
+struct HandoffStats {
+  unsigned long framesNb;
+  uint16_t length;
+  uint64_t handoffSumNs;
+  uint64_t handoffMaxNs;
+};
+
+static void OnFrame(void *context, const type_EmuFrameReport& report)
+{
+  HandoffStats *stats = (HandoffStats *) context;
+  if (!report.fromHost) return;
+  stats->framesNb++;
+  stats->length = report.length;
+  stats->handoffSumNs += report.txHandoffNs;
+  if (report.txHandoffNs > stats->handoffMaxNs) stats->handoffMaxNs = report.txHandoffNs;
+}
+
+static void Run(TpUartEmulator& emulator, unsigned long stallUs, byte index)
+{
+  for (byte i = 0; i < RX_INDEX; i++) Knx.setComObjectAddress(i, G_ADDR(3, 0, 1 + i), true);
+  Knx.setComObjectAddress(RX_INDEX, G_ADDR(1, 0, 1), true);
+  if (Knx.begin(Serial, P_ADDR(1, 1, 1)) != KNX_DEVICE_OK) {
+    fprintf(stderr, "begin() failed\n");
+    exit(1);
+  }
+  // let the init pass over before measuring
+  for (uint64_t endNs = HostClock::NowNs() + 50000000ULL; HostClock::NowNs() < endNs; HostClock::Advance(TASK_COST_NS)) Knx.task();
+  emulator.ClearStats();
+#if defined(KNX_STATS)
+  Knx.clearStatistics();
+#endif
+  HandoffStats stats = { 0, 0, 0, 0 };
+  emulator.SetFrameCallback(&OnFrame, &stats);
+  uint64_t txBlockedAtStart = Serial.TxBlockedNs();
+
+  // Traffic : one telegram every 20 to 60 ms, 1 out of 4 addressed to us
+  // Each frame is injected just before its start time so that the frames of the device get their share of the bus
+  byte frame[HOST_TPUART_FRAME_MAX_SIZE];
+  uint64_t startNs = HostClock::NowNs() + 10000000ULL, injectNs = startNs;
+  uint64_t endNs = startNs + TELEGRAMS_PER_SIZE * SEND_PERIOD_NS;
+  byte value[14] = { 'K', 'O', 'N', 'N', 'E', 'K', 'T', 'I', 'N', 'G', ' ', 'T', 'X', 0 };
+  uint64_t nextSendNs = startNs;
+  while (!emulator.IsBusIdle() || (HostClock::NowNs() < endNs)) {
+    if ((HostClock::NowNs() >= injectNs) && (injectNs < endNs)) {
+      uint16_t length = BuildGroupWrite(frame, (Random(4) == 0) ? G_ADDR(1, 0, 1) : G_ADDR(2, 0, 1 + Random(200)), (byte) Random(2));
+      emulator.InjectFrame(frame, length, injectNs);
+      injectNs += 20000000ULL + Random(40000) * 1000ULL;
+    }
+    if ((HostClock::NowNs() >= nextSendNs) && (nextSendNs < endNs)) {
+      value[0]++;
+      if (index < 2) Knx.write(index, (unsigned int) (value[0] & 1)); // 1 bit and 1 byte com objects
+      else Knx.write(index, value);
+      nextSendNs += SEND_PERIOD_NS;
+    }
+    Knx.task();
+    HostClock::Advance(TASK_COST_NS + stallUs * 1000ULL);
+  }
+  emulator.SetFrameCallback(NULL, NULL);
+
+  const type_EmuStats& emuStats = emulator.Stats();
+  printf("{\"stall_us\": %lu, \"length\": %u, \"sent\": %lu, \"handoff_avg_us\": %.1f, \"handoff_max_us\": %.1f, "
+         "\"tx_blocked_us\": %.1f, \"acks_late\": %lu, \"acks_missing\": %lu",
+         stallUs, stats.length, stats.framesNb, stats.framesNb ? stats.handoffSumNs / 1000.0 / stats.framesNb : 0.0,
+         stats.handoffMaxNs / 1000.0, (Serial.TxBlockedNs() - txBlockedAtStart) / 1000.0,
+         (unsigned long) emuStats.acksLateNb, (unsigned long) emuStats.acksMissingNb);
+#if defined(KNX_STATS)
+  const type_knx_device_stats& knxStats = Knx.getStatistics();
+  printf(", \"queue_wait_ms_p99\": %lu, \"confirm_ms_p50\": %lu, \"confirm_ms_p99\": %lu, \"confirm_ms_max\": %lu, "
+         "\"confirms_ok\": %u, \"confirms_nack\": %u, \"no_answer\": %u",
+         knxStats.txQueueWaitMillis.Percentile(99), knxStats.txConfirmMillis.Percentile(50),
+         knxStats.txConfirmMillis.Percentile(99), knxStats.txConfirmMillis.Max(),
+         knxStats.txAckNb, knxStats.txNackNb, knxStats.txNoAnswerNb);
+#endif
+  printf("}\n");
+  Knx.end();
+}
+
+int main(int argc, char *argv[])
+{
+  static const unsigned long defaultStalls[] = { 0, 400, 1000, 5000, 20000 };
+  TpUartEmulator emulator(Serial);
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++)
+      for (byte index = 0; index < RX_INDEX; index++) Run(emulator, strtoul(argv[i], NULL, 10), index);
+  } else {
+    for (size_t i = 0; i < sizeof(defaultStalls) / sizeof(defaultStalls[0]); i++)
+      for (byte index = 0; index < RX_INDEX; index++) Run(emulator, defaultStalls[i], index);
+  }
+  return 0;
+}
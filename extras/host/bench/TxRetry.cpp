@@ -0,0 +1,196 @@
+/*
+ *    This file is part of KONNEKTING Knx Device Library.
+ * 
+ *    It is derived from another GPLv3 licensed project:
+ *      The Arduino Knx Bus Device library allows to turn Arduino into "self-made" KNX bus device.
+ *      Copyright (C) 2014 2015 Franck MARINI (fm@liwan.fr)
+ *
+ *    The KONNEKTING Knx Device Library is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// File : TxRetry.cpp
+// Description : Host harness of the retransmission of the failed telegrams (see Knx.setTxRetryPolicy()).
+//               The device writes a new value every 5 s, a share of its frames fail on the emulated bus :
+//               negative Data_Confirm ("nack") or no Data_Confirm at all ("drop", the TPUART ACK timeout
+//               fires). Measured : values delivered (positive confirm), given up (give-up callback) and
+//               lost without notification, frames sent, and delay from write() to the delivery, with
+//               the ACK timeouts of the TPUART layer (confirm timeout estimate, timeouts, late confirms).
+//               With -b, group writes from the other devices load the bus meanwhile.
+//               One JSON object is printed per (attempts, failure mode, failure rate).
+// Usage : tx_retry [-b telegrams_per_second] [attempts ...]
+// Module dependencies : KnxDevice, TpUartEmulator, HostClock, BenchTraffic
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "KnxDevice.h"
+#include "TpUartEmulator.h"
+#include "BenchTraffic.h"
+
+// Device definition, as done by the sketches : one 1 byte sensor
+KnxComObject KnxDevice::_comObjectsList[] = {
+    KnxComObject(KNX_DPT_5_010, COM_OBJ_SENSOR),
+};
+const byte KnxDevice::_numberOfComObjects = sizeof (_comObjectsList) / sizeof (KnxComObject);
+#ifdef KNX_NO_HEAP
+KNX_DEVICE_STATIC_STORAGE(KnxLongValuesSize(KNX_DPT_5_010));
+#endif
+
+byte KnxTools::_paramSizeList[] = { PARAM_UINT8 };
+const byte KnxTools::_numberOfParams = sizeof (_paramSizeList);
+
+void knxEvents(byte index) { (void) index; }
+
+#define WRITES_NB           100
+#define WRITE_PERIOD_NS     5000000000ULL // longer than the worst case of the retries (4 attempts, no confirm)
+#define TASK_COST_NS        20000ULL      // CPU time of one Knx.task() call
+
+enum FailureMode { FAIL_NACK, FAIL_DROP };
+
+// Fate of the written values, indexed by value
+struct RetryStats {
+  TpUartEmulator *emulator;
+  FailureMode mode;
+  unsigned long failurePct;
+  bool failNext;                     // the next frame of the device fails
+  uint64_t writeNs[WRITES_NB];
+  bool delivered[WRITES_NB];
+  bool givenUp[WRITES_NB];
+  unsigned long framesNb;
+  uint64_t delaySumNs;
+  uint64_t delayMaxNs;
+};
+static RetryStats stats;
+
+static void ScheduleFailure(void)
+{
+  stats.failNext = Random(100) < stats.failurePct;
+  if (!stats.failNext) return;
+  if (stats.mode == FAIL_NACK) stats.emulator->NackNextFrames(1);
+  else stats.emulator->DropNextConfirms(1);
+}
+
+static void OnFrame(void *context, const type_EmuFrameReport& report)
+{
+  (void) context;
+  if (!report.fromHost) return;
+  stats.framesNb++;
+  byte value = report.bytes[8]; // 1 byte value following the APCI
+  if ((!stats.failNext) && (value < WRITES_NB) && !stats.delivered[value]) {
+    stats.delivered[value] = true;
+    uint64_t delayNs = report.endNs - stats.writeNs[value];
+    stats.delaySumNs += delayNs;
+    if (delayNs > stats.delayMaxNs) stats.delayMaxNs = delayNs;
+  }
+  ScheduleFailure();
+}
+
+static void OnGiveUp(byte index, e_KnxDeviceTxActionType command)
+{
+  (void) command;
+  byte value = Knx.read(index); // written every 5 s, the value is still the one of the telegram
+  if (value < WRITES_NB) stats.givenUp[value] = true;
+}
+
+static void Run(TpUartEmulator& emulator, byte attemptsMax, FailureMode mode, unsigned long failurePct,
+                unsigned long trafficRate)
+{
+  Knx.setComObjectAddress(0, G_ADDR(3, 0, 1), true);
+  Knx.setTxRetryPolicy(KNX_PRIORITY_NORMAL_VALUE, attemptsMax);
+  Knx.setTxGiveUpCallback(&OnGiveUp);
+  if (Knx.begin(Serial, P_ADDR(1, 1, 1)) != KNX_DEVICE_OK) {
+    fprintf(stderr, "begin() failed\n");
+    exit(1);
+  }
+  memset(&stats, 0, sizeof(stats));
+  stats.emulator = &emulator;
+  stats.mode = mode;
+  stats.failurePct = failurePct;
+  emulator.ClearStats();
+  emulator.SetFrameCallback(&OnFrame, NULL);
+  ScheduleFailure();
+
+  uint64_t startNs = HostClock::NowNs() + 10000000ULL, nextWriteNs = startNs;
+  uint64_t endNs = startNs + WRITES_NB * WRITE_PERIOD_NS;
+  uint64_t injectNs = trafficRate ? startNs : endNs;
+  byte frame[HOST_TPUART_FRAME_MAX_SIZE];
+  byte value = 0;
+  while (HostClock::NowNs() < endNs) {
+    if (HostClock::NowNs() >= injectNs) { // traffic of the other devices, random gaps around the mean rate
+      emulator.InjectFrame(frame, BuildGroupWrite(frame, G_ADDR(2, 0, 1 + Random(200)), (byte) Random(2)), injectNs);
+      injectNs += (1 + Random(2000)) * 1000000ULL / trafficRate;
+    }
+    if ((HostClock::NowNs() >= nextWriteNs) && (value < WRITES_NB)) {
+      stats.writeNs[value] = HostClock::NowNs();
+      Knx.write(0, (unsigned int) value++);
+      nextWriteNs += WRITE_PERIOD_NS;
+    }
+    uint64_t deadlineNs = Knx.task() * 1000ULL;
+    HostClock::Advance(TASK_COST_NS);
+    if (deadlineNs > TASK_COST_NS) { // the sketch sleeps till the deadline or the next write
+      uint64_t wakeUpNs = HostClock::NowNs() - TASK_COST_NS + deadlineNs;
+      if (wakeUpNs > nextWriteNs) wakeUpNs = nextWriteNs;
+      if (wakeUpNs > injectNs) wakeUpNs = injectNs;
+      if (wakeUpNs > HostClock::NowNs()) HostClock::AdvanceTo(wakeUpNs);
+    }
+  }
+  while (!emulator.IsBusIdle()) { // the last frames end
+    Knx.task();
+    HostClock::Advance(TASK_COST_NS);
+  }
+  emulator.SetFrameCallback(NULL, NULL);
+  emulator.NackNextFrames(0);
+  emulator.DropNextConfirms(0);
+
+  unsigned long deliveredNb = 0, givenUpNb = 0, lostNb = 0;
+  for (byte i = 0; i < WRITES_NB; i++) {
+    if (stats.delivered[i]) deliveredNb++;
+    else if (stats.givenUp[i]) givenUpNb++;
+    else lostNb++;
+  }
+  type_tpuart_confirm_timing timing;
+  Knx.getTxConfirmTiming(timing);
+  printf("{\"attempts\": %u, \"mode\": \"%s\", \"failure_pct\": %lu, \"traffic_rate\": %lu, \"writes\": %u, "
+         "\"delivered\": %lu, \"given_up\": %lu, \"lost\": %lu, \"frames\": %lu, \"delivery_avg_ms\": %.1f, "
+         "\"delivery_max_ms\": %.1f, \"confirm_delay_ms\": %.1f, \"confirm_deviation_ms\": %.1f, "
+         "\"confirm_timeout_ms\": %u, \"timeouts\": %u, \"late_confirms\": %u}\n",
+         attemptsMax, (mode == FAIL_NACK) ? "nack" : "drop", failurePct, trafficRate, WRITES_NB, deliveredNb, givenUpNb,
+         lostNb, stats.framesNb, deliveredNb ? stats.delaySumNs / 1e6 / deliveredNb : 0.0, stats.delayMaxNs / 1e6,
+         timing.delayMeanX8 / 8.0, timing.delayDeviationX8 / 8.0, timing.timeoutMillis, timing.timeoutsNb,
+         timing.lateConfirmsNb);
+  Knx.end();
+}
+
+int main(int argc, char *argv[])
+{
+  static const byte defaultAttempts[] = { 1, 4 };
+  static const unsigned long failurePcts[] = { 0, 10, 30, 60 };
+  TpUartEmulator emulator(Serial);
+  unsigned long trafficRate = 0;
+  int arg = 1;
+
+  if ((argc > 2) && !strcmp(argv[1], "-b")) {
+    trafficRate = strtoul(argv[2], NULL, 10);
+    arg = 3;
+  }
+  size_t attemptsNb = (argc > arg) ? argc - arg : sizeof(defaultAttempts);
+  for (size_t a = 0; a < attemptsNb; a++) {
+    byte attemptsMax = (argc > arg) ? (byte) strtoul(argv[arg + a], NULL, 10) : defaultAttempts[a];
+    for (int mode = FAIL_NACK; mode <= FAIL_DROP; mode++)
+      for (size_t p = 0; p < sizeof(failurePcts) / sizeof(failurePcts[0]); p++)
+        Run(emulator, attemptsMax, (FailureMode) mode, failurePcts[p], trafficRate);
+  }
+  return 0;
+}